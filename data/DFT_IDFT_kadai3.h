@@ -1,49 +1,430 @@
+#ifndef DFT_IDFT_KADAI3_H
+#define DFT_IDFT_KADAI3_H
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
 
-void DFT(int size, double *xr, double *xi) // 離散フーリエ変換（DFT）関数
+#include "trace.h" // 段階ごとの計時
+
+// FFTの計画（プラン）構造体
+// 回転因子・ビット反転テーブル・作業バッファを最初に一度だけ確保し，同じ長さの変換で使い回す
+// 2のべき乗長は基数2のFFT，それ以外の長さ（例: 320）はBluestein法で2のべき乗FFTに帰着させる
+typedef struct
+{
+    int size;          // 変換長
+    int m;             // 内部FFT長（2のべき乗）
+    int *bitrev;       // ビット反転テーブル（長さm）
+    double *wr, *wi;   // 回転因子 exp(-2πik/m)（長さm/2）
+    double *cr, *ci;   // Bluestein法のチャープ exp(-πin²/size)（長さsize, 2のべき乗のときNULL）
+    double *br, *bi;   // チャープフィルタのFFT（長さm）
+    double *tr, *ti;   // 作業バッファ（長さm）
+} FFTPlan;
+
+// 基数2のFFT本体（長さp->m，inverseが非0なら逆変換．正規化はしない）
+void fft_radix2(const FFTPlan *p, double *xr, double *xi, int inverse)
 {
-    double *Xr = (double *)calloc(size, sizeof(double)); // 実部を格納する配列
-    double *Xi = (double *)calloc(size, sizeof(double)); // 虚部を格納する配列
+    int m = p->m;
 
-    for (int k = 0; k < size; ++k) // 各周波数成分
+    for (int i = 0; i < m; ++i) // ビット反転並べ替え
     {
-        for (int n = 0; n < size; ++n) // 各時間サンプル
+        int j = p->bitrev[i];
+        if (i < j)
+        {
+            double t = xr[i]; xr[i] = xr[j]; xr[j] = t;
+            t = xi[i]; xi[i] = xi[j]; xi[j] = t;
+        }
+    }
+
+    double sign = inverse ? -1.0 : 1.0;  // 逆変換では回転因子を共役にする
+    for (int len = 2; len <= m; len <<= 1) // バタフライの段
+    {
+        int half = len >> 1;
+        int step = m / len; // 回転因子テーブルの間隔
+        for (int i = 0; i < m; i += len)
+        {
+            for (int j = 0; j < half; ++j)
+            {
+                double wr = p->wr[j * step];
+                double wi = sign * p->wi[j * step];
+                int a = i + j, b = a + half;
+                double vr = xr[b] * wr - xi[b] * wi;
+                double vi = xr[b] * wi + xi[b] * wr;
+                xr[b] = xr[a] - vr;
+                xi[b] = xi[a] - vi;
+                xr[a] += vr;
+                xi[a] += vi;
+            }
+        }
+    }
+}
+
+// 長さsizeのFFTプランを作成する（失敗時はNULL）
+FFTPlan *fft_plan_create(int size)
+{
+    if (size <= 0)
+        return NULL;
+
+    FFTPlan *p = (FFTPlan *)calloc(1, sizeof(FFTPlan));
+    if (!p)
+        return NULL;
+    p->size = size;
+
+    int pow2 = (size & (size - 1)) == 0;
+    int m = 1, bits = 0;
+    int need = pow2 ? size : 2 * size - 1; // Bluestein法では2size-1以上の長さが必要
+    while (m < need)
+    {
+        m <<= 1;
+        ++bits;
+    }
+    p->m = m;
+
+    p->bitrev = (int *)malloc(sizeof(int) * m);
+    p->wr = (double *)malloc(sizeof(double) * (m / 2 + 1));
+    p->wi = (double *)malloc(sizeof(double) * (m / 2 + 1));
+    if (!p->bitrev || !p->wr || !p->wi)
+        goto fail;
+
+    for (int i = 0; i < m; ++i) // ビット反転テーブル
+    {
+        int r = 0;
+        for (int b = 0; b < bits; ++b)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        p->bitrev[i] = r;
+    }
+    for (int k = 0; k < m / 2; ++k) // 回転因子
+    {
+        double angle = 2.0 * M_PI * k / m;
+        p->wr[k] = cos(angle);
+        p->wi[k] = -sin(angle);
+    }
+
+    if (!pow2)
+    {
+        p->cr = (double *)malloc(sizeof(double) * size);
+        p->ci = (double *)malloc(sizeof(double) * size);
+        p->br = (double *)calloc(m, sizeof(double));
+        p->bi = (double *)calloc(m, sizeof(double));
+        p->tr = (double *)malloc(sizeof(double) * m);
+        p->ti = (double *)malloc(sizeof(double) * m);
+        if (!p->cr || !p->ci || !p->br || !p->bi || !p->tr || !p->ti)
+            goto fail;
+
+        for (int n = 0; n < size; ++n)
         {
-            double angle = 2.0 * M_PI * k * n / size;          // 位相角の計算
-            Xr[k] += xr[n] * cos(angle) + xi[n] * sin(angle);  // 実部の計算
-            Xi[k] += -xr[n] * sin(angle) + xi[n] * cos(angle); // 虚部の計算
+            // n²が大きくなると精度が落ちるので 2size を法として位相を計算
+            long long n2 = ((long long)n * n) % (2LL * size);
+            double angle = M_PI * n2 / size;
+            p->cr[n] = cos(angle);
+            p->ci[n] = -sin(angle);
         }
+
+        // チャープフィルタ b[n] = conj(c[n])（負のインデックスは末尾に折り返す）
+        p->br[0] = p->cr[0];
+        p->bi[0] = -p->ci[0];
+        for (int n = 1; n < size; ++n)
+        {
+            p->br[n] = p->br[m - n] = p->cr[n];
+            p->bi[n] = p->bi[m - n] = -p->ci[n];
+        }
+        fft_radix2(p, p->br, p->bi, 0);
     }
 
-    memcpy(xr, Xr, size * sizeof(double)); // 元の配列に結果をコピー
-    memcpy(xi, Xi, size * sizeof(double)); // 元の配列に結果をコピー
+    return p;
 
-    free(Xr); // メモリ解放
-    free(Xi); // メモリ解放
+fail:
+    free(p->bitrev);
+    free(p->wr);
+    free(p->wi);
+    free(p->cr);
+    free(p->ci);
+    free(p->br);
+    free(p->bi);
+    free(p->tr);
+    free(p->ti);
+    free(p);
+    return NULL;
 }
 
-void IDFT(int size, double *Xr, double *Xi) // 逆離散フーリエ変換（IDFT）関数
+// プランを破棄する
+void fft_plan_destroy(FFTPlan *p)
 {
-    double *xr = (double *)calloc(size, sizeof(double)); // 実部を格納する配列
-    double *xi = (double *)calloc(size, sizeof(double)); // 虚部を格納する配列
+    if (!p)
+        return;
+    free(p->bitrev);
+    free(p->wr);
+    free(p->wi);
+    free(p->cr);
+    free(p->ci);
+    free(p->br);
+    free(p->bi);
+    free(p->tr);
+    free(p->ti);
+    free(p);
+}
+
+// Bluestein法による任意長の順変換
+void fft_bluestein(FFTPlan *p, double *xr, double *xi)
+{
+    int size = p->size, m = p->m;
+    double *tr = p->tr, *ti = p->ti;
 
-    for (int n = 0; n < size; ++n) // 各時間サンプル
+    for (int n = 0; n < size; ++n) // 入力にチャープを掛ける
     {
-        for (int k = 0; k < size; ++k) // 各周波数成分
+        tr[n] = xr[n] * p->cr[n] - xi[n] * p->ci[n];
+        ti[n] = xr[n] * p->ci[n] + xi[n] * p->cr[n];
+    }
+    memset(tr + size, 0, sizeof(double) * (m - size));
+    memset(ti + size, 0, sizeof(double) * (m - size));
+
+    fft_radix2(p, tr, ti, 0);
+    for (int k = 0; k < m; ++k) // チャープフィルタとの畳み込み（周波数領域で積）
+    {
+        double r = tr[k] * p->br[k] - ti[k] * p->bi[k];
+        double i = tr[k] * p->bi[k] + ti[k] * p->br[k];
+        tr[k] = r;
+        ti[k] = i;
+    }
+    fft_radix2(p, tr, ti, 1);
+
+    double scale = 1.0 / m;
+    for (int k = 0; k < size; ++k) // 出力にチャープを掛ける
+    {
+        double r = tr[k] * scale, i = ti[k] * scale;
+        xr[k] = r * p->cr[k] - i * p->ci[k];
+        xi[k] = r * p->ci[k] + i * p->cr[k];
+    }
+}
+
+// プランを使った順変換（DFTと同じ in-place の呼び出し規約）
+void fft_forward(FFTPlan *p, double *xr, double *xi)
+{
+    TRACE_BEGIN(t);
+    if (p->cr)
+        fft_bluestein(p, xr, xi);
+    else
+        fft_radix2(p, xr, xi, 0);
+    TRACE_END(t, STAGE_FFT, p->size);
+}
+
+// プランを使った逆変換（IDFTと同じく1/sizeで正規化する）
+void fft_inverse(FFTPlan *p, double *xr, double *xi)
+{
+    TRACE_BEGIN(t);
+    int size = p->size;
+    if (p->cr)
+    {
+        // IDFT(X) = conj(DFT(conj(X))) / size
+        for (int k = 0; k < size; ++k)
+            xi[k] = -xi[k];
+        fft_bluestein(p, xr, xi);
+        for (int k = 0; k < size; ++k)
+            xi[k] = -xi[k];
+    }
+    else
+    {
+        fft_radix2(p, xr, xi, 1);
+    }
+
+    double scale = 1.0 / size;
+    for (int n = 0; n < size; ++n) // 正規化
+    {
+        xr[n] *= scale;
+        xi[n] *= scale;
+    }
+    TRACE_END(t, STAGE_IFFT, size);
+}
+
+// 実数入力用FFTプラン
+// 長さsizeの実信号を size/2 点の複素FFT1回で変換し，非負周波数の size/2+1 本のビンだけを出力する
+// （奇数長のときは通常の複素FFTで計算して前半だけを返す）
+typedef struct
+{
+    int size;          // 実信号の長さ
+    int bins;          // 出力ビン数 = size/2+1
+    FFTPlan *cplx;     // 内部の複素FFTプラン（偶数長: size/2点，奇数長: size点）
+    double *wr, *wi;   // 後処理用の回転因子 exp(-2πik/size)（偶数長のみ，長さsize/2）
+    double *zr, *zi;   // 作業バッファ（内部FFTの長さ）
+} RFFTPlan;
+
+// 長さsizeの実数FFTプランを作成する（失敗時はNULL）
+RFFTPlan *rfft_plan_create(int size)
+{
+    if (size <= 0)
+        return NULL;
+
+    RFFTPlan *p = (RFFTPlan *)calloc(1, sizeof(RFFTPlan));
+    if (!p)
+        return NULL;
+    p->size = size;
+    p->bins = size / 2 + 1;
+
+    int even = (size % 2 == 0);
+    int len = even ? size / 2 : size;
+    p->cplx = fft_plan_create(len);
+    p->zr = (double *)malloc(sizeof(double) * len);
+    p->zi = (double *)malloc(sizeof(double) * len);
+    if (even)
+    {
+        p->wr = (double *)malloc(sizeof(double) * len);
+        p->wi = (double *)malloc(sizeof(double) * len);
+    }
+    if (!p->cplx || !p->zr || !p->zi || (even && (!p->wr || !p->wi)))
+    {
+        fft_plan_destroy(p->cplx);
+        free(p->zr);
+        free(p->zi);
+        free(p->wr);
+        free(p->wi);
+        free(p);
+        return NULL;
+    }
+
+    for (int k = 0; even && k < len; ++k)
+    {
+        double angle = 2.0 * M_PI * k / size;
+        p->wr[k] = cos(angle);
+        p->wi[k] = -sin(angle);
+    }
+    return p;
+}
+
+// 実数FFTプランを破棄する
+void rfft_plan_destroy(RFFTPlan *p)
+{
+    if (!p)
+        return;
+    fft_plan_destroy(p->cplx);
+    free(p->zr);
+    free(p->zi);
+    free(p->wr);
+    free(p->wi);
+    free(p);
+}
+
+// 実信号x（長さsize）を変換し，Xr/Xi（長さsize/2+1）に非負周波数のスペクトルを書き込む
+void rfft_forward(RFFTPlan *p, const double *x, double *Xr, double *Xi)
+{
+    TRACE_BEGIN(t);
+    double *zr = p->zr, *zi = p->zi;
+
+    if (!p->wr) // 奇数長: 複素FFTで計算
+    {
+        memcpy(zr, x, sizeof(double) * p->size);
+        memset(zi, 0, sizeof(double) * p->size);
+        fft_forward(p->cplx, zr, zi);
+        memcpy(Xr, zr, sizeof(double) * p->bins);
+        memcpy(Xi, zi, sizeof(double) * p->bins);
+        TRACE_END(t, STAGE_FFT, p->size);
+        return;
+    }
+
+    int h = p->size / 2;
+    for (int n = 0; n < h; ++n) // 偶数番目を実部，奇数番目を虚部に詰める
+    {
+        zr[n] = x[2 * n];
+        zi[n] = x[2 * n + 1];
+    }
+    fft_forward(p->cplx, zr, zi);
+
+    for (int k = 0; k <= h; ++k)
+    {
+        int a = (k == h) ? 0 : k; // Z[h] = Z[0]
+        int b = (k == 0) ? 0 : h - k;
+        // 偶数列のスペクトル E = (Z[k] + conj(Z[h-k])) / 2
+        double er = 0.5 * (zr[a] + zr[b]);
+        double ei = 0.5 * (zi[a] - zi[b]);
+        // 奇数列のスペクトル O = (Z[k] - conj(Z[h-k])) / 2i
+        double or_ = 0.5 * (zi[a] + zi[b]);
+        double oi = -0.5 * (zr[a] - zr[b]);
+        // X[k] = E + W^k O
+        double wr = (k == h) ? -1.0 : p->wr[k];
+        double wi = (k == h) ? 0.0 : p->wi[k];
+        Xr[k] = er + or_ * wr - oi * wi;
+        Xi[k] = ei + or_ * wi + oi * wr;
+    }
+    TRACE_END(t, STAGE_FFT, p->size);
+}
+
+// 非負周波数のスペクトル Xr/Xi（長さsize/2+1）から実信号x（長さsize）を復元する（1/sizeで正規化）
+void rfft_inverse(RFFTPlan *p, const double *Xr, const double *Xi, double *x)
+{
+    TRACE_BEGIN(t);
+    double *zr = p->zr, *zi = p->zi;
+    int size = p->size;
+
+    if (!p->wr) // 奇数長: エルミート対称性で全ビンを復元して複素IFFT
+    {
+        for (int k = 0; k < p->bins; ++k)
+        {
+            zr[k] = Xr[k];
+            zi[k] = Xi[k];
+        }
+        for (int k = p->bins; k < size; ++k)
+        {
+            zr[k] = Xr[size - k];
+            zi[k] = -Xi[size - k];
+        }
+        fft_inverse(p->cplx, zr, zi);
+        memcpy(x, zr, sizeof(double) * size);
+        TRACE_END(t, STAGE_IFFT, size);
+        return;
+    }
+
+    int h = size / 2;
+    for (int k = 0; k < h; ++k)
+    {
+        int b = h - k;
+        // E = (X[k] + conj(X[h-k])) / 2
+        double er = 0.5 * (Xr[k] + Xr[b]);
+        double ei = 0.5 * (Xi[k] - Xi[b]);
+        // O = (X[k] - conj(X[h-k])) * conj(W^k) / 2
+        double dr = 0.5 * (Xr[k] - Xr[b]);
+        double di = 0.5 * (Xi[k] + Xi[b]);
+        double or_ = dr * p->wr[k] + di * p->wi[k];
+        double oi = di * p->wr[k] - dr * p->wi[k];
+        // Z = E + iO
+        zr[k] = er - oi;
+        zi[k] = ei + or_;
+    }
+    fft_inverse(p->cplx, zr, zi);
+
+    for (int n = 0; n < h; ++n) // 実部が偶数番目，虚部が奇数番目
+    {
+        x[2 * n] = zr[n];
+        x[2 * n + 1] = zi[n];
+    }
+    TRACE_END(t, STAGE_IFFT, size);
+}
+
+// DFT/IDFT用に直前の長さのプランを保持しておく（スレッドごとに使う場合はプランを直接作ること）
+static FFTPlan *dft_cached_plan = NULL;
+
+FFTPlan *dft_get_plan(int size)
+{
+    if (!dft_cached_plan || dft_cached_plan->size != size)
+    {
+        fft_plan_destroy(dft_cached_plan);
+        dft_cached_plan = fft_plan_create(size);
+        if (!dft_cached_plan)
         {
-            double angle = 2.0 * M_PI * k * n / size;         // 位相角の計算
-            xr[n] += Xr[k] * cos(angle) - Xi[k] * sin(angle); // 実部の計算
-            xi[n] += Xr[k] * sin(angle) + Xi[k] * cos(angle); // 虚部の計算
+            fprintf(stderr, "FFTプランの作成に失敗しました (size=%d)\n", size);
+            exit(1);
         }
-        xr[n] /= size; // 正規化
-        xi[n] /= size; // 正規化
     }
+    return dft_cached_plan;
+}
+
+void DFT(int size, double *xr, double *xi) // 離散フーリエ変換（DFT）関数
+{
+    fft_forward(dft_get_plan(size), xr, xi);
+}
+
+void IDFT(int size, double *Xr, double *Xi) // 逆離散フーリエ変換（IDFT）関数
+{
+    fft_inverse(dft_get_plan(size), Xr, Xi);
+}
 
-    memcpy(Xr, xr, size * sizeof(double)); // 元の配列に結果をコピー
-    memcpy(Xi, xi, size * sizeof(double)); // 元の配列に結果をコピー
-    free(xr);                              // メモリ解放
-    free(xi);                              // メモリ解放
-}
\ No newline at end of file
+#endif
@@ -0,0 +1,392 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "stft.h"   // 窓関数・実数FFT・スペクトログラム形式
+#include "out_io.h" // テキスト／バイナリ出力
+#include "result_cache.h" // 結果キャッシュ
+
+#define SAMPLE_RATE 16000   // サンプリング周波数 [Hz]
+#define FRAME_LENGTH 320    // フレーム長 = 20ms
+#define HOP 160             // フレームシフト = 10ms
+#define N 1024              // FFT点数
+#define CHUNK_FRAMES 256    // 長いファイルを分割するときの1タスクあたりのフレーム数
+#define MAX_PATH_LEN 1024
+#define OUTPUT_VERSION 1    // 出力の版（キャッシュのキーに入る．stft.h・out_io.h を含め出力が変わったら上げる）
+
+// 解析モード
+enum
+{
+    MODE_CENTER, // kadai4と同じく中央20msの対数パワースペクトルをテキストで出力
+    MODE_STFT    // 全フレームのスペクトログラムをバイナリで出力
+};
+
+typedef struct
+{
+    char in[MAX_PATH_LEN];  // 入力ファイル名
+    char out[MAX_PATH_LEN]; // 出力ファイル名
+    PCMData pcm;            // 入力（mmap，全タスクで共有）
+    long frames;            // フレーム数（MODE_STFT）
+    int out_fd;             // 出力ファイル（MODE_STFT，全タスクで共有）
+    int failed;             // エラーが起きたら1
+    uint64_t key;           // キャッシュのキー（入力標本＋解析パラメータ）
+    int cached;             // キャッシュから出力したら1
+} FileJob;
+
+typedef struct
+{
+    FileJob *file;
+    long first_frame; // このタスクが受け持つ最初のフレーム
+    long num_frames;  // 受け持つフレーム数
+} Task;
+
+// スレッド間で共有する作業キュー
+typedef struct
+{
+    Task *tasks;
+    int num_tasks;
+    int next; // 次に取り出すタスク
+    int mode;
+    int format; // MODE_CENTERの出力形式
+    pthread_mutex_t lock;
+} WorkQueue;
+
+// 各スレッドが専用に持つFFTプランと作業バッファ
+typedef struct
+{
+    WorkQueue *queue;
+    STFT *stft;
+    double *frame;  // 1フレーム分の標本
+    float *rows;    // 出力用（CHUNK_FRAMES × bins）
+} Worker;
+
+// 入力のフレーム数（stft_next_frameと同じく末尾の半端なフレームも数える）
+long count_frames(long total, int frame_length, int hop)
+{
+    if (total <= 0)
+        return 0;
+    if (total <= frame_length)
+        return 1;
+    return 1 + (total - frame_length + hop - 1) / hop;
+}
+
+// 中央20msのフレームを解析してkadai4と同じ形式で書き出す
+void run_center(Worker *w, FileJob *job)
+{
+    STFT *s = w->stft;
+    const PCMData *pcm = &job->pcm;
+
+    long start = pcm->length / 2 - FRAME_LENGTH / 2;
+    if (start < 0)
+        start = 0;
+    for (int i = 0; i < FRAME_LENGTH; ++i) // ファイル末尾を越えた分はゼロ詰め
+        w->frame[i] = start + i < pcm->length ? (double)pcm->samples[start + i] : 0.0;
+    stft_analyze(s, w->frame);
+
+    double freq_step = (double)SAMPLE_RATE / N / 1000.0; // kHz単位
+    if (out_write_series(job->out, w->queue->format, s->log_power, s->bins, 0.0, freq_step, 6, 6, ' ', "kHz", "dB") != 0)
+    {
+        perror(job->out);
+        job->failed = 1;
+    }
+}
+
+// 長いファイルの一部（連続するフレーム）を解析し，出力ファイルの該当位置に書き込む
+void run_stft_chunk(Worker *w, Task *t)
+{
+    STFT *s = w->stft;
+    FileJob *job = t->file;
+    const PCMData *pcm = &job->pcm;
+
+    for (long f = 0; f < t->num_frames; ++f)
+    {
+        long start = (t->first_frame + f) * HOP;
+        for (int n = 0; n < FRAME_LENGTH; ++n) // ファイル末尾を越えた分はゼロ詰め
+            w->frame[n] = start + n < pcm->length ? (double)pcm->samples[start + n] : 0.0;
+        stft_analyze(s, w->frame);
+
+        float *row = w->rows + f * s->bins;
+        for (int k = 0; k < s->bins; ++k)
+            row[k] = (float)s->log_power[k];
+    }
+
+    TRACE_BEGIN(tw);
+    size_t bytes = sizeof(float) * s->bins * t->num_frames;
+    off_t offset = sizeof(SpectrogramHeader) + (off_t)t->first_frame * s->bins * sizeof(float);
+    if (pwrite(job->out_fd, w->rows, bytes, offset) != (ssize_t)bytes)
+    {
+        perror(job->out);
+        job->failed = 1;
+    }
+    TRACE_END(tw, STAGE_WRITE, s->bins * t->num_frames);
+}
+
+void *worker_main(void *arg)
+{
+    Worker *w = (Worker *)arg;
+    WorkQueue *q = w->queue;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&q->lock);
+        int i = q->next < q->num_tasks ? q->next++ : -1;
+        pthread_mutex_unlock(&q->lock);
+        if (i < 0)
+            break;
+
+        if (q->mode == MODE_CENTER)
+            run_center(w, q->tasks[i].file);
+        else
+            run_stft_chunk(w, &q->tasks[i]);
+    }
+    return NULL;
+}
+
+// 出力ファイル名 = 出力ディレクトリ/入力ファイル名から.rawを除いたもの + 拡張子
+void make_output_name(char *out, size_t size, const char *outdir, const char *in, const char *ext)
+{
+    const char *base = strrchr(in, '/');
+    base = base ? base + 1 : in;
+    size_t len = strlen(base);
+    if (ends_with_raw(base))
+        len -= 4;
+    snprintf(out, size, "%s/%.*s%s", outdir, (int)len, base, ext);
+}
+
+int main(int argc, char *argv[])
+{
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    int mode = MODE_CENTER;
+    int format = OUT_TEXT;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    const char *outdir = NULL, *listfile = NULL, *cachedir = NULL;
+    long cache_max = CACHE_DEFAULT_MAX;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:j:o:f:F:C:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            if (strcmp(optarg, "center") == 0)
+                mode = MODE_CENTER;
+            else if (strcmp(optarg, "stft") == 0)
+                mode = MODE_STFT;
+            else
+                argc = 0;
+            break;
+        case 'j': threads = atoi(optarg); break;
+        case 'o': outdir = optarg; break;
+        case 'f': listfile = optarg; break;
+        case 'F':
+            if ((format = out_format_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        case 'C': cachedir = optarg; break;
+        case 'S': cache_max = (long)(atof(optarg) * (1 << 20)); break;
+        default: argc = 0;
+        }
+    }
+
+    if (!outdir || (optind >= argc && !listfile) || threads <= 0)
+    {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] -o <出力ディレクトリ> [-m center|stft] [-F txt|bin] [-j スレッド数] [-f ファイル一覧] [-C キャッシュディレクトリ [-S 上限MB]] [入力ファイル/ディレクトリ ...]\n", argv[0]);
+        return 1;
+    }
+
+    // 入力ファイルを集める
+    RawFileList inputs = {0};
+    if (listfile)
+    {
+        FILE *fp = fopen(listfile, "r");
+        if (!fp)
+        {
+            perror(listfile);
+            return 1;
+        }
+        char line[MAX_PATH_LEN];
+        while (fgets(line, sizeof(line), fp))
+        {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] != '\0')
+                raw_list_collect(&inputs, line);
+        }
+        fclose(fp);
+    }
+    for (int i = optind; i < argc; ++i)
+        raw_list_collect(&inputs, argv[i]);
+    char **paths = inputs.paths;
+    int num_files = inputs.count;
+
+    if (num_files == 0)
+    {
+        fprintf(stderr, "入力ファイルがありません\n");
+        return 1;
+    }
+    mkdir(outdir, 0755);
+
+    // 同じ入力・同じパラメータの結果はキャッシュから出す
+    ResultCache *cache = NULL;
+    char params[256];
+    if (cachedir)
+    {
+        if (!(cache = cache_open(cachedir, cache_max)))
+        {
+            perror(cachedir);
+            return 1;
+        }
+        snprintf(params, sizeof(params), "batch_spec;v=%d;mode=%s;fmt=%s;fs=%d;L=%d;hop=%d;N=%d;win=hamming",
+                 OUTPUT_VERSION, mode == MODE_CENTER ? "center" : "stft", format == OUT_TEXT ? "txt" : "bin",
+                 SAMPLE_RATE, FRAME_LENGTH, HOP, N);
+    }
+
+    // ファイルごとのジョブと，フレーム単位に分割したタスクを作る
+    FileJob *jobs = (FileJob *)calloc(num_files, sizeof(FileJob));
+    int task_cap = num_files;
+    Task *tasks = (Task *)malloc(sizeof(Task) * task_cap);
+    int num_tasks = 0;
+    int bins = N / 2 + 1;
+    long total_samples = 0; // 実際に解析する標本数（キャッシュから出したものは含めない）
+
+    for (int i = 0; i < num_files; ++i)
+    {
+        FileJob *job = &jobs[i];
+        snprintf(job->in, sizeof(job->in), "%s", paths[i]);
+        make_output_name(job->out, sizeof(job->out), outdir, paths[i], mode == MODE_CENTER && format == OUT_TEXT ? ".txt" : ".bin");
+        job->out_fd = -1;
+
+        if (pcm_open(job->in, &job->pcm) != 0)
+        {
+            perror(job->in);
+            job->failed = 1;
+            continue;
+        }
+        if (cache)
+        {
+            CacheEntry e;
+            job->key = cache_key(job->pcm.samples, job->pcm.length, params);
+            if (cache_lookup(cache, job->key, &e))
+            {
+                if (cache_write_file(&e, job->out) != 0)
+                {
+                    perror(job->out);
+                    job->failed = 1;
+                }
+                cache_release(&e);
+                job->cached = 1;
+                continue;
+            }
+        }
+        total_samples += job->pcm.length;
+
+        long chunks = 1;
+        if (mode == MODE_STFT)
+        {
+            job->frames = count_frames(job->pcm.length, FRAME_LENGTH, HOP);
+            job->out_fd = open(job->out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if (job->out_fd < 0)
+            {
+                perror(job->out);
+                job->failed = 1;
+                continue;
+            }
+            SpectrogramHeader header;
+            memcpy(header.magic, SPECTROGRAM_MAGIC, 4);
+            header.sample_rate = SAMPLE_RATE;
+            header.frame_length = FRAME_LENGTH;
+            header.hop = HOP;
+            header.fft_size = N;
+            header.bins = bins;
+            header.frames = (int32_t)job->frames;
+            if (write(job->out_fd, &header, sizeof(header)) != (ssize_t)sizeof(header))
+            {
+                perror(job->out);
+                job->failed = 1;
+                continue;
+            }
+            chunks = (job->frames + CHUNK_FRAMES - 1) / CHUNK_FRAMES;
+        }
+
+        for (long c = 0; c < chunks; ++c)
+        {
+            if (num_tasks == task_cap)
+            {
+                task_cap *= 2;
+                tasks = (Task *)realloc(tasks, sizeof(Task) * task_cap);
+            }
+            Task *t = &tasks[num_tasks++];
+            t->file = job;
+            t->first_frame = c * CHUNK_FRAMES;
+            t->num_frames = job->frames - t->first_frame < CHUNK_FRAMES ? job->frames - t->first_frame : CHUNK_FRAMES;
+        }
+    }
+
+    WorkQueue queue = {tasks, num_tasks, 0, mode, format, PTHREAD_MUTEX_INITIALIZER};
+
+    if (threads > num_tasks)
+        threads = num_tasks > 0 ? num_tasks : 1;
+    Worker *workers = (Worker *)calloc(threads, sizeof(Worker));
+    pthread_t *tids = (pthread_t *)malloc(sizeof(pthread_t) * threads);
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    for (int i = 0; i < threads; ++i)
+    {
+        Worker *w = &workers[i];
+        w->queue = &queue;
+        w->stft = stft_create(FRAME_LENGTH, HOP, N, WINDOW_HAMMING);
+        w->frame = (double *)malloc(sizeof(double) * FRAME_LENGTH);
+        w->rows = (float *)malloc(sizeof(float) * CHUNK_FRAMES * bins);
+        if (!w->stft || !w->frame || !w->rows)
+        {
+            fprintf(stderr, "作業バッファの確保に失敗しました\n");
+            return 1;
+        }
+        pthread_create(&tids[i], NULL, worker_main, w);
+    }
+    for (int i = 0; i < threads; ++i)
+        pthread_join(tids[i], NULL);
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    int failed = 0;
+    for (int i = 0; i < num_files; ++i)
+    {
+        if (jobs[i].out_fd >= 0)
+            close(jobs[i].out_fd);
+        if (cache && jobs[i].pcm.samples && !jobs[i].cached && !jobs[i].failed &&
+            cache_store_file(cache, jobs[i].key, jobs[i].out) != 0)
+            perror(cachedir);
+        pcm_close(&jobs[i].pcm);
+        failed += jobs[i].failed;
+    }
+
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    printf("%d ファイル（%d タスク）を %d スレッドで処理しました: %.3f ms, %.1f 秒分の音声（実時間の %.0f 倍）\n",
+           num_files - failed, num_tasks, threads, elapsed * 1e3,
+           (double)total_samples / SAMPLE_RATE, (double)total_samples / SAMPLE_RATE / elapsed);
+    if (cache)
+    {
+        printf("キャッシュ: %ld ヒット, %ld ミス, %ld 件を追い出し\n", cache->hits, cache->misses, cache->evicted);
+        cache_close(cache);
+    }
+
+    for (int i = 0; i < threads; ++i)
+    {
+        stft_destroy(workers[i].stft);
+        free(workers[i].frame);
+        free(workers[i].rows);
+    }
+    raw_list_free(&inputs);
+    free(workers);
+    free(tids);
+    free(tasks);
+    free(jobs);
+    return failed ? 1 : 0;
+}
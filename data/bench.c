@@ -0,0 +1,814 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+// 計測対象のヘッダ内で行われる確保を数えるため，ヘッダより先に malloc 系を置き換える
+long bench_allocs = 0;
+
+void *bench_malloc(size_t n) { bench_allocs++; return malloc(n); }
+void *bench_calloc(size_t n, size_t m) { bench_allocs++; return calloc(n, m); }
+void *bench_realloc(void *p, size_t n) { bench_allocs++; return realloc(p, n); }
+void *bench_aligned_alloc(size_t a, size_t n) { bench_allocs++; return aligned_alloc(a, n); }
+
+#define malloc(n) bench_malloc(n)
+#define calloc(n, m) bench_calloc(n, m)
+#define realloc(p, n) bench_realloc(p, n)
+#define aligned_alloc(a, n) bench_aligned_alloc(a, n)
+
+#include "DFT_IDFT_kadai3.h"
+#include "stft.h"
+#include "fir_filter.h"
+#include "pcm_io.h"
+#include "pcm_gain.h"
+#include "out_io.h"
+#include "formant.h"
+#include "resample.h"
+#include "denoise.h"
+#include "tone.h"
+#include "sysid.h"
+#include "fingerprint.h"
+#include "vad.h"
+
+// DSPカーネルのベンチマーク
+// 各項目を一定時間くり返し，バッチごとの1回あたり時間の最小値から ns/標本 と 標本/秒 を求める．
+// 結果はタブ区切りで書き出せ（-w），保存済みの基準（-b）と比べて遅くなった項目を報告する．
+// 計測の前に，過去に壊れたことのある処理の結果も確かめる（失敗は劣化として数える）．
+
+#define MIN_SECONDS 0.2     // 1項目あたりの計測時間 [秒]
+#define BATCH_SECONDS 0.01  // 1バッチの目安 [秒]
+#define REGRESSION 0.10     // 既定の許容劣化率（10%）
+#define MAX_RESULTS 128
+
+typedef struct
+{
+    const char *name;
+    long samples;          // 1回あたりに処理する標本数
+    void (*run)(void *);   // 1回分の処理
+    void *ctx;
+} Kernel;
+
+typedef struct
+{
+    char name[64];
+    double ns_per_sample;
+    double samples_per_sec;
+    double allocs_per_iter;
+} Result;
+
+double now_sec(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+Result measure(const Kernel *k)
+{
+    k->run(k->ctx); // ウォームアップ（プランのキャッシュなどを作る）
+
+    // 1バッチの回数を決める
+    long reps = 1;
+    for (;;)
+    {
+        double t0 = now_sec();
+        for (long r = 0; r < reps; ++r)
+            k->run(k->ctx);
+        if (now_sec() - t0 >= BATCH_SECONDS || reps >= (1L << 30))
+            break;
+        reps *= 2;
+    }
+
+    double best = 1e300, start = now_sec();
+    long iters = 0, allocs0 = bench_allocs;
+    do
+    {
+        double t0 = now_sec();
+        for (long r = 0; r < reps; ++r)
+            k->run(k->ctx);
+        double per = (now_sec() - t0) / reps;
+        best = per < best ? per : best;
+        iters += reps;
+    } while (now_sec() - start < MIN_SECONDS);
+
+    Result res;
+    snprintf(res.name, sizeof(res.name), "%s", k->name);
+    res.ns_per_sample = best * 1e9 / k->samples;
+    res.samples_per_sec = k->samples / best;
+    res.allocs_per_iter = (double)(bench_allocs - allocs0) / iters;
+    return res;
+}
+
+// ---- 計測対象 ----
+
+// 旧実装の O(N²) DFT（比較用）
+void naive_dft(int size, double *xr, double *xi, double *Xr, double *Xi)
+{
+    for (int k = 0; k < size; ++k)
+    {
+        double sr = 0.0, si = 0.0;
+        for (int n = 0; n < size; ++n)
+        {
+            double angle = 2.0 * M_PI * k * n / size;
+            sr += xr[n] * cos(angle) + xi[n] * sin(angle);
+            si += -xr[n] * sin(angle) + xi[n] * cos(angle);
+        }
+        Xr[k] = sr;
+        Xi[k] = si;
+    }
+}
+
+typedef struct
+{
+    int size;
+    FFTPlan *plan;
+    RFFTPlan *rplan;
+    RFFTPlanLP *lplan;
+    double *src, *xr, *xi, *Xr, *Xi;
+    float *fsrc, *fXr, *fXi;
+    short *qsrc;
+    int *qXr, *qXi;
+} FFTCtx;
+
+void run_naive(void *p)
+{
+    FFTCtx *c = (FFTCtx *)p;
+    naive_dft(c->size, c->src, c->xi, c->Xr, c->Xi);
+}
+
+void run_fft_forward(void *p)
+{
+    FFTCtx *c = (FFTCtx *)p;
+    memcpy(c->xr, c->src, sizeof(double) * c->size);
+    memset(c->xi, 0, sizeof(double) * c->size);
+    fft_forward(c->plan, c->xr, c->xi);
+}
+
+void run_fft_inverse(void *p)
+{
+    FFTCtx *c = (FFTCtx *)p;
+    memcpy(c->xr, c->src, sizeof(double) * c->size);
+    memset(c->xi, 0, sizeof(double) * c->size);
+    fft_inverse(c->plan, c->xr, c->xi);
+}
+
+void run_rfft_forward(void *p)
+{
+    FFTCtx *c = (FFTCtx *)p;
+    rfft_forward(c->rplan, c->src, c->Xr, c->Xi);
+}
+
+void run_rfft_inverse(void *p)
+{
+    FFTCtx *c = (FFTCtx *)p;
+    rfft_inverse(c->rplan, c->Xr, c->Xi, c->xr);
+}
+
+void run_rfft_float(void *p)
+{
+    FFTCtx *c = (FFTCtx *)p;
+    rfft_float(c->lplan, c->fsrc, c->fXr, c->fXi);
+}
+
+void run_rfft_q15(void *p)
+{
+    FFTCtx *c = (FFTCtx *)p;
+    rfft_q15(c->lplan, c->qsrc, c->qXr, c->qXi);
+}
+
+void run_dft_wrapper(void *p)
+{
+    FFTCtx *c = (FFTCtx *)p;
+    memcpy(c->xr, c->src, sizeof(double) * c->size);
+    memset(c->xi, 0, sizeof(double) * c->size);
+    DFT(c->size, c->xr, c->xi);
+}
+
+typedef struct
+{
+    int length;
+    double *x, *w, *out;
+} WindowCtx;
+
+// kadai4 の apply_hamming_window と同じく毎回 cos を計算する
+void run_window_percall(void *p)
+{
+    WindowCtx *c = (WindowCtx *)p;
+    for (int n = 0; n < c->length; ++n)
+        c->out[n] = c->x[n] * (0.54 - 0.46 * cos(2.0 * M_PI * n / (c->length - 1)));
+}
+
+// 事前計算した係数を掛ける
+void run_window_table(void *p)
+{
+    WindowCtx *c = (WindowCtx *)p;
+    for (int n = 0; n < c->length; ++n)
+        c->out[n] = c->x[n] * c->w[n];
+}
+
+typedef struct
+{
+    int bins;
+    double *Xr, *Xi, *out;
+} LogPowerCtx;
+
+void run_log_power(void *p)
+{
+    LogPowerCtx *c = (LogPowerCtx *)p;
+    for (int k = 0; k < c->bins; ++k)
+        c->out[k] = 10.0 * log10(c->Xr[k] * c->Xr[k] + c->Xi[k] * c->Xi[k] + 1e-12);
+}
+
+typedef struct
+{
+    const short *samples;
+    long length;
+    STFT *stft;
+    double *frame;
+} STFTCtx;
+
+void run_stft(void *p)
+{
+    STFTCtx *c = (STFTCtx *)p;
+    STFT *s = c->stft;
+    for (long start = 0; start + s->frame_length <= c->length; start += s->hop)
+    {
+        for (int n = 0; n < s->frame_length; ++n)
+            c->frame[n] = c->samples[start + n];
+        stft_analyze(s, c->frame);
+    }
+}
+
+typedef struct
+{
+    const short *samples;
+    long length;
+    FormantTracker *tracker;
+    double *frame;
+} FormantCtx;
+
+void run_formant(void *p)
+{
+    FormantCtx *c = (FormantCtx *)p;
+    FormantFrame out;
+    for (long start = 0; start + 320 <= c->length; start += 160)
+    {
+        for (int n = 0; n < 320; ++n)
+            c->frame[n] = c->samples[start + n];
+        formant_analyze(c->tracker, c->frame, &out);
+    }
+}
+
+typedef struct
+{
+    const float *in;
+    long length;
+    int in_rate;
+    float *out;
+} ResampleCtx;
+
+void run_resample(void *p)
+{
+    ResampleCtx *c = (ResampleCtx *)p;
+    Resampler *r = resampler_create(c->in_rate, 16000, RESAMPLE_TAPS, WINDOW_HAMMING);
+    for (long i = 0; i < c->length; i += RESAMPLE_BLOCK)
+        resampler_process(r, c->in + i, c->length - i < RESAMPLE_BLOCK ? (int)(c->length - i) : RESAMPLE_BLOCK, c->out);
+    resampler_destroy(r);
+}
+
+typedef struct
+{
+    const short *samples;
+    long length;
+    ToneTracker *t;
+    float *out;
+} ToneCtx;
+
+void run_tone(void *p)
+{
+    ToneCtx *c = (ToneCtx *)p;
+    tone_process(c->t, c->samples, c->length, c->out);
+}
+
+typedef struct
+{
+    const short *samples;
+    long length;
+    CrossSpectrum *c;
+} XSpecCtx;
+
+void run_xspec(void *p)
+{
+    XSpecCtx *x = (XSpecCtx *)p;
+    xspec_push(x->c, x->samples, x->samples, x->length);
+}
+
+typedef struct
+{
+    const short *samples;
+    long length;
+    FPExtractor *e;
+    FPHash *hashes;
+    long cap;
+} FingerprintCtx;
+
+void run_fingerprint(void *p)
+{
+    FingerprintCtx *c = (FingerprintCtx *)p;
+    fp_extract(c->e, c->samples, c->length, &c->hashes, &c->cap);
+}
+
+typedef struct
+{
+    const short *samples;
+    long length;
+    Denoiser *d;
+    short *out;
+} DenoiseCtx;
+
+void run_denoise(void *p)
+{
+    DenoiseCtx *c = (DenoiseCtx *)p;
+    for (long i = 0; i + c->d->hop <= c->length; i += c->d->hop)
+        denoiser_process(c->d, c->samples + i, c->out);
+}
+
+typedef struct
+{
+    const short *samples;
+    long length;
+    FIRFilter *fir;
+    float *in, *out;
+} FIRCtx;
+
+void run_fir(void *p)
+{
+    FIRCtx *c = (FIRCtx *)p;
+    int B = c->fir->block;
+    for (long i = 0; i + B <= c->length; i += B)
+    {
+        pcm_to_float(c->samples + i, c->in, B);
+        fir_process_block(c->fir, c->in, c->out);
+    }
+}
+
+typedef struct
+{
+    const short *samples;
+    long length;
+    float *f;
+    short *s;
+} ConvCtx;
+
+void run_pcm_to_float(void *p)
+{
+    ConvCtx *c = (ConvCtx *)p;
+    pcm_to_float(c->samples, c->f, c->length);
+}
+
+void run_float_to_pcm(void *p)
+{
+    ConvCtx *c = (ConvCtx *)p;
+    float_to_pcm(c->f, c->s, c->length);
+}
+
+void run_gain(void *p)
+{
+    ConvCtx *c = (ConvCtx *)p;
+    pcm_apply_gain(c->samples, c->s, c->length, 30.0f);
+}
+
+void run_measure(void *p)
+{
+    ConvCtx *c = (ConvCtx *)p;
+    int peak;
+    double sum;
+    pcm_measure(c->samples, c->length, &peak, &sum);
+}
+
+// kadai1-convert と同じ "%.3f %d\n" を /dev/null へ
+void run_text_writer(void *p)
+{
+    ConvCtx *c = (ConvCtx *)p;
+    TextWriter *w = tw_open("/dev/null");
+    for (long i = 0; i < c->length; ++i)
+    {
+        tw_fixed(w, i * 1000.0 / 16000.0, 3);
+        tw_char(w, ' ');
+        tw_int(w, c->samples[i]);
+        tw_char(w, '\n');
+    }
+    tw_close(w);
+}
+
+void run_text_fprintf(void *p)
+{
+    ConvCtx *c = (ConvCtx *)p;
+    FILE *fp = fopen("/dev/null", "w");
+    for (long i = 0; i < c->length; ++i)
+        fprintf(fp, "%.3f %d\n", i * 1000.0 / 16000.0, c->samples[i]);
+    fclose(fp);
+}
+
+void run_column_writer(void *p)
+{
+    ConvCtx *c = (ConvCtx *)p;
+    ColumnWriter *w = col_open("/dev/null", c->length, 1, 0.0, 1000.0 / 16000.0, "ms", "sample");
+    pcm_to_float(c->samples, c->f, c->length);
+    col_write(w, c->f, c->length);
+    col_close(w);
+}
+
+// ---- 結果の確認 ----
+
+int report_check(const char *name, int ok, const char *detail)
+{
+    printf("%-28s %s  %s\n", name, ok ? "OK" : "NG", detail);
+    return !ok;
+}
+
+// 1秒のデジタル無音（-90 dB のフレーム）の後に発話の途中から始まる録音でも区間が見つかること
+// （雑音レベルの推定値の初期化に負の値を印として使っていたときは 0 区間になった）
+int check_vad_silent_lead(const PCMData *speech)
+{
+    const long lead = 16000, skip = 3000;
+    if (speech->length <= skip)
+        return report_check("vad_silent_lead", 1, "（入力が短いので省略）");
+    long length = lead + speech->length - skip;
+    short *x = (short *)calloc(length, sizeof(short));
+    memcpy(x + lead, speech->samples + skip, sizeof(short) * (speech->length - skip));
+
+    VADParams p;
+    VADSegment segs[8];
+    vad_default_params(&p, 16000);
+    int n = vad_segments(&p, x, length, segs, 8);
+    free(x);
+
+    char detail[128];
+    snprintf(detail, sizeof(detail), "%d 区間%s", n, n > 0 ? "" : "（1つ以上のはず）");
+    return report_check("vad_silent_lead", n > 0 && segs[0].start >= lead - p.head_frames * p.frame_length, detail);
+}
+
+// in_rate の正弦波（振幅1，freq [Hz]）を 16kHz に変換したときの利得 [dB]（前後 10% は除く）
+double resample_tone_gain(int in_rate, double freq)
+{
+    Resampler *r = resampler_create(in_rate, 16000, RESAMPLE_TAPS, WINDOW_HAMMING);
+    float *in = (float *)malloc(sizeof(float) * RESAMPLE_BLOCK);
+    float *out = (float *)malloc(sizeof(float) * resampler_max_output(r, RESAMPLE_BLOCK));
+    double sumsq = 0.0;
+    long count = 0, at = 0;
+    for (long pos = 0; pos < in_rate; pos += RESAMPLE_BLOCK) // 1秒分
+    {
+        int n = in_rate - pos < RESAMPLE_BLOCK ? (int)(in_rate - pos) : RESAMPLE_BLOCK;
+        for (int i = 0; i < n; ++i)
+            in[i] = (float)sin(2.0 * M_PI * freq * (pos + i) / in_rate);
+        long m = resampler_process(r, in, n, out);
+        for (long i = 0; i < m; ++i, ++at)
+            if (at >= 1600 && at < 14400)
+            {
+                sumsq += (double)out[i] * out[i];
+                count++;
+            }
+    }
+    resampler_destroy(r);
+    free(in);
+    free(out);
+    return 10.0 * log10(sumsq / (count > 0 ? count : 1) / 0.5 + 1e-30);
+}
+
+// 出力のナイキスト周波数（8kHz）のすぐ上の正弦波が折り返さないこと，通過域（1kHz）の利得が変わらないこと
+// （遮断周波数をナイキスト周波数の 0.92 倍の -6dB 点に置いていたときは 8.5kHz が -16.7dB しか落ちなかった）
+int check_resample_alias(void)
+{
+    const int rates[] = {48000, 44100};
+    const double tones[] = {8500.0, 9000.0};
+    int failed = 0;
+    for (int i = 0; i < 2; ++i)
+    {
+        double pass = resample_tone_gain(rates[i], 1000.0), worst = -1e300;
+        for (int k = 0; k < 2; ++k)
+        {
+            double g = resample_tone_gain(rates[i], tones[k]);
+            worst = g > worst ? g : worst;
+        }
+        char name[64], detail[128];
+        snprintf(name, sizeof(name), "resample_alias_%d", rates[i]);
+        snprintf(detail, sizeof(detail), "1kHz %+.2f dB, 8.5/9kHz 最大 %.1f dB（-40 dB 以下のはず）", pass, worst);
+        failed += report_check(name, fabs(pass) < 0.1 && worst < -40.0, detail);
+    }
+    return failed;
+}
+
+// ---- 結果の入出力 ----
+
+int load_results(const char *filename, Result *res, int max)
+{
+    FILE *fp = fopen(filename, "r");
+    if (!fp)
+        return -1;
+    char line[256];
+    int n = 0;
+    while (n < max && fgets(line, sizeof(line), fp))
+    {
+        if (line[0] == '#' || line[0] == '\n')
+            continue;
+        Result *r = &res[n];
+        if (sscanf(line, "%63s %lf %lf %lf", r->name, &r->ns_per_sample, &r->samples_per_sec, &r->allocs_per_iter) == 4)
+            n++;
+    }
+    fclose(fp);
+    return n;
+}
+
+int save_results(const char *filename, const Result *res, int n)
+{
+    FILE *fp = fopen(filename, "w");
+    if (!fp)
+        return -1;
+    fprintf(fp, "# name\tns_per_sample\tsamples_per_sec\tallocs_per_iter\n");
+    for (int i = 0; i < n; ++i)
+        fprintf(fp, "%s\t%.4f\t%.0f\t%.2f\n", res[i].name, res[i].ns_per_sample, res[i].samples_per_sec, res[i].allocs_per_iter);
+    return fclose(fp);
+}
+
+// 入力データ（見つからなければ乱数で代用する）
+void load_or_noise(const char *filename, long fallback, PCMData *pcm, short **noise)
+{
+    if (pcm_open(filename, pcm) == 0 && pcm->length > 0)
+        return;
+    fprintf(stderr, "%s が読めないので乱数で代用します\n", filename);
+    *noise = (short *)malloc(sizeof(short) * fallback);
+    for (long i = 0; i < fallback; ++i)
+        (*noise)[i] = (short)(rand() % 20000 - 10000);
+    memset(pcm, 0, sizeof(*pcm));
+    pcm->samples = *noise;
+    pcm->length = fallback;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *root = "..", *baseline = NULL, *output = NULL, *filter = NULL;
+    double tolerance = REGRESSION;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "d:b:w:t:k:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'd': root = optarg; break;
+        case 'b': baseline = optarg; break;
+        case 'w': output = optarg; break;
+        case 't': tolerance = atof(optarg) / 100.0; break;
+        case 'k': filter = optarg; break;
+        default:
+            fprintf(stderr, "使い方: %s [-d リポジトリのルート] [-k 項目名の一部] [-w 結果.tsv] [-b 基準.tsv] [-t 許容劣化率%%]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // 同梱データ
+    char path[1024];
+    PCMData noise_pcm, music_pcm, speech_pcm;
+    short *noise_buf = NULL, *music_buf = NULL, *speech_buf = NULL;
+    snprintf(path, sizeof(path), "%s/data/White_noise_16kHz16bit_mono.raw", root);
+    load_or_noise(path, 208000, &noise_pcm, &noise_buf);
+    snprintf(path, sizeof(path), "%s/data3/music1.raw", root);
+    load_or_noise(path, 240000, &music_pcm, &music_buf);
+    snprintf(path, sizeof(path), "%s/data/a00.raw", root);
+    load_or_noise(path, 8000, &speech_pcm, &speech_buf);
+
+    RawFileList vowels = {0};
+    snprintf(path, sizeof(path), "%s/data2", root);
+    raw_list_collect(&vowels, path);
+    long vowel_total = 0;
+    for (int i = 0; i < vowels.count; ++i)
+    {
+        PCMData v;
+        if (pcm_open(vowels.paths[i], &v) == 0)
+        {
+            vowel_total += v.length;
+            pcm_close(&v);
+        }
+    }
+    short *vowel_samples = (short *)malloc(sizeof(short) * (vowel_total > 0 ? vowel_total : 1));
+    long vowel_len = 0;
+    for (int i = 0; i < vowels.count; ++i) // data2 の全ファイルを連結する
+    {
+        PCMData v;
+        if (pcm_open(vowels.paths[i], &v) == 0)
+        {
+            long n = v.length < vowel_total - vowel_len ? v.length : vowel_total - vowel_len;
+            memcpy(vowel_samples + vowel_len, v.samples, sizeof(short) * n);
+            vowel_len += n;
+            pcm_close(&v);
+        }
+    }
+
+    Kernel kernels[MAX_RESULTS];
+    int nk = 0;
+
+    // DFT/IDFT
+    const int sizes[] = {320, 1024, 4096, 65536};
+    FFTCtx fft[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        FFTCtx *c = &fft[i];
+        int n = sizes[i];
+        c->size = n;
+        c->plan = fft_plan_create(n);
+        c->rplan = rfft_plan_create(n);
+        c->src = (double *)malloc(sizeof(double) * n);
+        c->xr = (double *)malloc(sizeof(double) * n);
+        c->xi = (double *)calloc(n, sizeof(double));
+        c->Xr = (double *)malloc(sizeof(double) * n);
+        c->Xi = (double *)malloc(sizeof(double) * n);
+        for (int j = 0; j < n; ++j)
+            c->src[j] = music_pcm.samples[j % music_pcm.length];
+        rfft_forward(c->rplan, c->src, c->Xr, c->Xi);
+        c->lplan = rfft_lp_plan_create(n); // 2のべき乗のときだけ
+        c->fsrc = (float *)malloc(sizeof(float) * n);
+        c->fXr = (float *)malloc(sizeof(float) * n);
+        c->fXi = (float *)malloc(sizeof(float) * n);
+        c->qsrc = (short *)malloc(sizeof(short) * n);
+        c->qXr = (int *)malloc(sizeof(int) * n);
+        c->qXi = (int *)malloc(sizeof(int) * n);
+        for (int j = 0; j < n; ++j)
+        {
+            c->fsrc[j] = (float)c->src[j];
+            c->qsrc[j] = (short)c->src[j];
+        }
+
+        static char names[4][8][32];
+        snprintf(names[i][0], 32, "fft_forward_%d", n);
+        snprintf(names[i][1], 32, "fft_inverse_%d", n);
+        snprintf(names[i][2], 32, "rfft_forward_%d", n);
+        snprintf(names[i][3], 32, "rfft_inverse_%d", n);
+        snprintf(names[i][4], 32, "dft_cached_%d", n);
+        snprintf(names[i][5], 32, "dft_naive_%d", n);
+        snprintf(names[i][6], 32, "rfft_float_%d", n);
+        snprintf(names[i][7], 32, "rfft_q15_%d", n);
+        kernels[nk++] = (Kernel){names[i][0], n, run_fft_forward, c};
+        kernels[nk++] = (Kernel){names[i][1], n, run_fft_inverse, c};
+        kernels[nk++] = (Kernel){names[i][2], n, run_rfft_forward, c};
+        kernels[nk++] = (Kernel){names[i][3], n, run_rfft_inverse, c};
+        kernels[nk++] = (Kernel){names[i][4], n, run_dft_wrapper, c};
+        if (c->lplan)
+        {
+            kernels[nk++] = (Kernel){names[i][6], n, run_rfft_float, c};
+            kernels[nk++] = (Kernel){names[i][7], n, run_rfft_q15, c};
+        }
+        if (n <= 1024) // O(N²) は小さいサイズだけ
+            kernels[nk++] = (Kernel){names[i][5], n, run_naive, c};
+    }
+
+    // 窓掛け・対数パワー
+    WindowCtx win = {320, NULL, NULL, NULL};
+    win.x = fft[0].src;
+    win.w = (double *)malloc(sizeof(double) * 320);
+    win.out = (double *)malloc(sizeof(double) * 320);
+    make_window(WINDOW_HAMMING, win.w, 320);
+    kernels[nk++] = (Kernel){"window_hamming_percall_320", 320, run_window_percall, &win};
+    kernels[nk++] = (Kernel){"window_hamming_table_320", 320, run_window_table, &win};
+
+    LogPowerCtx lp = {513, fft[1].Xr, fft[1].Xi, NULL};
+    lp.out = (double *)malloc(sizeof(double) * 513);
+    kernels[nk++] = (Kernel){"log_power_513", 513, run_log_power, &lp};
+
+    // STFT（data3/music1.raw 全体と data2 全体）
+    STFTCtx st_music = {music_pcm.samples, music_pcm.length, stft_create(320, 160, 1024, WINDOW_HAMMING), NULL};
+    st_music.frame = (double *)malloc(sizeof(double) * 320);
+    kernels[nk++] = (Kernel){"stft_music1", music_pcm.length, run_stft, &st_music};
+    STFTCtx st_vowel = {vowel_samples, vowel_len, stft_create(320, 160, 1024, WINDOW_HAMMING), NULL};
+    st_vowel.frame = (double *)malloc(sizeof(double) * 320);
+    if (vowel_len >= 320)
+        kernels[nk++] = (Kernel){"stft_data2", vowel_len, run_stft, &st_vowel};
+    STFTCtx st_float = st_music, st_q15 = st_music;
+    st_float.stft = stft_create(320, 160, 1024, WINDOW_HAMMING);
+    st_q15.stft = stft_create(320, 160, 1024, WINDOW_HAMMING);
+    stft_set_precision(st_float.stft, PRECISION_FLOAT);
+    stft_set_precision(st_q15.stft, PRECISION_Q15);
+    kernels[nk++] = (Kernel){"stft_music1_float", music_pcm.length, run_stft, &st_float};
+    kernels[nk++] = (Kernel){"stft_music1_q15", music_pcm.length, run_stft, &st_q15};
+
+    // LPCフォルマント・F0（data2 全体）
+    FormantCtx fm = {vowel_samples, vowel_len, formant_create(320, 18, 16000), NULL};
+    fm.frame = (double *)malloc(sizeof(double) * 320);
+    if (vowel_len >= 320)
+        kernels[nk++] = (Kernel){"formant_data2", vowel_len, run_formant, &fm};
+
+    // FIRフィルタ（kadai5の係数，White_noise）
+    const int orders[] = {50, 100, 1000, 1000};
+    const int methods[] = {FIR_DIRECT, FIR_FFT, FIR_DIRECT, FIR_FFT};
+    const char *fir_names[] = {"fir_direct_50", "fir_fft_100", "fir_direct_1000", "fir_fft_1000"};
+    FIRCtx fir[4];
+    for (int i = 0; i < 4; ++i)
+    {
+        int taps = orders[i] + 1;
+        double *h = (double *)malloc(sizeof(double) * taps);
+        for (int n = 0; n < taps; ++n)
+            h[n] = sinc_h(n, orders[i], 0.4);
+        fir[i].samples = noise_pcm.samples;
+        fir[i].length = noise_pcm.length;
+        fir[i].fir = fir_create(h, taps, methods[i], 0);
+        fir[i].in = (float *)malloc(sizeof(float) * fir[i].fir->block);
+        fir[i].out = (float *)malloc(sizeof(float) * fir[i].fir->block);
+        free(h);
+        long usable = noise_pcm.length / fir[i].fir->block * fir[i].fir->block;
+        kernels[nk++] = (Kernel){fir_names[i], usable, run_fir, &fir[i]};
+    }
+
+    // STFT 重畳加算の雑音除去（White_noise の先頭1秒で雑音PSDを推定）
+    DenoiseCtx dn = {noise_pcm.samples, noise_pcm.length, denoiser_create(DENOISE_FRAME, DENOISE_FRAME, DENOISE_WIENER, 2.0, -20.0), NULL};
+    dn.out = (short *)malloc(sizeof(short) * dn.d->hop);
+    denoiser_learn_noise(dn.d, noise_pcm.samples, noise_pcm.length < 16000 ? noise_pcm.length : 16000);
+    kernels[nk++] = (Kernel){"denoise_wiener_512", noise_pcm.length / dn.d->hop * dn.d->hop, run_denoise, &dn};
+
+    // 8周波数の Goertzel（1024標本ごと）とスライディング DFT（10msごと）
+    const double dtmf[8] = {697, 770, 852, 941, 1209, 1336, 1477, 1633};
+    ToneCtx tg = {noise_pcm.samples, noise_pcm.length, tone_create(TONE_GOERTZEL, dtmf, 8, 1024, 160, 16000), NULL};
+    ToneCtx ts = {noise_pcm.samples, noise_pcm.length, tone_create(TONE_SDFT, dtmf, 8, 1024, 160, 16000), NULL};
+    tg.out = (float *)malloc(sizeof(float) * 8 * tone_max_rows(ts.t, noise_pcm.length));
+    ts.out = tg.out;
+    kernels[nk++] = (Kernel){"goertzel_8tones", noise_pcm.length, run_tone, &tg};
+    kernels[nk++] = (Kernel){"sdft_8tones", noise_pcm.length, run_tone, &ts};
+
+    // 励振・応答のクロススペクトルのブロック平均（sysid，N=4096，ハン窓）
+    XSpecCtx xs = {noise_pcm.samples, noise_pcm.length, xspec_create(4096, WINDOW_HANN)};
+    kernels[nk++] = (Kernel){"xspec_4096", noise_pcm.length, run_xspec, &xs};
+
+    // 音の指紋（512点 STFT，ピーク検出，ピークの組のハッシュ）
+    FingerprintCtx fpc = {noise_pcm.samples, noise_pcm.length, fp_extractor_create(), NULL, 0};
+    kernels[nk++] = (Kernel){"fingerprint_extract", noise_pcm.length, run_fingerprint, &fpc};
+
+    // PCM変換とテキスト／バイナリ出力
+    ConvCtx conv = {noise_pcm.samples, noise_pcm.length, NULL, NULL};
+    conv.f = (float *)malloc(sizeof(float) * conv.length);
+    conv.s = (short *)malloc(sizeof(short) * conv.length);
+    pcm_to_float(conv.samples, conv.f, conv.length);
+    kernels[nk++] = (Kernel){"pcm_to_float", conv.length, run_pcm_to_float, &conv};
+
+    // 標本化周波数変換（White_noise を 48kHz / 44.1kHz の入力とみなす，1回ごとに変換器を作る）
+    ResampleCtx rs48 = {conv.f, conv.length, 48000, NULL}, rs44 = {conv.f, conv.length, 44100, NULL};
+    rs48.out = rs44.out = (float *)malloc(sizeof(float) * (RESAMPLE_BLOCK + 1));
+    kernels[nk++] = (Kernel){"resample_48k_16k", conv.length, run_resample, &rs48};
+    kernels[nk++] = (Kernel){"resample_44k1_16k", conv.length, run_resample, &rs44};
+    kernels[nk++] = (Kernel){"float_to_pcm", conv.length, run_float_to_pcm, &conv};
+    kernels[nk++] = (Kernel){"pcm_gain", conv.length, run_gain, &conv};
+    kernels[nk++] = (Kernel){"pcm_measure", conv.length, run_measure, &conv};
+    kernels[nk++] = (Kernel){"export_text_writer", conv.length, run_text_writer, &conv};
+    kernels[nk++] = (Kernel){"export_text_fprintf", conv.length, run_text_fprintf, &conv};
+    kernels[nk++] = (Kernel){"export_column_binary", conv.length, run_column_writer, &conv};
+
+    // 確認
+    int failures = 0;
+    failures += check_vad_silent_lead(&speech_pcm);
+    failures += check_resample_alias();
+    printf("\n");
+
+    // 計測
+    Result results[MAX_RESULTS], base[MAX_RESULTS];
+    int nb = 0;
+    if (baseline && (nb = load_results(baseline, base, MAX_RESULTS)) < 0)
+    {
+        perror(baseline);
+        return 1;
+    }
+
+    int nr = 0, regressions = 0;
+    printf("%-28s %12s %14s %10s %s\n", "kernel", "ns/sample", "samples/s", "allocs/it", baseline ? "vs baseline" : "");
+    for (int i = 0; i < nk; ++i)
+    {
+        if (filter && !strstr(kernels[i].name, filter))
+            continue;
+        Result r = measure(&kernels[i]);
+        results[nr++] = r;
+        printf("%-28s %12.3f %14.0f %10.2f", r.name, r.ns_per_sample, r.samples_per_sec, r.allocs_per_iter);
+
+        for (int j = 0; j < nb; ++j)
+        {
+            if (strcmp(base[j].name, r.name) != 0)
+                continue;
+            double change = r.ns_per_sample / base[j].ns_per_sample - 1.0;
+            int slower = change > tolerance;
+            int more_allocs = r.allocs_per_iter > base[j].allocs_per_iter + 0.01;
+            printf(" %+6.1f%%%s%s", change * 100.0, slower ? " REGRESSION" : "", more_allocs ? " ALLOCS" : "");
+            regressions += slower || more_allocs;
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    if (output && save_results(output, results, nr) != 0)
+    {
+        perror(output);
+        return 1;
+    }
+    if (baseline)
+        printf("\n基準との比較: %d 項目が劣化（許容 %.0f%%）\n", regressions, tolerance * 100.0);
+    if (failures)
+        printf("\n結果の確認: %d 項目が失敗\n", failures);
+
+    return regressions || failures ? 2 : 0;
+}
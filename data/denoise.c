@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "denoise.h" // STFT 重畳加算の雑音除去
+#include "pcm_io.h"  // rawファイルの読み込み
+#include "vad.h"     // 先頭の無音区間の検出
+
+#define SAMPLE_RATE 16000 // サンプリング周波数 [Hz]
+#define LEAD_MS 500       // 雑音ファイルがないとき，雑音を探す先頭の長さ [ms]
+#define MAX_SEGMENTS 16
+
+// 入力（先頭の読み込み済み部分 → 残りのストリーム）から最大 n 標本を読む
+typedef struct
+{
+    PCMStream *stream;
+    const short *lead; // 先読みした先頭部分
+    long lead_length, lead_pos;
+} Input;
+
+long input_read(Input *in, short *buf, long n)
+{
+    long got = 0;
+    if (in->lead_pos < in->lead_length)
+    {
+        got = in->lead_length - in->lead_pos < n ? in->lead_length - in->lead_pos : n;
+        memcpy(buf, in->lead + in->lead_pos, sizeof(short) * got);
+        in->lead_pos += got;
+    }
+    while (got < n)
+    {
+        size_t r = pcm_stream_read(in->stream, buf + got, n - got);
+        if (r == 0)
+            break;
+        got += (long)r;
+    }
+    return got;
+}
+
+int main(int argc, char *argv[])
+{
+    const char *noise_filename = NULL;
+    int method = DENOISE_WIENER;
+    int frame_length = DENOISE_FRAME, fft_size = 0;
+    int lead_ms = LEAD_MS;
+    double alpha = 2.0, floor_db = -20.0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "n:l:m:a:b:L:N:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': noise_filename = optarg; break;
+        case 'l': lead_ms = atoi(optarg); break;
+        case 'm':
+            if ((method = denoise_method_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        case 'a': alpha = atof(optarg); break;
+        case 'b': floor_db = atof(optarg); break;
+        case 'L': frame_length = atoi(optarg); break;
+        case 'N': fft_size = atoi(optarg); break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind != 2)
+    {
+        fprintf(stderr, "使い方: %s [-n 雑音ファイル.raw | -l 先頭の無音を探す長さ[ms]] [-m sub|wiener] [-a 減算係数] [-b ゲイン下限[dB]] [-L フレーム長] [-N FFT点数] <入力ファイル名.raw|-> <出力ファイル名.raw>\n", argv[0]);
+        return 1;
+    }
+    const char *input_filename = argv[optind];
+    const char *output_filename = argv[optind + 1];
+
+    Denoiser *d = denoiser_create(frame_length, fft_size ? fft_size : frame_length, method, alpha, floor_db);
+    if (!d)
+    {
+        fprintf(stderr, "パラメータが不正です（フレーム長は偶数，FFT点数はフレーム長以上）\n");
+        return 1;
+    }
+    int hop = d->hop;
+
+    Input in = {0};
+    if (!(in.stream = pcm_stream_open(input_filename)))
+    {
+        perror("入力ファイルが開けませんでした");
+        return 1;
+    }
+
+    // 雑音PSDの推定: 雑音ファイル，なければ入力の先頭の無音区間
+    short *lead = NULL;
+    if (noise_filename)
+    {
+        PCMData noise;
+        if (pcm_open(noise_filename, &noise) != 0)
+        {
+            perror("雑音ファイルが開けませんでした");
+            return 1;
+        }
+        denoiser_learn_noise(d, noise.samples, noise.length);
+        pcm_close(&noise);
+    }
+    else
+    {
+        long lead_cap = (long)SAMPLE_RATE * lead_ms / 1000;
+        if (!(lead = (short *)malloc(sizeof(short) * (lead_cap > 0 ? lead_cap : 1))))
+        {
+            perror("malloc");
+            return 1;
+        }
+        in.lead = lead;
+        in.lead_length = input_read(&in, lead, lead_cap);
+
+        // 先読みした範囲で最初の音声区間の手前までを雑音とみなす
+        VADParams vp;
+        VADSegment segs[MAX_SEGMENTS];
+        vad_default_params(&vp, SAMPLE_RATE);
+        long silence = vad_segments(&vp, lead, in.lead_length, segs, MAX_SEGMENTS) > 0 ? segs[0].start : in.lead_length;
+        if (silence < frame_length)
+        {
+            fprintf(stderr, "先頭に雑音だけの区間が見つかりません（-n で雑音ファイルを指定してください）\n");
+            return 1;
+        }
+        denoiser_learn_noise(d, lead, silence);
+        printf("先頭 %.0f ms を雑音として推定しました。\n", silence * 1000.0 / SAMPLE_RATE);
+    }
+    if (d->noise_frames == 0)
+    {
+        fprintf(stderr, "雑音が短すぎます（%d 標本以上必要です）\n", frame_length);
+        return 1;
+    }
+
+    FILE *out = fopen(output_filename, "wb");
+    if (!out)
+    {
+        perror("出力ファイルが開けませんでした");
+        return 1;
+    }
+
+    short *bin = (short *)malloc(sizeof(short) * hop);
+    short *bout = (short *)malloc(sizeof(short) * hop);
+    if (!bin || !bout)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    // hop 標本ずつ処理する．出力は frame_length - hop 標本遅れるので，
+    // その分を捨て，入力の終わりの後はゼロを入れて残りを押し出す（出力長 = 入力長）
+    long delay = frame_length - hop, total = 0, produced = 0;
+    int eof = 0;
+    while (!eof || produced - delay < total)
+    {
+        long n = eof ? 0 : input_read(&in, bin, hop);
+        if (n < hop)
+        {
+            memset(bin + n, 0, sizeof(short) * (hop - n));
+            eof = 1;
+        }
+        total += n;
+        denoiser_process(d, bin, bout);
+
+        long first = produced - delay; // bout[0] に対応する入力の標本番号
+        long from = first < 0 ? -first : 0;
+        long to = total - first < hop ? total - first : hop;
+        if (to > from)
+            fwrite(bout + from, sizeof(short), to - from, out);
+        produced += hop;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    printf("%s の雑音を除去して %s に出力しました（%s, %ld フレーム）。\n",
+           input_filename, output_filename, method == DENOISE_WIENER ? "Wiener" : "スペクトル減算", d->frames);
+    if (elapsed > 0)
+        printf("処理時間 %.3f ms（実時間の %.0f 倍）\n", elapsed * 1e3, (double)total / SAMPLE_RATE / elapsed);
+
+    fclose(out);
+    free(bin);
+    free(bout);
+    free(lead);
+    pcm_stream_close(in.stream);
+    denoiser_destroy(d);
+    return 0;
+}
+
+// 例:
+// ./denoise -n White_noise_16kHz16bit_mono.raw mix.raw mix_denoised.raw
+// ./denoise -m sub -a 2 -b -25 mix.raw mix_denoised.raw
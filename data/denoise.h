@@ -0,0 +1,204 @@
+#ifndef DENOISE_H
+#define DENOISE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "DFT_IDFT_kadai3.h" // 実数FFT/逆FFT
+#include "pcm_gain.h"        // float → int16 の飽和
+
+// STFT の重畳加算（overlap-add）による雑音除去
+// 雑音のパワースペクトル（PSD）を雑音だけの区間から推定しておき，
+// 各フレームのビンごとにゲインを掛けて逆FFTし，窓を掛けて重ね合わせる．
+// 分析・合成とも周期的ハン窓の平方根を使い，フレームシフトを窓長の半分にすると
+// 窓の2乗の和が1になるので，ゲインが全て1なら入力がそのまま（遅延 frame_length - hop 標本で）戻る．
+// 窓係数・FFTプラン・バッファは作成時に一度だけ確保し，全フレームで使い回す．
+
+#define DENOISE_FRAME 512 // 既定のフレーム長 = 32ms（16kHz）
+#define DENOISE_DD 0.98   // Wiener の事前SN比を決める decision-directed 法の平滑化係数
+
+// ゲインの決め方
+enum
+{
+    DENOISE_SUBTRACT, // パワースペクトル減算: G = sqrt(max(1 - α·N/|X|^2, β^2))
+    DENOISE_WIENER    // Wiener フィルタ: G = ξ/(1+ξ)，ξ は decision-directed 法で推定した事前SN比
+};
+
+// 手法名（"sub", "wiener"）を種類に変換する（不明なら-1）
+int denoise_method_from_name(const char *name)
+{
+    if (strcmp(name, "sub") == 0)
+        return DENOISE_SUBTRACT;
+    if (strcmp(name, "wiener") == 0)
+        return DENOISE_WIENER;
+    return -1;
+}
+
+typedef struct
+{
+    int frame_length; // フレーム長（窓長）[標本]
+    int hop;          // フレームシフト = frame_length/2
+    int fft_size;     // FFT点数（frame_length以上，超えた分はゼロ詰め）
+    int bins;         // fft_size/2+1
+    int method;
+    double alpha;     // 減算の過大係数（DENOISE_SUBTRACT）
+    double floor;     // ゲインの下限 β（音楽性雑音を抑える）
+
+    double *window;      // sqrt(周期的ハン窓)（長さframe_length）
+    double *history;     // 直近frame_length標本の入力
+    double *frame;       // FFT入出力（長さfft_size）
+    double *Xr, *Xi;     // スペクトル（長さbins）
+    double *ola;         // 重畳加算の途中結果（長さframe_length）
+    double *noise;       // 雑音PSD（長さbins）
+    double *clean;       // 直前のフレームのゲイン適用後のパワー（Wiener 用）
+    long noise_frames;   // 雑音PSDの推定に使ったフレーム数
+    long frames;         // 処理したフレーム数
+    RFFTPlan *plan;
+} Denoiser;
+
+void denoiser_destroy(Denoiser *d)
+{
+    if (!d)
+        return;
+    free(d->window);
+    free(d->history);
+    free(d->frame);
+    free(d->Xr);
+    free(d->Xi);
+    free(d->ola);
+    free(d->noise);
+    free(d->clean);
+    rfft_plan_destroy(d->plan);
+    free(d);
+}
+
+// フレーム長 frame_length（偶数），FFT点数 fft_size の雑音除去器を作る（失敗時はNULL）
+// floor_db はゲインの下限 [dB]（例: -20）
+Denoiser *denoiser_create(int frame_length, int fft_size, int method, double alpha, double floor_db)
+{
+    if (frame_length < 2 || frame_length % 2 != 0 || fft_size < frame_length || method < 0)
+        return NULL;
+
+    Denoiser *d = (Denoiser *)calloc(1, sizeof(Denoiser));
+    if (!d)
+        return NULL;
+    d->frame_length = frame_length;
+    d->hop = frame_length / 2;
+    d->fft_size = fft_size;
+    d->bins = fft_size / 2 + 1;
+    d->method = method;
+    d->alpha = alpha;
+    d->floor = pow(10.0, floor_db / 20.0);
+
+    d->window = (double *)malloc(sizeof(double) * frame_length);
+    d->history = (double *)calloc(frame_length, sizeof(double));
+    d->frame = (double *)calloc(fft_size, sizeof(double));
+    d->Xr = (double *)malloc(sizeof(double) * d->bins);
+    d->Xi = (double *)malloc(sizeof(double) * d->bins);
+    d->ola = (double *)calloc(frame_length, sizeof(double));
+    d->noise = (double *)calloc(d->bins, sizeof(double));
+    d->clean = (double *)calloc(d->bins, sizeof(double));
+    d->plan = rfft_plan_create(fft_size);
+    if (!d->window || !d->history || !d->frame || !d->Xr || !d->Xi || !d->ola || !d->noise || !d->clean || !d->plan)
+    {
+        denoiser_destroy(d);
+        return NULL;
+    }
+
+    for (int n = 0; n < frame_length; ++n)
+        d->window[n] = sqrt(0.5 - 0.5 * cos(2.0 * M_PI * n / frame_length));
+    return d;
+}
+
+// 窓を掛けた frame_length 標本 x を変換して Xr/Xi に入れる
+void denoiser_transform(Denoiser *d, const double *x)
+{
+    for (int n = 0; n < d->frame_length; ++n)
+        d->frame[n] = x[n] * d->window[n];
+    rfft_forward(d->plan, d->frame, d->Xr, d->Xi); // frame_length 以降は作成時のゼロのまま
+}
+
+// 雑音だけの標本列（length 標本）から雑音PSDを推定する（何度呼んでも平均に加わる）
+void denoiser_learn_noise(Denoiser *d, const short *x, long length)
+{
+    long total = d->noise_frames;
+    double *sum = d->clean; // 処理を始める前なので作業領域に使う
+    for (int k = 0; k < d->bins; ++k)
+        sum[k] = d->noise[k] * total;
+
+    double *buf = d->history;
+    for (long pos = 0; pos + d->frame_length <= length; pos += d->hop)
+    {
+        for (int n = 0; n < d->frame_length; ++n)
+            buf[n] = x[pos + n];
+        denoiser_transform(d, buf);
+        for (int k = 0; k < d->bins; ++k)
+            sum[k] += d->Xr[k] * d->Xr[k] + d->Xi[k] * d->Xi[k];
+        total++;
+    }
+
+    for (int k = 0; k < d->bins; ++k)
+    {
+        d->noise[k] = total > 0 ? sum[k] / total : 0.0;
+        d->clean[k] = 0.0;
+    }
+    memset(buf, 0, sizeof(double) * d->frame_length);
+    d->noise_frames = total;
+}
+
+// 1フレーム分のゲインを Xr/Xi に掛ける
+void denoiser_apply_gain(Denoiser *d)
+{
+    double floor2 = d->floor * d->floor;
+    for (int k = 0; k < d->bins; ++k)
+    {
+        double power = d->Xr[k] * d->Xr[k] + d->Xi[k] * d->Xi[k];
+        double noise = d->noise[k] > 1e-12 ? d->noise[k] : 1e-12;
+        double g;
+        if (d->method == DENOISE_SUBTRACT)
+        {
+            double g2 = power > 0.0 ? 1.0 - d->alpha * noise / power : 0.0;
+            g = sqrt(g2 > floor2 ? g2 : floor2);
+        }
+        else
+        {
+            double post = power / noise - 1.0; // 事後SN比 - 1
+            double xi = DENOISE_DD * d->clean[k] / noise + (1.0 - DENOISE_DD) * (post > 0.0 ? post : 0.0);
+            g = xi / (1.0 + xi);
+            if (g < d->floor)
+                g = d->floor;
+            d->clean[k] = g * g * power;
+        }
+        d->Xr[k] *= g;
+        d->Xi[k] *= g;
+    }
+}
+
+// 新しい hop 標本 in を入れ，雑音を除いた hop 標本を out に書き出す
+// 出力は入力より frame_length - hop 標本遅れる（最初の呼び出しの出力はその分の無音を含む）
+void denoiser_process(Denoiser *d, const short *in, short *out)
+{
+    int L = d->frame_length, hop = d->hop;
+
+    memmove(d->history, d->history + hop, sizeof(double) * (L - hop));
+    for (int n = 0; n < hop; ++n)
+        d->history[L - hop + n] = in[n];
+
+    denoiser_transform(d, d->history);
+    denoiser_apply_gain(d);
+    rfft_inverse(d->plan, d->Xr, d->Xi, d->frame);
+
+    for (int n = 0; n < L; ++n)
+        d->ola[n] += d->frame[n] * d->window[n];
+    for (int n = 0; n < hop; ++n)
+        out[n] = pcm_float_to_short((float)d->ola[n]);
+    memmove(d->ola, d->ola + hop, sizeof(double) * (L - hop));
+    memset(d->ola + L - hop, 0, sizeof(double) * hop);
+    for (int n = 0; n < d->fft_size - L; ++n) // 逆FFTで埋まったゼロ詰め部分を戻す
+        d->frame[L + n] = 0.0;
+    d->frames++;
+}
+
+#endif
@@ -0,0 +1,445 @@
+#ifndef FFT_PRECISION_H
+#define FFT_PRECISION_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "pcm_gain.h" // ベクトル型
+#include "trace.h"    // 段階ごとの計時
+
+// 単精度（float32）と Q15 固定小数点の FFT（2のべき乗長のみ）
+// double 版（DFT_IDFT_kadai3.h）と同じ基数2のアルゴリズムで，回転因子を段ごとに連続して並べ，
+// バタフライを8要素ずつベクトル演算する（double の2倍の幅，メモリ量は半分以下）．
+// Q15 版はブロック浮動小数点: 各段の前に最大振幅を調べ，桁あふれしうるときだけ全体を1/2にして指数を1増やす．
+// 真のスペクトル = 出力 × 2^指数．
+//
+// double との誤差（precision_report，1024点・ハミング窓・320標本フレーム，フレームのピークから60dB以内のビン）:
+//   float: 最大 0.001 dB 未満
+//   Q15:   二乗平均 0.05〜0.25 dB，最大 約2 dB（sin/cos/a00）．白色雑音ではスペクトルの深い谷で
+//          まれに十数dB ずれる（二乗平均は 0.04 dB）．レンジを40dBにすると最大 3 dB 程度
+// Q15 は32bitの積を使うので，整数の8要素乗算がない環境（SSE4.1/AVX2 なしの x86 など）では float より遅い．
+
+enum
+{
+    PRECISION_DOUBLE,
+    PRECISION_FLOAT,
+    PRECISION_Q15
+};
+
+// 精度名（"double", "float", "q15"）を種類に変換する（不明なら-1）
+int precision_from_name(const char *name)
+{
+    if (strcmp(name, "double") == 0)
+        return PRECISION_DOUBLE;
+    if (strcmp(name, "float") == 0)
+        return PRECISION_FLOAT;
+    if (strcmp(name, "q15") == 0)
+        return PRECISION_Q15;
+    return -1;
+}
+
+#define Q15_ONE 32767
+#define Q15_SAFE 13572 // これ以下なら1段のバタフライで桁あふれしない（13572 × (1 + √2) < 32768）
+
+typedef struct
+{
+    int size;         // 変換長（2のべき乗）
+    int *bitrev;      // ビット反転テーブル
+    float *wr, *wi;   // 回転因子（長さ len の段は [len/2, len) に exp(-2πij/len) を並べる）
+    short *qr, *qi;   // 同じ並びの Q15 回転因子
+} FFTPlanLP;
+
+void fft_lp_plan_destroy(FFTPlanLP *p)
+{
+    if (!p)
+        return;
+    free(p->bitrev);
+    free(p->wr);
+    free(p->wi);
+    free(p->qr);
+    free(p->qi);
+    free(p);
+}
+
+// 長さsizeのプランを作成する（2のべき乗でなければNULL）
+FFTPlanLP *fft_lp_plan_create(int size)
+{
+    if (size < 2 || (size & (size - 1)) != 0)
+        return NULL;
+
+    FFTPlanLP *p = (FFTPlanLP *)calloc(1, sizeof(FFTPlanLP));
+    if (!p)
+        return NULL;
+    p->size = size;
+    p->bitrev = (int *)malloc(sizeof(int) * size);
+    p->wr = (float *)malloc(sizeof(float) * size);
+    p->wi = (float *)malloc(sizeof(float) * size);
+    p->qr = (short *)malloc(sizeof(short) * size);
+    p->qi = (short *)malloc(sizeof(short) * size);
+    if (!p->bitrev || !p->wr || !p->wi || !p->qr || !p->qi)
+    {
+        fft_lp_plan_destroy(p);
+        return NULL;
+    }
+
+    int bits = 0;
+    while ((1 << bits) < size)
+        ++bits;
+    for (int i = 0; i < size; ++i)
+    {
+        int r = 0;
+        for (int b = 0; b < bits; ++b)
+            r |= ((i >> b) & 1) << (bits - 1 - b);
+        p->bitrev[i] = r;
+    }
+
+    for (int half = 1; half < size; half <<= 1)
+    {
+        for (int j = 0; j < half; ++j)
+        {
+            double angle = M_PI * j / half;
+            p->wr[half + j] = (float)cos(angle);
+            p->wi[half + j] = (float)-sin(angle);
+            p->qr[half + j] = (short)lrint(cos(angle) * Q15_ONE);
+            p->qi[half + j] = (short)lrint(-sin(angle) * Q15_ONE);
+        }
+    }
+    return p;
+}
+
+// 単精度FFT（inverseが非0なら逆変換．正規化はしない）
+void fft_float(const FFTPlanLP *p, float *xr, float *xi, int inverse)
+{
+    int m = p->size;
+
+    for (int i = 0; i < m; ++i) // ビット反転並べ替え
+    {
+        int j = p->bitrev[i];
+        if (i < j)
+        {
+            float t = xr[i]; xr[i] = xr[j]; xr[j] = t;
+            t = xi[i]; xi[i] = xi[j]; xi[j] = t;
+        }
+    }
+
+    float sign = inverse ? -1.0f : 1.0f;
+    for (int half = 1; half < m; half <<= 1)
+    {
+        const float *twr = p->wr + half, *twi = p->wi + half;
+        for (int i = 0; i < m; i += 2 * half)
+        {
+            float *ar = xr + i, *ai = xi + i, *br = ar + half, *bi = ai + half;
+            int j = 0;
+            for (; j + 8 <= half; j += 8) // 8要素ずつ
+            {
+                pcm_v8f wr, wi, xbr, xbi, xar, xai;
+                memcpy(&wr, twr + j, sizeof(wr));
+                memcpy(&wi, twi + j, sizeof(wi));
+                memcpy(&xbr, br + j, sizeof(xbr));
+                memcpy(&xbi, bi + j, sizeof(xbi));
+                memcpy(&xar, ar + j, sizeof(xar));
+                memcpy(&xai, ai + j, sizeof(xai));
+                wi *= sign;
+                pcm_v8f vr = xbr * wr - xbi * wi;
+                pcm_v8f vi = xbr * wi + xbi * wr;
+                pcm_v8f t;
+                t = xar - vr; memcpy(br + j, &t, sizeof(t));
+                t = xai - vi; memcpy(bi + j, &t, sizeof(t));
+                t = xar + vr; memcpy(ar + j, &t, sizeof(t));
+                t = xai + vi; memcpy(ai + j, &t, sizeof(t));
+            }
+            for (; j < half; ++j) // 最初の3段（half < 8）
+            {
+                float wr = twr[j], wi = sign * twi[j];
+                float vr = br[j] * wr - bi[j] * wi;
+                float vi = br[j] * wi + bi[j] * wr;
+                br[j] = ar[j] - vr;
+                bi[j] = ai[j] - vi;
+                ar[j] += vr;
+                ai[j] += vi;
+            }
+        }
+    }
+}
+
+// 成分の絶対値の最大値
+int q15_max_abs(const short *xr, const short *xi, int n)
+{
+    int max = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        int a = abs(xr[i]), b = abs(xi[i]);
+        max = a > max ? a : max;
+        max = b > max ? b : max;
+    }
+    return max;
+}
+
+// Q15 固定小数点の順変換（ブロック浮動小数点）．戻り値は指数（真の値 = 出力 × 2^指数）
+int fft_q15(const FFTPlanLP *p, short *xr, short *xi)
+{
+    int m = p->size, exponent = 0;
+
+    for (int i = 0; i < m; ++i) // ビット反転並べ替え
+    {
+        int j = p->bitrev[i];
+        if (i < j)
+        {
+            short t = xr[i]; xr[i] = xr[j]; xr[j] = t;
+            t = xi[i]; xi[i] = xi[j]; xi[j] = t;
+        }
+    }
+
+    // 小さい入力は先に左シフトして有効桁を確保する（指数は負になる）
+    int max = q15_max_abs(xr, xi, m);
+    int up = 0;
+    while (max > 0 && (max << (up + 1)) <= Q15_SAFE)
+        up++;
+    if (up > 0)
+    {
+        for (int i = 0; i < m; ++i)
+        {
+            xr[i] = (short)(xr[i] * (1 << up));
+            xi[i] = (short)(xi[i] * (1 << up));
+        }
+        max <<= up;
+        exponent = -up;
+    }
+
+    const pcm_v8i round = {1 << 14, 1 << 14, 1 << 14, 1 << 14, 1 << 14, 1 << 14, 1 << 14, 1 << 14};
+    for (int half = 1; half < m; half <<= 1)
+    {
+        int shift = 0; // この段の前に何回1/2にするか
+        while ((max >> shift) > Q15_SAFE)
+            shift++;
+        exponent += shift;
+        const int bias = shift ? 1 << (shift - 1) : 0;
+        const pcm_v8i vbias = {bias, bias, bias, bias, bias, bias, bias, bias};
+        const short *twr = p->qr + half, *twi = p->qi + half;
+        pcm_v8i vmax = {0};
+        int smax = 0;
+
+        for (int i = 0; i < m; i += 2 * half)
+        {
+            short *ar = xr + i, *ai = xi + i, *br = ar + half, *bi = ai + half;
+            int j = 0;
+            for (; j + 8 <= half; j += 8)
+            {
+                pcm_v8s s;
+                pcm_v8i wr, wi, xar, xai, xbr, xbi, v;
+#define Q15_LOAD(dst, src) (memcpy(&s, (src), sizeof(s)), (dst) = (__builtin_convertvector(s, pcm_v8i) + vbias) >> shift)
+#define Q15_STORE(dst, val) (v = (val), vmax |= (v ^ (v >> 31)), s = __builtin_convertvector(v, pcm_v8s), memcpy((dst), &s, sizeof(s)))
+                memcpy(&s, twr + j, sizeof(s));
+                wr = __builtin_convertvector(s, pcm_v8i);
+                memcpy(&s, twi + j, sizeof(s));
+                wi = __builtin_convertvector(s, pcm_v8i);
+                Q15_LOAD(xar, ar + j);
+                Q15_LOAD(xai, ai + j);
+                Q15_LOAD(xbr, br + j);
+                Q15_LOAD(xbi, bi + j);
+                pcm_v8i vr = (xbr * wr - xbi * wi + round) >> 15;
+                pcm_v8i vi = (xbr * wi + xbi * wr + round) >> 15;
+                Q15_STORE(ar + j, xar + vr);
+                Q15_STORE(ai + j, xai + vi);
+                Q15_STORE(br + j, xar - vr);
+                Q15_STORE(bi + j, xai - vi);
+#undef Q15_LOAD
+#undef Q15_STORE
+            }
+            for (; j < half; ++j)
+            {
+                int war = (ar[j] + bias) >> shift, wai = (ai[j] + bias) >> shift;
+                int wbr = (br[j] + bias) >> shift, wbi = (bi[j] + bias) >> shift;
+                int vr = (wbr * twr[j] - wbi * twi[j] + (1 << 14)) >> 15;
+                int vi = (wbr * twi[j] + wbi * twr[j] + (1 << 14)) >> 15;
+                ar[j] = (short)(war + vr);
+                ai[j] = (short)(wai + vi);
+                br[j] = (short)(war - vr);
+                bi[j] = (short)(wai - vi);
+                smax |= abs(war + vr) | abs(wai + vi) | abs(war - vr) | abs(wai - vi);
+            }
+        }
+
+        // 論理和は最大値の上界（最上位ビットが同じ）なので次の段の判定に使える
+        max = smax;
+        for (int k = 0; k < 8; ++k)
+            max |= vmax[k];
+    }
+    return exponent;
+}
+
+// 実数入力用プラン（double 版の RFFTPlan と同じく size/2 点の複素FFT1回で size/2+1 本のビンを求める）
+typedef struct
+{
+    int size, bins;
+    FFTPlanLP *cplx;    // size/2 点の複素FFT
+    float *wr, *wi;     // 後処理の回転因子 exp(-2πik/size)（長さ size/2）
+    short *qwr, *qwi;   // 同じく Q15
+    float *zr, *zi;     // 作業バッファ（長さ size/2）
+    short *qzr, *qzi;
+} RFFTPlanLP;
+
+void rfft_lp_plan_destroy(RFFTPlanLP *p)
+{
+    if (!p)
+        return;
+    fft_lp_plan_destroy(p->cplx);
+    free(p->wr);
+    free(p->wi);
+    free(p->qwr);
+    free(p->qwi);
+    free(p->zr);
+    free(p->zi);
+    free(p->qzr);
+    free(p->qzi);
+    free(p);
+}
+
+// 長さsize（4以上の2のべき乗）の実数FFTプランを作成する（失敗時はNULL）
+RFFTPlanLP *rfft_lp_plan_create(int size)
+{
+    if (size < 4 || (size & (size - 1)) != 0)
+        return NULL;
+    RFFTPlanLP *p = (RFFTPlanLP *)calloc(1, sizeof(RFFTPlanLP));
+    if (!p)
+        return NULL;
+    int h = size / 2;
+    p->size = size;
+    p->bins = h + 1;
+    p->cplx = fft_lp_plan_create(h);
+    p->wr = (float *)malloc(sizeof(float) * h);
+    p->wi = (float *)malloc(sizeof(float) * h);
+    p->qwr = (short *)malloc(sizeof(short) * h);
+    p->qwi = (short *)malloc(sizeof(short) * h);
+    p->zr = (float *)malloc(sizeof(float) * h);
+    p->zi = (float *)malloc(sizeof(float) * h);
+    p->qzr = (short *)malloc(sizeof(short) * h);
+    p->qzi = (short *)malloc(sizeof(short) * h);
+    if (!p->cplx || !p->wr || !p->wi || !p->qwr || !p->qwi || !p->zr || !p->zi || !p->qzr || !p->qzi)
+    {
+        rfft_lp_plan_destroy(p);
+        return NULL;
+    }
+    for (int k = 0; k < h; ++k)
+    {
+        double angle = 2.0 * M_PI * k / size;
+        p->wr[k] = (float)cos(angle);
+        p->wi[k] = (float)-sin(angle);
+        p->qwr[k] = (short)lrint(cos(angle) * Q15_ONE);
+        p->qwi[k] = (short)lrint(-sin(angle) * Q15_ONE);
+    }
+    return p;
+}
+
+// 実信号x（長さsize）の単精度FFT．Xr/Xi（長さsize/2+1）に非負周波数のスペクトルを書き込む
+void rfft_float(RFFTPlanLP *p, const float *x, float *Xr, float *Xi)
+{
+    TRACE_BEGIN(t);
+    int h = p->size / 2;
+    float *zr = p->zr, *zi = p->zi;
+    for (int n = 0; n < h; ++n) // 偶数番目を実部，奇数番目を虚部に詰める
+    {
+        zr[n] = x[2 * n];
+        zi[n] = x[2 * n + 1];
+    }
+    fft_float(p->cplx, zr, zi, 0);
+
+    for (int k = 0; k <= h; ++k)
+    {
+        int a = (k == h) ? 0 : k;
+        int b = (k == 0) ? 0 : h - k;
+        float er = 0.5f * (zr[a] + zr[b]);
+        float ei = 0.5f * (zi[a] - zi[b]);
+        float or_ = 0.5f * (zi[a] + zi[b]);
+        float oi = -0.5f * (zr[a] - zr[b]);
+        float wr = (k == h) ? -1.0f : p->wr[k];
+        float wi = (k == h) ? 0.0f : p->wi[k];
+        Xr[k] = er + or_ * wr - oi * wi;
+        Xi[k] = ei + or_ * wi + oi * wr;
+    }
+    TRACE_END(t, STAGE_FFT, p->size);
+}
+
+// 実信号x（長さsize，Q15）の固定小数点FFT．Xr/Xi は32bit整数で，戻り値は指数
+// 後処理は 2E + W・2O を64bitで計算するので，結果は内部FFTの指数より1小さい指数で表す
+int rfft_q15(RFFTPlanLP *p, const short *x, int *Xr, int *Xi)
+{
+    TRACE_BEGIN(t);
+    int h = p->size / 2;
+    short *zr = p->qzr, *zi = p->qzi;
+    for (int n = 0; n < h; ++n)
+    {
+        zr[n] = x[2 * n];
+        zi[n] = x[2 * n + 1];
+    }
+    int exponent = fft_q15(p->cplx, zr, zi);
+
+    for (int k = 0; k <= h; ++k)
+    {
+        int a = (k == h) ? 0 : k;
+        int b = (k == 0) ? 0 : h - k;
+        long long er = zr[a] + zr[b], ei = zi[a] - zi[b];
+        long long or_ = zi[a] + zi[b], oi = -(zr[a] - zr[b]);
+        long long wr = (k == h) ? -Q15_ONE : p->qwr[k];
+        long long wi = (k == h) ? 0 : p->qwi[k];
+        Xr[k] = (int)(er + ((or_ * wr - oi * wi + (1 << 14)) >> 15));
+        Xi[k] = (int)(ei + ((or_ * wi + oi * wr + (1 << 14)) >> 15));
+    }
+    TRACE_END(t, STAGE_FFT, p->size);
+    return exponent - 1;
+}
+
+// 窓係数（double）を float / Q15 に変換する
+void window_to_float(const double *w, float *out, int L)
+{
+    for (int n = 0; n < L; ++n)
+        out[n] = (float)w[n];
+}
+
+void window_to_q15(const double *w, short *out, int L)
+{
+    for (int n = 0; n < L; ++n)
+        out[n] = (short)lrint(w[n] * Q15_ONE);
+}
+
+// Q15: 窓を掛けた結果が16bitの範囲いっぱいになるように桁をそろえる．戻り値は指数（真の値 = 出力 × 2^指数）
+int window_apply_q15(const short *x, const short *w, short *out, int L)
+{
+    TRACE_BEGIN(t);
+    int max = 0;
+    for (int n = 0; n < L; ++n)
+    {
+        int v = abs(x[n] * w[n]);
+        max = v > max ? v : max;
+    }
+    int shift = 15; // 積（Q15）から取り除く桁数
+    while (shift > 0 && (max >> (shift - 1)) <= Q15_SAFE)
+        shift--;
+    int bias = shift ? 1 << (shift - 1) : 0;
+    for (int n = 0; n < L; ++n)
+        out[n] = (short)((x[n] * w[n] + bias) >> shift);
+    TRACE_END(t, STAGE_WINDOW, L);
+    return shift - 15;
+}
+
+// 対数パワースペクトル [dB]（double 版と同じく log(0) 回避に 1e-12 を加える）
+void log_power_float(const float *xr, const float *xi, double *out, int bins)
+{
+    TRACE_BEGIN(t);
+    for (int k = 0; k < bins; ++k)
+        out[k] = 10.0f * log10f(xr[k] * xr[k] + xi[k] * xi[k] + 1e-12f);
+    TRACE_END(t, STAGE_LOG_POWER, bins);
+}
+
+void log_power_q15(const int *xr, const int *xi, int exponent, double *out, int bins)
+{
+    TRACE_BEGIN(t);
+    double scale = ldexp(1.0, 2 * exponent);
+    for (int k = 0; k < bins; ++k)
+        out[k] = 10.0 * log10(((double)xr[k] * xr[k] + (double)xi[k] * xi[k]) * scale + 1e-12);
+    TRACE_END(t, STAGE_LOG_POWER, bins);
+}
+
+#endif
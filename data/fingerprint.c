@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#include "fingerprint.h" // スペクトルのピークによる指紋と転置索引
+#include "pcm_io.h"      // rawファイルの読み込み（mmap）・入力ファイルの一覧
+
+#define SAMPLE_RATE 16000 // サンプリング周波数 [Hz]
+#define MAX_PATH_LEN 1024
+#define MAX_MATCHES 16
+
+// 索引に入れる1ファイル
+typedef struct
+{
+    const char *path;
+    FPHash *hashes;
+    long count, cap;
+    long samples, frames;
+    int failed;
+} IndexJob;
+
+typedef struct
+{
+    IndexJob *jobs;
+    int num_jobs;
+    int next; // 次に取り出すジョブ
+    pthread_mutex_t lock;
+} JobQueue;
+
+// 各スレッドがファイルを1つずつ取り出して指紋を作る
+void *index_worker(void *arg)
+{
+    JobQueue *q = (JobQueue *)arg;
+    FPExtractor *e = fp_extractor_create();
+    for (;;)
+    {
+        pthread_mutex_lock(&q->lock);
+        int i = q->next < q->num_jobs ? q->next++ : -1;
+        pthread_mutex_unlock(&q->lock);
+        if (i < 0)
+            break;
+
+        IndexJob *job = &q->jobs[i];
+        PCMData pcm;
+        if (!e || pcm_open(job->path, &pcm) != 0)
+        {
+            perror(job->path);
+            job->failed = 1;
+            continue;
+        }
+        if (pcm.sample_rate != 0 && pcm.sample_rate != SAMPLE_RATE)
+        {
+            fprintf(stderr, "%s: 標本化周波数が %d Hz ではありません（%d Hz）\n", job->path, SAMPLE_RATE, pcm.sample_rate);
+            job->failed = 1;
+        }
+        else if ((job->count = fp_extract(e, pcm.samples, pcm.length, &job->hashes, &job->cap)) < 0)
+        {
+            perror("malloc");
+            job->failed = 1;
+        }
+        job->samples = pcm.length;
+        job->frames = fp_frame_count(pcm.length);
+        pcm_close(&pcm); // 読み終えたファイルはすぐに手放す
+    }
+    fp_extractor_destroy(e);
+    return NULL;
+}
+
+// 索引を作る（append なら既存の索引に追加する）
+int build_index(const char *index_filename, char **paths, int num_files, int threads, int append)
+{
+    // 追加なら既存の索引を読む（同じ名前のファイルは入れ直さない）
+    FPIndex old = {0};
+    int old_files = 0;
+    long old_entries = 0;
+    struct stat st;
+    if (append && stat(index_filename, &st) == 0)
+    {
+        if (fp_index_open(index_filename, &old) != 0)
+        {
+            perror(index_filename);
+            return 1;
+        }
+        old_files = old.header->files;
+        old_entries = (long)old.header->entries;
+    }
+
+    IndexJob *jobs = (IndexJob *)calloc(num_files > 0 ? num_files : 1, sizeof(IndexJob));
+    int num_jobs = 0;
+    for (int i = 0; i < num_files; ++i)
+    {
+        int known = 0;
+        for (int f = 0; f < old_files && !known; ++f)
+            known = strcmp(old.names[f], paths[i]) == 0;
+        if (known)
+            printf("%s は索引に入っているので飛ばします\n", paths[i]);
+        else
+            jobs[num_jobs++].path = paths[i];
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    JobQueue queue = {jobs, num_jobs, 0, PTHREAD_MUTEX_INITIALIZER};
+    if (threads > num_jobs)
+        threads = num_jobs > 0 ? num_jobs : 1;
+    pthread_t *tids = (pthread_t *)malloc(sizeof(pthread_t) * threads);
+    for (int i = 0; i < threads; ++i)
+        pthread_create(&tids[i], NULL, index_worker, &queue);
+    for (int i = 0; i < threads; ++i)
+        pthread_join(tids[i], NULL);
+
+    // 既存の分と新しいファイルの分を1つの列にして並べ直す
+    long entries = old_entries, total_samples = 0;
+    int files = old_files;
+    for (int i = 0; i < num_jobs; ++i)
+        if (!jobs[i].failed)
+        {
+            entries += jobs[i].count;
+            files++;
+        }
+    char **names = (char **)malloc(sizeof(char *) * (files > 0 ? files : 1));
+    int32_t *frames = (int32_t *)malloc(sizeof(int32_t) * (files > 0 ? files : 1));
+    uint32_t *hash = (uint32_t *)malloc(sizeof(uint32_t) * (entries > 0 ? entries : 1));
+    FPPosting *post = (FPPosting *)malloc(sizeof(FPPosting) * (entries > 0 ? entries : 1));
+    uint64_t *dir = (uint64_t *)malloc(sizeof(uint64_t) * (FP_DIR_SIZE + 1));
+    if (!names || !frames || !hash || !post || !dir)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    for (int f = 0; f < old_files; ++f)
+    {
+        names[f] = (char *)old.names[f];
+        frames[f] = old.frames[f];
+    }
+    if (old_entries > 0)
+    {
+        memcpy(hash, old.hash, sizeof(uint32_t) * old_entries);
+        memcpy(post, old.post, sizeof(FPPosting) * old_entries);
+    }
+    long at = old_entries;
+    int file = old_files;
+    for (int i = 0; i < num_jobs; ++i)
+    {
+        IndexJob *job = &jobs[i];
+        if (job->failed)
+            continue;
+        names[file] = (char *)job->path;
+        frames[file] = (int32_t)job->frames;
+        for (long j = 0; j < job->count; ++j, ++at)
+        {
+            hash[at] = job->hashes[j].hash;
+            post[at] = (FPPosting){(uint32_t)file, job->hashes[j].frame};
+        }
+        total_samples += job->samples;
+        file++;
+        free(job->hashes);
+        job->hashes = NULL;
+    }
+
+    if (fp_sort(hash, post, entries, dir) != 0)
+    {
+        perror("malloc");
+        return 1;
+    }
+    if (fp_index_write(index_filename, SAMPLE_RATE, names, frames, files, dir, hash, post, entries) != 0)
+    {
+        perror(index_filename);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    double hours = 0.0;
+    for (int f = 0; f < files; ++f)
+        hours += (double)frames[f] * FP_HOP / SAMPLE_RATE / 3600.0;
+    if (stat(index_filename, &st) != 0)
+        st.st_size = 0;
+    printf("%d ファイル（新規 %d）, %.2f 時間分, %ld ハッシュの索引を %s に書きました（%.1f MB）\n",
+           files, files - old_files, hours, entries, index_filename, st.st_size / (1024.0 * 1024.0));
+    if (elapsed > 0)
+        printf("%d スレッド, 処理時間 %.3f ms（実時間の %.0f 倍）\n", threads, elapsed * 1e3,
+               (double)total_samples / SAMPLE_RATE / elapsed);
+
+    int failed = num_jobs - (files - old_files);
+    free(names);
+    free(frames);
+    free(hash);
+    free(post);
+    free(dir);
+    free(tids);
+    free(jobs);
+    fp_index_close(&old);
+    return failed > 0;
+}
+
+// 切り出しの出どころを探す
+int query_index(const char *index_filename, char **paths, int num_files, int max_matches)
+{
+    FPIndex ix;
+    if (fp_index_open(index_filename, &ix) != 0)
+    {
+        perror(index_filename);
+        return 1;
+    }
+    if (ix.header->sample_rate != SAMPLE_RATE || ix.header->hop != FP_HOP)
+    {
+        fprintf(stderr, "%s: 索引のパラメータが違います\n", index_filename);
+        return 1;
+    }
+
+    FPExtractor *e = fp_extractor_create();
+    FPHash *hashes = NULL;
+    long cap = 0;
+    FPMatch matches[MAX_MATCHES];
+    double frame_sec = (double)FP_HOP / SAMPLE_RATE;
+    int failed = 0;
+    if (!e)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    for (int i = 0; i < num_files; ++i)
+    {
+        PCMData pcm;
+        if (pcm_open(paths[i], &pcm) != 0)
+        {
+            perror(paths[i]);
+            failed++;
+            continue;
+        }
+
+        struct timespec t0, t1;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        long used = 0, n = fp_extract(e, pcm.samples, pcm.length, &hashes, &cap);
+        int found = n >= 0 ? fp_query(&ix, hashes, n, matches, max_matches, &used) : -1;
+        clock_gettime(CLOCK_MONOTONIC, &t1);
+        pcm_close(&pcm);
+        if (found < 0)
+        {
+            perror("malloc");
+            return 1;
+        }
+
+        double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+        printf("%s: %ld ハッシュ, %ld 件の一致（%.3f ms）\n", paths[i], n, used, elapsed * 1e3);
+        if (found == 0)
+            printf("  見つかりませんでした\n");
+        for (int m = 0; m < found; ++m)
+            printf("  %d. %s %.3f 秒 （%ld 票）\n", m + 1, ix.names[matches[m].file], matches[m].offset * frame_sec, matches[m].votes);
+    }
+
+    free(hashes);
+    fp_extractor_destroy(e);
+    fp_index_close(&ix);
+    return failed > 0;
+}
+
+int main(int argc, char *argv[])
+{
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    const char *index_filename = NULL, *listfile = NULL;
+    int query = 0, append = 0, max_matches = 3;
+    int threads = (int)sysconf(_SC_NPROCESSORS_ONLN);
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:qak:j:f:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i': index_filename = optarg; break;
+        case 'q': query = 1; break;
+        case 'a': append = 1; break;
+        case 'k': max_matches = atoi(optarg); break;
+        case 'j': threads = atoi(optarg); break;
+        case 'f': listfile = optarg; break;
+        default: argc = 0;
+        }
+    }
+
+    if (!index_filename || (optind >= argc && !listfile) || threads <= 0 || max_matches <= 0 || max_matches > MAX_MATCHES)
+    {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] -i <索引ファイル> [-a] [-j スレッド数] [-f ファイル一覧] <入力ファイル/ディレクトリ ...>（索引を作る，-a は追加）\n"
+                        "       %s -i <索引ファイル> -q [-k 候補数] <切り出しファイル名.raw|-> ...（検索）\n",
+                argv[0], argv[0]);
+        return 1;
+    }
+
+    if (query)
+        return query_index(index_filename, argv + optind, argc - optind, max_matches);
+
+    // 入力ファイルを集める
+    RawFileList inputs = {0};
+    if (listfile)
+    {
+        FILE *fp = fopen(listfile, "r");
+        if (!fp)
+        {
+            perror(listfile);
+            return 1;
+        }
+        char line[MAX_PATH_LEN];
+        while (fgets(line, sizeof(line), fp))
+        {
+            line[strcspn(line, "\r\n")] = '\0';
+            if (line[0] != '\0')
+                raw_list_collect(&inputs, line);
+        }
+        fclose(fp);
+    }
+    for (int i = optind; i < argc; ++i)
+        raw_list_collect(&inputs, argv[i]);
+    if (inputs.count == 0)
+    {
+        fprintf(stderr, "入力ファイルがありません\n");
+        return 1;
+    }
+
+    int ret = build_index(index_filename, inputs.paths, inputs.count, threads, append);
+    raw_list_free(&inputs);
+    return ret;
+}
+
+// 例:
+// ./fingerprint -i music.fpi ../data3                       (data3 の .raw を並列に索引化)
+// ./fingerprint -i music.fpi -a new_recordings/             (追加)
+// ./fingerprint -i music.fpi -q clip.raw                    (切り出しの出どころ: ファイル名と時刻)
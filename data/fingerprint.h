@@ -0,0 +1,541 @@
+#ifndef FINGERPRINT_H
+#define FINGERPRINT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "stft.h" // 窓関数・実数FFT
+
+// スペクトルのピークによる音の指紋と転置索引
+// 1. STFT（512点・ハン窓・256標本シフト = 16ms）の対数パワーで，周囲 ±FP_PEAK_DT フレーム × ±FP_PEAK_DF ビンの
+//    最大値になっている点をピーク（星座点）とする
+// 2. 各ピーク（アンカー）と，その後 FP_ZONE_DT フレーム以内・±FP_ZONE_DF ビン以内のピーク FP_FANOUT 個を組にし，
+//    (f1, f2, Δt) を1つの FP_HASH_BITS（25）bitのハッシュにする．時刻はアンカーのフレーム番号
+// 3. 索引はハッシュ順に並べたハッシュ列と (ファイル, フレーム) の列．上位 FP_DIR_BITS ビットごとの先頭位置を
+//    ディレクトリに持ち，検索時は mmap してディレクトリ → 区間内の二分探索でたどる
+// 4. 検索では切り出し（クエリ）の各ハッシュの出現ごとに (ファイル, 索引のフレーム - クエリのフレーム) に1票入れ，
+//    最も票の多い組をその切り出しの出どころとする．同じ曲の同じ位置なら差が一定になるので票がそろう．
+//    偶然の一致でも1〜2票は入るので，FP_MIN_VOTES 票未満の候補は出さず，1位が2位の FP_MIN_MARGIN 倍に
+//    届かないときは（どれとも決められないので）見つからなかったことにする
+
+#define FP_FRAME 512        // フレーム長 = FFT点数 = 32ms（16kHz）
+#define FP_HOP 256          // フレームシフト = 16ms
+#define FP_BINS (FP_FRAME / 2 + 1)
+#define FP_MIN_BIN 4        // これより低いビン（〜125Hz）はピークにしない
+#define FP_PEAK_DT 6        // ピークの近傍（時間）[フレーム]
+#define FP_PEAK_DF 8       // ピークの近傍（周波数）[ビン]
+#define FP_MIN_DB 40.0      // これより小さいピークは無視する（16bit 標本のままの dB，振幅1の正弦波が約42dB）
+#define FP_PEAK_DB 15.0     // ピークはそのフレームの平均 [dB] よりこれだけ大きいこと（雑音の山を除く）
+#define FP_FANOUT 5         // 1つのアンカーから作る組の数
+#define FP_ZONE_DT 63       // 組にする相手の時間範囲 [フレーム]（7bit に収める）
+#define FP_ZONE_DF 64       // 組にする相手の周波数範囲 [ビン]
+#define FP_HASH_BITS 25     // ハッシュのビット数: f1(9) | f2(9) | Δt(7)
+#define FP_DIR_BITS 16      // ディレクトリのビット数（ハッシュの上位）
+#define FP_MAX_POSTINGS 20000 // これより多く出現するハッシュは検索で使わない（どこにでもある音）
+#define FP_MIN_VOTES 4      // 候補として出すのに必要な票数
+#define FP_MIN_MARGIN 2.0   // 1位の票は2位の票のこの倍以上あること
+
+#define FP_INDEX_MAGIC "FPIX"
+#define FP_INDEX_VERSION 1
+
+typedef struct
+{
+    uint32_t hash;
+    uint32_t frame; // アンカーのフレーム番号
+} FPHash;
+
+typedef struct
+{
+    uint32_t file;
+    uint32_t frame;
+} FPPosting;
+
+// ---- 指紋の抽出 ----
+
+typedef struct
+{
+    int frame;
+    int bin;
+} FPPeak;
+
+typedef struct
+{
+    STFT *stft;
+    double *samples;  // 1フレーム分の標本
+    float *spec;      // 直近 2*FP_PEAK_DT+1 フレームの対数パワー（リング）
+    float *dilated;   // 同じフレームの周波数方向の近傍最大値（リング）
+    float *floor;     // 同じフレームのピークの下限 [dB]（リング）
+    FPPeak *peaks;
+    long num_peaks, peak_cap;
+} FPExtractor;
+
+void fp_extractor_destroy(FPExtractor *e)
+{
+    if (!e)
+        return;
+    stft_destroy(e->stft);
+    free(e->samples);
+    free(e->spec);
+    free(e->dilated);
+    free(e->floor);
+    free(e->peaks);
+    free(e);
+}
+
+FPExtractor *fp_extractor_create(void)
+{
+    FPExtractor *e = (FPExtractor *)calloc(1, sizeof(FPExtractor));
+    if (!e)
+        return NULL;
+    int ring = 2 * FP_PEAK_DT + 1;
+    e->stft = stft_create(FP_FRAME, FP_HOP, FP_FRAME, WINDOW_HANN);
+    e->samples = (double *)malloc(sizeof(double) * FP_FRAME);
+    e->spec = (float *)malloc(sizeof(float) * ring * FP_BINS);
+    e->dilated = (float *)malloc(sizeof(float) * ring * FP_BINS);
+    e->floor = (float *)malloc(sizeof(float) * ring);
+    if (!e->stft || !e->samples || !e->spec || !e->dilated || !e->floor)
+    {
+        fp_extractor_destroy(e);
+        return NULL;
+    }
+    return e;
+}
+
+// length 標本のフレーム数（最後の半端なフレームはゼロ詰めして数える）
+long fp_frame_count(long length)
+{
+    if (length <= 0)
+        return 0;
+    if (length <= FP_FRAME)
+        return 1;
+    return 1 + (length - FP_FRAME + FP_HOP - 1) / FP_HOP;
+}
+
+// フレーム c（frames フレーム中，c+FP_PEAK_DT まで解析済み）のピークを peaks に加える
+int fp_find_peaks(FPExtractor *e, long c, long frames)
+{
+    const int ring = 2 * FP_PEAK_DT + 1;
+    long from = c - FP_PEAK_DT > 0 ? c - FP_PEAK_DT : 0;
+    long to = c + FP_PEAK_DT < frames - 1 ? c + FP_PEAK_DT : frames - 1;
+    const float *row = e->spec + (c % ring) * FP_BINS;
+    float floor = e->floor[c % ring];
+    for (int k = FP_MIN_BIN; k < FP_BINS; ++k)
+    {
+        float v = row[k];
+        if (v < floor)
+            continue;
+        int peak = 1;
+        for (long t = from; t <= to && peak; ++t)
+            peak = e->dilated[(t % ring) * FP_BINS + k] <= v;
+        if (!peak)
+            continue;
+        if (e->num_peaks == e->peak_cap)
+        {
+            long cap = e->peak_cap ? e->peak_cap * 2 : 1024;
+            FPPeak *p = (FPPeak *)realloc(e->peaks, sizeof(FPPeak) * cap);
+            if (!p)
+                return -1;
+            e->peaks = p;
+            e->peak_cap = cap;
+        }
+        e->peaks[e->num_peaks++] = (FPPeak){(int)c, k};
+    }
+    return 0;
+}
+
+// 標本列の指紋（ハッシュ）を *out（realloc で伸ばす，容量 *cap）に書き，個数を返す（失敗なら-1）
+long fp_extract(FPExtractor *e, const short *samples, long length, FPHash **out, long *cap)
+{
+    const int ring = 2 * FP_PEAK_DT + 1;
+    long frames = fp_frame_count(length);
+    e->num_peaks = 0;
+
+    // ピーク: フレーム f を解析したら，近傍がそろったフレーム f - FP_PEAK_DT を調べる
+    for (long f = 0; f < frames + FP_PEAK_DT; ++f)
+    {
+        if (f < frames)
+        {
+            long start = f * FP_HOP;
+            for (int n = 0; n < FP_FRAME; ++n) // ファイル末尾を越えた分はゼロ詰め
+                e->samples[n] = start + n < length ? (double)samples[start + n] : 0.0;
+            stft_analyze(e->stft, e->samples);
+
+            float *row = e->spec + (f % ring) * FP_BINS;
+            float *dil = e->dilated + (f % ring) * FP_BINS;
+            double mean = 0.0;
+            for (int k = 0; k < FP_BINS; ++k)
+            {
+                row[k] = (float)e->stft->log_power[k];
+                mean += row[k];
+            }
+            mean = mean / FP_BINS + FP_PEAK_DB;
+            e->floor[f % ring] = (float)(mean > FP_MIN_DB ? mean : FP_MIN_DB);
+            for (int k = 0; k < FP_BINS; ++k)
+            {
+                int lo = k - FP_PEAK_DF > 0 ? k - FP_PEAK_DF : 0;
+                int hi = k + FP_PEAK_DF < FP_BINS - 1 ? k + FP_PEAK_DF : FP_BINS - 1;
+                float m = row[lo];
+                for (int j = lo + 1; j <= hi; ++j)
+                    m = row[j] > m ? row[j] : m;
+                dil[k] = m;
+            }
+        }
+        long c = f - FP_PEAK_DT;
+        if (c >= 0 && c < frames && fp_find_peaks(e, c, frames) != 0)
+            return -1;
+    }
+
+    // 組: ピークはフレーム順に並んでいる
+    long count = 0;
+    for (long i = 0; i < e->num_peaks; ++i)
+    {
+        const FPPeak *a = &e->peaks[i];
+        int pairs = 0;
+        for (long j = i + 1; j < e->num_peaks && pairs < FP_FANOUT; ++j)
+        {
+            const FPPeak *b = &e->peaks[j];
+            int dt = b->frame - a->frame;
+            if (dt > FP_ZONE_DT)
+                break;
+            if (dt == 0 || abs(b->bin - a->bin) > FP_ZONE_DF)
+                continue;
+            if (count == *cap)
+            {
+                long n = *cap ? *cap * 2 : 4096;
+                FPHash *p = (FPHash *)realloc(*out, sizeof(FPHash) * n);
+                if (!p)
+                    return -1;
+                *out = p;
+                *cap = n;
+            }
+            (*out)[count].hash = (uint32_t)a->bin << 16 | (uint32_t)b->bin << 7 | (uint32_t)dt;
+            (*out)[count].frame = (uint32_t)a->frame;
+            count++;
+            pairs++;
+        }
+    }
+    return count;
+}
+
+// ---- 索引 ----
+
+// ファイル = FPIndexHeader，ファイル名（NUL区切り），各ファイルのフレーム数 int32[files]，
+//            ディレクトリ uint64[2^FP_DIR_BITS + 1]，ハッシュ uint32[entries]，FPPosting[entries]（8バイト境界）
+// ディレクトリの d 番目 = 上位ビットが d のハッシュの先頭位置
+typedef struct
+{
+    char magic[4];       // "FPIX"
+    int32_t version;     // FP_INDEX_VERSION
+    int32_t sample_rate; // 標本化周波数 [Hz]
+    int32_t frame_length, hop;
+    int32_t files;
+    int64_t entries;
+    int64_t names_offset, names_size;
+    int64_t frames_offset;
+    int64_t dir_offset;
+    int64_t hash_offset;
+    int64_t post_offset;
+} FPIndexHeader;
+
+#define FP_DIR_SIZE (1 << FP_DIR_BITS)
+#define FP_DIR_SHIFT (FP_HASH_BITS - FP_DIR_BITS)
+
+// hash と post（n 件）をハッシュ順に並べる（同じハッシュの中では元の順序を保つ）．dir にディレクトリを書く
+// ハッシュの下位 FP_DIR_SHIFT ビット → 上位 FP_DIR_BITS ビットの2回の基数ソート（作業領域に同じ大きさを使う）
+int fp_sort(uint32_t *hash, FPPosting *post, long n, uint64_t *dir)
+{
+    uint32_t *h2 = (uint32_t *)malloc(sizeof(uint32_t) * (n > 0 ? n : 1));
+    FPPosting *p2 = (FPPosting *)malloc(sizeof(FPPosting) * (n > 0 ? n : 1));
+    uint64_t *count = (uint64_t *)malloc(sizeof(uint64_t) * (FP_DIR_SIZE + 1));
+    if (!h2 || !p2 || !count)
+    {
+        free(h2);
+        free(p2);
+        free(count);
+        return -1;
+    }
+
+    const int shifts[2] = {0, FP_DIR_SHIFT};
+    const uint32_t masks[2] = {(1u << FP_DIR_SHIFT) - 1, FP_DIR_SIZE - 1};
+    for (int pass = 0; pass < 2; ++pass)
+    {
+        int shift = shifts[pass];
+        uint32_t mask = masks[pass];
+        memset(count, 0, sizeof(uint64_t) * (FP_DIR_SIZE + 1));
+        for (long i = 0; i < n; ++i)
+            count[((hash[i] >> shift) & mask) + 1]++;
+        for (uint32_t d = 0; d < mask + 1; ++d)
+            count[d + 1] += count[d];
+        if (pass == 1)
+            memcpy(dir, count, sizeof(uint64_t) * (FP_DIR_SIZE + 1));
+        for (long i = 0; i < n; ++i)
+        {
+            uint64_t at = count[(hash[i] >> shift) & mask]++;
+            h2[at] = hash[i];
+            p2[at] = post[i];
+        }
+        memcpy(hash, h2, sizeof(uint32_t) * n);
+        memcpy(post, p2, sizeof(FPPosting) * n);
+    }
+    free(h2);
+    free(p2);
+    free(count);
+    return 0;
+}
+
+// 並べ終えた索引を書き出す（一時ファイルに書いてから置き換える．成功なら0）
+int fp_index_write(const char *filename, int sample_rate, char *const *names, const int32_t *frames, int files,
+                   const uint64_t *dir, const uint32_t *hash, const FPPosting *post, long entries)
+{
+    FPIndexHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, FP_INDEX_MAGIC, 4);
+    h.version = FP_INDEX_VERSION;
+    h.sample_rate = sample_rate;
+    h.frame_length = FP_FRAME;
+    h.hop = FP_HOP;
+    h.files = files;
+    h.entries = entries;
+    h.names_offset = sizeof(h);
+    for (int i = 0; i < files; ++i)
+        h.names_size += (int64_t)strlen(names[i]) + 1;
+    h.frames_offset = (h.names_offset + h.names_size + 7) & ~(int64_t)7;
+    h.dir_offset = (h.frames_offset + (int64_t)sizeof(int32_t) * files + 7) & ~(int64_t)7;
+    h.hash_offset = h.dir_offset + (int64_t)sizeof(uint64_t) * (FP_DIR_SIZE + 1);
+    h.post_offset = (h.hash_offset + (int64_t)sizeof(uint32_t) * entries + 7) & ~(int64_t)7;
+
+    char tmp[4200];
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", filename, (long)getpid());
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp)
+        return -1;
+    static const char zeros[8] = {0};
+    int ok = fwrite(&h, sizeof(h), 1, fp) == 1;
+    for (int i = 0; i < files && ok; ++i)
+        ok = fwrite(names[i], strlen(names[i]) + 1, 1, fp) == 1;
+    ok = ok && fwrite(zeros, 1, h.frames_offset - h.names_offset - h.names_size, fp) == (size_t)(h.frames_offset - h.names_offset - h.names_size);
+    ok = ok && (files == 0 || fwrite(frames, sizeof(int32_t), files, fp) == (size_t)files);
+    ok = ok && fwrite(zeros, 1, h.dir_offset - h.frames_offset - sizeof(int32_t) * files, fp) == (size_t)(h.dir_offset - h.frames_offset - sizeof(int32_t) * files);
+    ok = ok && fwrite(dir, sizeof(uint64_t), FP_DIR_SIZE + 1, fp) == FP_DIR_SIZE + 1;
+    ok = ok && (entries == 0 || fwrite(hash, sizeof(uint32_t), entries, fp) == (size_t)entries);
+    ok = ok && fwrite(zeros, 1, h.post_offset - h.hash_offset - sizeof(uint32_t) * entries, fp) == (size_t)(h.post_offset - h.hash_offset - sizeof(uint32_t) * entries);
+    ok = ok && (entries == 0 || fwrite(post, sizeof(FPPosting), entries, fp) == (size_t)entries);
+    if (!ok | (fclose(fp) != 0) || rename(tmp, filename) != 0)
+    {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+// 検索用に mmap した索引
+typedef struct
+{
+    void *map;
+    size_t map_size;
+    const FPIndexHeader *header;
+    const char **names;     // ファイル名（files 個）
+    const int32_t *frames;  // 各ファイルのフレーム数
+    const uint64_t *dir;
+    const uint32_t *hash;
+    const FPPosting *post;
+} FPIndex;
+
+void fp_index_close(FPIndex *ix)
+{
+    if (ix->map)
+        munmap(ix->map, ix->map_size);
+    free(ix->names);
+    memset(ix, 0, sizeof(*ix));
+}
+
+// 索引を開く（成功なら0，失敗なら-1．形式が違うときは errno を EINVAL にする）
+int fp_index_open(const char *filename, FPIndex *ix)
+{
+    memset(ix, 0, sizeof(*ix));
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(FPIndexHeader))
+    {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+    ix->map_size = (size_t)st.st_size;
+    ix->map = mmap(NULL, ix->map_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (ix->map == MAP_FAILED)
+    {
+        ix->map = NULL;
+        return -1;
+    }
+
+    const unsigned char *base = (const unsigned char *)ix->map;
+    const FPIndexHeader *h = (const FPIndexHeader *)base;
+    ix->header = h;
+    if (memcmp(h->magic, FP_INDEX_MAGIC, 4) != 0 || h->version != FP_INDEX_VERSION || h->files < 0 || h->entries < 0 ||
+        h->post_offset + (int64_t)sizeof(FPPosting) * h->entries > (int64_t)ix->map_size ||
+        !(ix->names = (const char **)malloc(sizeof(char *) * (h->files > 0 ? h->files : 1))))
+    {
+        fp_index_close(ix);
+        errno = EINVAL;
+        return -1;
+    }
+    const char *name = (const char *)(base + h->names_offset);
+    for (int i = 0; i < h->files; ++i)
+    {
+        ix->names[i] = name;
+        name += strlen(name) + 1;
+    }
+    ix->frames = (const int32_t *)(base + h->frames_offset);
+    ix->dir = (const uint64_t *)(base + h->dir_offset);
+    ix->hash = (const uint32_t *)(base + h->hash_offset);
+    ix->post = (const FPPosting *)(base + h->post_offset);
+    return 0;
+}
+
+// hash の出現位置の先頭を *first に入れ，出現回数を返す
+long fp_index_lookup(const FPIndex *ix, uint32_t hash, long *first)
+{
+    uint32_t d = hash >> FP_DIR_SHIFT;
+    if (d >= FP_DIR_SIZE)
+        return 0;
+    long lo = (long)ix->dir[d], hi = (long)ix->dir[d + 1];
+    while (lo < hi) // hash 以上の最初の位置
+    {
+        long mid = lo + (hi - lo) / 2;
+        if (ix->hash[mid] < hash)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    long end = lo;
+    long limit = (long)ix->dir[d + 1];
+    while (end < limit && ix->hash[end] == hash)
+        end++;
+    *first = lo;
+    return end - lo;
+}
+
+// ---- 検索 ----
+
+typedef struct
+{
+    int file;
+    long offset; // 切り出しの先頭に当たる索引側のフレーム番号（負なら切り出しがファイルの先頭より前から始まる）
+    long votes;
+} FPMatch;
+
+int fp_key_compare(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+    return x < y ? -1 : x > y;
+}
+
+// クエリのハッシュ q（n 件）を索引と突き合わせ，票の多い順に最大 max 件を out に書いて件数を返す（失敗なら-1）
+// 票は (ファイル, フレームの差) ごとに数え，フレームの切れ目のずれで隣の差に割れた票も足す．
+// 同じファイルで差が FP_PEAK_DT 以内の候補は1つにまとめる．FP_MIN_VOTES 票未満の候補は出さず，
+// 1位が2位（max によらず数える）の FP_MIN_MARGIN 倍に届かなければ 0 件とする
+int fp_query(const FPIndex *ix, const FPHash *q, long n, FPMatch *out, int max, long *used)
+{
+    const uint64_t bias = 1u << 31; // 差が負でも並べられるように
+    long total = 0;
+    for (long i = 0; i < n; ++i)
+    {
+        long first, m = fp_index_lookup(ix, q[i].hash, &first);
+        total += m <= FP_MAX_POSTINGS ? m : 0;
+    }
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * (total > 0 ? total : 1));
+    if (!keys)
+        return -1;
+
+    long k = 0;
+    for (long i = 0; i < n; ++i)
+    {
+        long first, m = fp_index_lookup(ix, q[i].hash, &first);
+        if (m > FP_MAX_POSTINGS)
+            continue;
+        for (long j = first; j < first + m; ++j)
+        {
+            const FPPosting *p = &ix->post[j];
+            keys[k++] = (uint64_t)p->file << 32 | (uint64_t)(bias + p->frame - q[i].frame);
+        }
+    }
+    if (used)
+        *used = k;
+    qsort(keys, k, sizeof(uint64_t), fp_key_compare);
+
+    // 同じキーの並びを (キー, 票数) にまとめる（keys を前から詰めて使う）
+    long *votes = (long *)malloc(sizeof(long) * (k > 0 ? k : 1));
+    if (!votes)
+    {
+        free(keys);
+        return -1;
+    }
+    long u = 0;
+    for (long i = 0; i < k;)
+    {
+        long j = i;
+        while (j < k && keys[j] == keys[i])
+            j++;
+        keys[u] = keys[i];
+        votes[u++] = j - i;
+        i = j;
+    }
+
+    int found = 0;
+    long second = 0; // 2位の票
+    for (int rank = 0; rank < max || rank < 2; ++rank)
+    {
+        long best = -1, best_score = 0;
+        for (long i = 0; i < u; ++i)
+        {
+            if (votes[i] <= 0)
+                continue;
+            long score = votes[i];
+            if (i > 0 && keys[i - 1] + 1 == keys[i] && votes[i - 1] > 0)
+                score += votes[i - 1];
+            if (i + 1 < u && keys[i + 1] == keys[i] + 1 && votes[i + 1] > 0)
+                score += votes[i + 1];
+            if (score > best_score)
+            {
+                best = i;
+                best_score = score;
+            }
+        }
+        if (best < 0)
+            break;
+        if (rank == 1)
+            second = best_score;
+        if (best_score < FP_MIN_VOTES && rank > 0)
+            break;
+        uint64_t key = keys[best];
+        if (rank < max && best_score >= FP_MIN_VOTES)
+        {
+            out[found].file = (int)(key >> 32);
+            out[found].offset = (long)(key & 0xffffffffu) - (long)bias;
+            out[found].votes = best_score;
+            found++;
+        }
+        for (long i = 0; i < u; ++i) // 近くの差は同じ候補として除く
+            if (keys[i] >> 32 == key >> 32 && labs((long)(keys[i] & 0xffffffffu) - (long)(key & 0xffffffffu)) <= FP_PEAK_DT)
+                votes[i] = 0;
+    }
+    if (found > 0 && out[0].votes < FP_MIN_MARGIN * second)
+        found = 0;
+    free(keys);
+    free(votes);
+    return found;
+}
+
+#endif
@@ -0,0 +1,229 @@
+#ifndef FIR_FILTER_H
+#define FIR_FILTER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "DFT_IDFT_kadai3.h" // 実数FFT
+
+// FIRフィルタの適用
+// 短いフィルタは直接形の畳み込み（ベクトル拡張で8タップずつ），
+// 長いフィルタはFFTによる一様分割 overlap-save 畳み込みで計算する．
+// どちらも block 標本ずつ処理し，出力は入力と同じ時刻に揃う（遅延なし）．
+
+#define FIR_DIRECT_MAX_TAPS 64 // これ以下のタップ数なら直接形を使う
+#define FIR_DIRECT_BLOCK 4096  // 直接形の処理ブロック長
+
+enum
+{
+    FIR_AUTO,
+    FIR_DIRECT,
+    FIR_FFT
+};
+
+// kadai5 の理想低域通過フィルタ h[n] = sin(cutoff·π(n-N/2)) / π(n-N/2)（N次，n = 0〜N）
+double sinc_h(int n, int N, double cutoff)
+{
+    int mid = N / 2;
+    if (n == mid)
+        return cutoff; // 特異点：sin(0)/0 → cutoff
+    double x = M_PI * (n - mid);
+    return sin(cutoff * x) / x;
+}
+
+typedef float fir_v8f __attribute__((vector_size(32)));
+
+typedef struct
+{
+    int method;   // FIR_DIRECT または FIR_FFT
+    int taps;     // タップ数
+    int block;    // 1回の処理で入出力する標本数
+
+    // 直接形
+    int padded;   // 8の倍数に切り上げたタップ数
+    float *hrev;  // 逆順に並べた係数（先頭をゼロ詰め，長さpadded）
+    float *xbuf;  // 過去padded-1標本＋現在のブロック
+
+    // 一様分割 overlap-save（FFT長 2·block，分割数 parts）
+    int parts;
+    int bins;        // block+1
+    int head;        // 周波数領域遅延線の最新位置
+    RFFTPlan *plan;
+    double *Hr, *Hi; // 各分割のフィルタスペクトル（parts × bins）
+    double *Xr, *Xi; // 入力スペクトルの遅延線（parts × bins）
+    double *Yr, *Yi; // 出力スペクトル（bins）
+    double *time;    // FFT入出力（2·block）
+    float *prev;     // 直前の入力ブロック（block）
+} FIRFilter;
+
+void fir_destroy(FIRFilter *f)
+{
+    if (!f)
+        return;
+    free(f->hrev);
+    free(f->xbuf);
+    rfft_plan_destroy(f->plan);
+    free(f->Hr);
+    free(f->Hi);
+    free(f->Xr);
+    free(f->Xi);
+    free(f->Yr);
+    free(f->Yi);
+    free(f->time);
+    free(f->prev);
+    free(f);
+}
+
+// 係数h（taps個）のフィルタを作る
+// method が FIR_AUTO ならタップ数で選ぶ．block は FFT 法の分割長（0なら自動）
+FIRFilter *fir_create(const double *h, int taps, int method, int block)
+{
+    if (taps <= 0)
+        return NULL;
+
+    FIRFilter *f = (FIRFilter *)calloc(1, sizeof(FIRFilter));
+    if (!f)
+        return NULL;
+    if (method == FIR_AUTO)
+        method = taps <= FIR_DIRECT_MAX_TAPS ? FIR_DIRECT : FIR_FFT;
+    f->method = method;
+    f->taps = taps;
+
+    if (method == FIR_DIRECT)
+    {
+        f->block = FIR_DIRECT_BLOCK;
+        f->padded = (taps + 7) / 8 * 8;
+        f->hrev = (float *)calloc(f->padded, sizeof(float));
+        f->xbuf = (float *)calloc(f->padded - 1 + f->block, sizeof(float));
+        if (!f->hrev || !f->xbuf)
+        {
+            fir_destroy(f);
+            return NULL;
+        }
+        int lead = f->padded - taps;
+        for (int k = 0; k < taps; ++k)
+            f->hrev[lead + k] = (float)h[taps - 1 - k];
+        return f;
+    }
+
+    // 分割長はタップ数以上の2のべき乗（分割1つ）を既定にする
+    if (block <= 0)
+    {
+        block = 64;
+        while (block < taps)
+            block <<= 1;
+    }
+    f->block = block;
+    f->parts = (taps + block - 1) / block;
+    f->bins = block + 1;
+    f->plan = rfft_plan_create(2 * block);
+    f->Hr = (double *)malloc(sizeof(double) * f->parts * f->bins);
+    f->Hi = (double *)malloc(sizeof(double) * f->parts * f->bins);
+    f->Xr = (double *)calloc(f->parts * f->bins, sizeof(double));
+    f->Xi = (double *)calloc(f->parts * f->bins, sizeof(double));
+    f->Yr = (double *)malloc(sizeof(double) * f->bins);
+    f->Yi = (double *)malloc(sizeof(double) * f->bins);
+    f->time = (double *)malloc(sizeof(double) * 2 * block);
+    f->prev = (float *)calloc(block, sizeof(float));
+    if (!f->plan || !f->Hr || !f->Hi || !f->Xr || !f->Xi || !f->Yr || !f->Yi || !f->time || !f->prev)
+    {
+        fir_destroy(f);
+        return NULL;
+    }
+
+    for (int p = 0; p < f->parts; ++p) // 各分割 [h[pB], h[pB+B]) をゼロ詰めしてFFT
+    {
+        memset(f->time, 0, sizeof(double) * 2 * block);
+        for (int n = 0; n < block && p * block + n < taps; ++n)
+            f->time[n] = h[p * block + n];
+        rfft_forward(f->plan, f->time, f->Hr + p * f->bins, f->Hi + p * f->bins);
+    }
+    return f;
+}
+
+// 直接形：1ブロック分の畳み込み
+void fir_direct_block(FIRFilter *f, const float *in, float *out)
+{
+    int P = f->padded, B = f->block;
+    float *x = f->xbuf;
+    memcpy(x + P - 1, in, sizeof(float) * B);
+
+    for (int n = 0; n < B; ++n)
+    {
+        fir_v8f acc = {0};
+        const float *xn = x + n;
+        for (int k = 0; k < P; k += 8)
+        {
+            fir_v8f hv, xv;
+            memcpy(&hv, f->hrev + k, sizeof(hv));
+            memcpy(&xv, xn + k, sizeof(xv));
+            acc += hv * xv;
+        }
+        out[n] = acc[0] + acc[1] + acc[2] + acc[3] + acc[4] + acc[5] + acc[6] + acc[7];
+    }
+    memmove(x, x + B, sizeof(float) * (P - 1)); // 次のブロック用に末尾を履歴として残す
+}
+
+// 一様分割 overlap-save：1ブロック分の畳み込み
+void fir_fft_block(FIRFilter *f, const float *in, float *out)
+{
+    int B = f->block, K = f->bins;
+
+    // [直前のブロック, 現在のブロック] をFFTして遅延線の先頭に入れる
+    for (int n = 0; n < B; ++n)
+    {
+        f->time[n] = f->prev[n];
+        f->time[B + n] = in[n];
+    }
+    memcpy(f->prev, in, sizeof(float) * B);
+    f->head = (f->head + f->parts - 1) % f->parts;
+    rfft_forward(f->plan, f->time, f->Xr + f->head * K, f->Xi + f->head * K);
+
+    // Y = Σ H_p · X_{j-p}
+    memset(f->Yr, 0, sizeof(double) * K);
+    memset(f->Yi, 0, sizeof(double) * K);
+    for (int p = 0; p < f->parts; ++p)
+    {
+        int slot = (f->head + p) % f->parts;
+        const double *hr = f->Hr + p * K, *hi = f->Hi + p * K;
+        const double *xr = f->Xr + slot * K, *xi = f->Xi + slot * K;
+        for (int k = 0; k < K; ++k)
+        {
+            f->Yr[k] += hr[k] * xr[k] - hi[k] * xi[k];
+            f->Yi[k] += hr[k] * xi[k] + hi[k] * xr[k];
+        }
+    }
+
+    rfft_inverse(f->plan, f->Yr, f->Yi, f->time);
+    for (int n = 0; n < B; ++n) // 後半が巡回の影響を受けない正しい出力
+        out[n] = (float)f->time[B + n];
+}
+
+// 過去の入力を消して，作成直後と同じ状態に戻す（途切れた信号を続けて処理するとき）
+void fir_reset(FIRFilter *f)
+{
+    if (f->method == FIR_DIRECT)
+    {
+        memset(f->xbuf, 0, sizeof(float) * (f->padded - 1));
+        return;
+    }
+    memset(f->Xr, 0, sizeof(double) * f->parts * f->bins);
+    memset(f->Xi, 0, sizeof(double) * f->parts * f->bins);
+    memset(f->prev, 0, sizeof(float) * f->block);
+    f->head = 0;
+}
+
+// f->block 標本を処理する（in と out は同じ配列でもよい）
+void fir_process_block(FIRFilter *f, const float *in, float *out)
+{
+    TRACE_BEGIN(t);
+    if (f->method == FIR_DIRECT)
+        fir_direct_block(f, in, out);
+    else
+        fir_fft_block(f, in, out);
+    TRACE_END(t, STAGE_FILTER, f->block);
+}
+
+#endif
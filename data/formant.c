@@ -0,0 +1,235 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "formant.h" // LPCフォルマント・F0推定
+#include "pcm_io.h"  // rawファイルの読み込み（mmap）
+#include "out_io.h"  // テキスト／バイナリ出力
+
+#define SAMPLE_RATE 16000   // サンプリング周波数 [Hz]
+#define FRAME_LENGTH 320    // フレーム長 = 20ms（kadai4 と同じ）
+#define HOP 160             // フレームシフト = 10ms
+#define LPC_ORDER 18        // LPC次数（標本化周波数[kHz] + 2）
+#define ENERGY_RANGE 15.0   // 最大フレームからこの範囲[dB]内のフレームを平均に使う
+#define MAX_PATH_LEN 1024
+
+// 母音と話者の性別（ファイル名の先頭の f/m）ごとの平均
+typedef struct
+{
+    double f0, f1, f2;
+    int n;
+} Summary;
+
+double now_sec(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// ファイル名から母音（最後に現れる a/i/u/e/o）を探す（なければ0）
+char vowel_of(const char *base)
+{
+    size_t len = strcspn(base, ".");
+    for (size_t i = len; i-- > 0;)
+        if (strchr("aiueo", base[i]))
+            return base[i];
+    return 0;
+}
+
+// 1フレーム分の軌跡を書き出す（時刻[ms] エネルギー[dB] F0 F1 F2 [Hz]）
+void write_track_text(TextWriter *w, double time_ms, const FormantFrame *f)
+{
+    const double values[5] = {time_ms, f->energy_db, f->f0, f->f1, f->f2};
+    for (int i = 0; i < 5; ++i)
+    {
+        tw_fixed(w, values[i], i == 1 ? 2 : 1);
+        tw_char(w, i < 4 ? ' ' : '\n');
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    int order = LPC_ORDER, format = OUT_TEXT;
+    const char *outdir = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "p:o:F:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'p': order = atoi(optarg); break;
+        case 'o': outdir = optarg; break;
+        case 'F':
+            if ((format = out_format_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        default: argc = 0;
+        }
+    }
+    if (optind >= argc)
+    {
+        fprintf(stderr, "使い方: %s [-p LPC次数] [-o 軌跡の出力ディレクトリ] [-F txt|bin] <入力ファイル/ディレクトリ ...>\n", argv[0]);
+        return 1;
+    }
+
+    RawFileList files = {0};
+    for (int i = optind; i < argc; ++i)
+        raw_list_collect(&files, argv[i]);
+    if (files.count == 0)
+    {
+        fprintf(stderr, "入力ファイルがありません\n");
+        return 1;
+    }
+    if (outdir)
+        mkdir(outdir, 0755);
+
+    FormantTracker *tracker = formant_create(FRAME_LENGTH, order, SAMPLE_RATE);
+    if (!tracker)
+    {
+        fprintf(stderr, "パラメータが不正です（LPC次数は1〜%d）\n", FORMANT_MAX_ORDER);
+        return 1;
+    }
+
+    // 軌跡はファイルごとに溜めてから書く（最長のファイルに合わせて伸ばす）
+    long capacity = 0;
+    FormantFrame *track = NULL;
+    double frame[FRAME_LENGTH];
+    Summary groups[2][5] = {{{0}}};
+    long total_frames = 0;
+    double elapsed = 0.0;
+
+    printf("%-28s %6s %8s %8s %8s\n", "file", "frames", "F0[Hz]", "F1[Hz]", "F2[Hz]");
+    for (int i = 0; i < files.count; ++i)
+    {
+        PCMData pcm;
+        if (pcm_open(files.paths[i], &pcm) != 0)
+        {
+            perror(files.paths[i]);
+            continue;
+        }
+        long frames = pcm.length < FRAME_LENGTH ? 1 : 1 + (pcm.length - FRAME_LENGTH) / HOP;
+        if (frames > capacity)
+        {
+            FormantFrame *grown = (FormantFrame *)realloc(track, sizeof(FormantFrame) * frames);
+            if (!grown) // 確保できなければこのファイルは飛ばす（前の軌跡の領域は次のファイルに使える）
+            {
+                perror(files.paths[i]);
+                pcm_close(&pcm);
+                continue;
+            }
+            track = grown;
+            capacity = frames;
+        }
+
+        double t0 = now_sec();
+        double max_db = -1e300;
+        for (long f = 0; f < frames; ++f)
+        {
+            long start = f * HOP;
+            for (int n = 0; n < FRAME_LENGTH; ++n)
+                frame[n] = start + n < pcm.length ? pcm.samples[start + n] : 0.0;
+            formant_analyze(tracker, frame, &track[f]);
+            if (track[f].energy_db > max_db)
+                max_db = track[f].energy_db;
+        }
+        elapsed += now_sec() - t0;
+        total_frames += frames;
+
+        // 有声で十分大きいフレームの平均
+        Summary s = {0};
+        for (long f = 0; f < frames; ++f)
+        {
+            const FormantFrame *t = &track[f];
+            if (t->f0 > 0.0 && t->f1 > 0.0 && t->f2 > 0.0 && t->energy_db >= max_db - ENERGY_RANGE)
+            {
+                s.f0 += t->f0;
+                s.f1 += t->f1;
+                s.f2 += t->f2;
+                s.n++;
+            }
+        }
+        const char *base = strrchr(files.paths[i], '/');
+        base = base ? base + 1 : files.paths[i];
+        if (s.n > 0)
+        {
+            printf("%-28s %6d %8.1f %8.1f %8.1f\n", base, s.n, s.f0 / s.n, s.f1 / s.n, s.f2 / s.n);
+            const char *v = strchr("aiueo", vowel_of(base));
+            int sex = base[0] == 'f' ? 0 : base[0] == 'm' ? 1 : -1;
+            if (v && *v && sex >= 0)
+            {
+                Summary *g = &groups[sex][v - "aiueo"];
+                g->f0 += s.f0 / s.n;
+                g->f1 += s.f1 / s.n;
+                g->f2 += s.f2 / s.n;
+                g->n++;
+            }
+        }
+        else
+        {
+            printf("%-28s %6d %8s %8s %8s\n", base, 0, "-", "-", "-");
+        }
+
+        if (outdir)
+        {
+            char out[MAX_PATH_LEN];
+            size_t len = strlen(base);
+            if (ends_with_raw(base))
+                len -= 4;
+            snprintf(out, sizeof(out), "%s/%.*s%s", outdir, (int)len, base, format == OUT_TEXT ? ".txt" : ".bin");
+            int failed;
+            if (format == OUT_TEXT)
+            {
+                TextWriter *w = tw_open(out);
+                if ((failed = !w) == 0)
+                {
+                    for (long f = 0; f < frames; ++f)
+                        write_track_text(w, f * HOP * 1000.0 / SAMPLE_RATE, &track[f]);
+                    failed = tw_close(w) != 0;
+                }
+            }
+            else
+            {
+                // 4列（エネルギー[dB], F0, F1, F2 [Hz]）× フレーム，横軸は時刻[ms]
+                ColumnWriter *c = col_open(out, frames, 4, 0.0, HOP * 1000.0 / SAMPLE_RATE, "ms", "dB,Hz,Hz,Hz");
+                if ((failed = !c) == 0)
+                {
+                    for (long f = 0; f < frames; ++f)
+                    {
+                        const double row[4] = {track[f].energy_db, track[f].f0, track[f].f1, track[f].f2};
+                        col_write_double(c, row, 4);
+                    }
+                    failed = col_close(c) != 0;
+                }
+            }
+            if (failed)
+                perror(out);
+        }
+        pcm_close(&pcm);
+    }
+
+    printf("\n%-6s %-5s %8s %8s %8s\n", "vowel", "sex", "F0[Hz]", "F1[Hz]", "F2[Hz]");
+    for (int v = 0; v < 5; ++v)
+    {
+        for (int sex = 0; sex < 2; ++sex)
+        {
+            const Summary *g = &groups[sex][v];
+            if (g->n > 0)
+                printf("%-6c %-5s %8.1f %8.1f %8.1f\n", "aiueo"[v], sex ? "m" : "f", g->f0 / g->n, g->f1 / g->n, g->f2 / g->n);
+        }
+    }
+    printf("\n%d ファイル, %ld フレームを %.3f ms で解析しました（1フレーム %.2f µs）\n",
+           files.count, total_frames, elapsed * 1e3, total_frames ? elapsed * 1e6 / total_frames : 0.0);
+
+    free(track);
+    formant_destroy(tracker);
+    raw_list_free(&files);
+    return 0;
+}
+
+// 例:
+// ./formant ../data2
+// ./formant -o tracks -F bin ../data2 a00.raw
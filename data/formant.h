@@ -0,0 +1,219 @@
+#ifndef FORMANT_H
+#define FORMANT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "stft.h" // 窓関数・実数FFT
+
+// LPC によるフォルマント（F1/F2）と自己相関による基本周波数（F0）の推定
+//
+// 1フレームごとに，kadai4 と同じハミング窓を掛けた信号の自己相関を FFT で求め（|X|² の逆変換），
+//  - 窓の自己相関で割って正規化した自己相関のピークから F0 を，
+//  - プリエンファシス（1 - μz⁻¹）を自己相関の上で掛けてから Levinson-Durbin 法で LPC 係数を求め，
+//    LPC スペクトル包絡 1/|A(e^jω)|² のピーク（放物線補間）から F1, F2 を推定する．
+// 作業領域は作成時にすべて確保するので，フレームごとの処理では確保しない．
+
+#define FORMANT_MAX_ORDER 32
+#define FORMANT_PREEMPHASIS 0.97
+#define FORMANT_VOICING 0.45   // 正規化自己相関のピークがこれ以上なら有声
+#define FORMANT_F0_MIN 70.0    // F0 の探索範囲 [Hz]
+#define FORMANT_F0_MAX 500.0
+#define FORMANT_F1_MIN 200.0   // これより低いピークはフォルマントとみなさない [Hz]
+
+typedef struct
+{
+    double energy_db; // フレームの対数パワー [dB]
+    double f0;        // 基本周波数 [Hz]（無声なら0）
+    double f1, f2;    // 第1・第2フォルマント [Hz]（見つからなければ0）
+    double voicing;   // 正規化自己相関のピーク値
+} FormantFrame;
+
+typedef struct
+{
+    int frame_length, fft_size, bins, order, sample_rate;
+    RFFTPlan *plan;
+    double *window;   // 窓係数（frame_length）
+    double *win_ac;   // 窓の自己相関（正規化用，fft_size）
+    double *frame;    // FFT入力（fft_size，frame_length以降はゼロ）
+    double *Xr, *Xi;  // スペクトル（bins）
+    double *ac;       // 自己相関（fft_size）
+    double a[FORMANT_MAX_ORDER + 1];  // LPC係数 A(z) = 1 + Σ a[i] z^-i
+    double rp[FORMANT_MAX_ORDER + 1]; // プリエンファシス後の自己相関
+    double tmp[FORMANT_MAX_ORDER + 1]; // Levinson-Durbin の作業領域
+} FormantTracker;
+
+void formant_destroy(FormantTracker *t)
+{
+    if (!t)
+        return;
+    rfft_plan_destroy(t->plan);
+    free(t->window);
+    free(t->win_ac);
+    free(t->frame);
+    free(t->Xr);
+    free(t->Xi);
+    free(t->ac);
+    free(t);
+}
+
+// 自己相関 = |X|² の逆変換（frame はゼロ詰め済みで fft_size ≥ 2*frame_length-1 なので巡回しない）
+void formant_autocorr(FormantTracker *t, const double *frame, double *ac)
+{
+    rfft_forward(t->plan, frame, t->Xr, t->Xi);
+    for (int k = 0; k < t->bins; ++k)
+    {
+        t->Xr[k] = t->Xr[k] * t->Xr[k] + t->Xi[k] * t->Xi[k];
+        t->Xi[k] = 0.0;
+    }
+    rfft_inverse(t->plan, t->Xr, t->Xi, ac);
+}
+
+// 作成する（order は LPC 次数，失敗時はNULL）
+FormantTracker *formant_create(int frame_length, int order, int sample_rate)
+{
+    if (frame_length <= 0 || order <= 0 || order > FORMANT_MAX_ORDER || order >= frame_length)
+        return NULL;
+
+    FormantTracker *t = (FormantTracker *)calloc(1, sizeof(FormantTracker));
+    if (!t)
+        return NULL;
+    int n = 1;
+    while (n < 2 * frame_length - 1)
+        n <<= 1;
+    t->frame_length = frame_length;
+    t->fft_size = n;
+    t->bins = n / 2 + 1;
+    t->order = order;
+    t->sample_rate = sample_rate;
+    t->plan = rfft_plan_create(n);
+    t->window = (double *)malloc(sizeof(double) * frame_length);
+    t->win_ac = (double *)malloc(sizeof(double) * n);
+    t->frame = (double *)calloc(n, sizeof(double));
+    t->Xr = (double *)malloc(sizeof(double) * t->bins);
+    t->Xi = (double *)malloc(sizeof(double) * t->bins);
+    t->ac = (double *)malloc(sizeof(double) * n);
+    if (!t->plan || !t->window || !t->win_ac || !t->frame || !t->Xr || !t->Xi || !t->ac)
+    {
+        formant_destroy(t);
+        return NULL;
+    }
+
+    make_window(WINDOW_HAMMING, t->window, frame_length);
+    memcpy(t->frame, t->window, sizeof(double) * frame_length);
+    formant_autocorr(t, t->frame, t->win_ac);
+    return t;
+}
+
+// Levinson-Durbin 法で自己相関 r から LPC 係数 a[0..p] を求める（戻り値は予測誤差）
+double levinson_durbin(const double *r, int p, double *a, double *tmp)
+{
+    double err = r[0];
+    a[0] = 1.0;
+    for (int i = 1; i <= p; ++i)
+        a[i] = 0.0;
+    if (err <= 0.0)
+        return 0.0;
+
+    for (int i = 1; i <= p; ++i)
+    {
+        double acc = r[i];
+        for (int j = 1; j < i; ++j)
+            acc += a[j] * r[i - j];
+        double k = -acc / err; // 反射係数
+        memcpy(tmp, a, sizeof(double) * (i + 1));
+        for (int j = 1; j < i; ++j)
+            a[j] = tmp[j] + k * tmp[i - j];
+        a[i] = k;
+        err *= 1.0 - k * k;
+        if (err <= 0.0)
+            break;
+    }
+    return err;
+}
+
+// 放物線補間したピーク位置（y[i] が極大のとき i-1, i, i+1 の3点から）
+double parabolic_peak(const double *y, int i)
+{
+    double d = y[i - 1] - 2.0 * y[i] + y[i + 1];
+    return d < 0.0 ? i + 0.5 * (y[i - 1] - y[i + 1]) / d : (double)i;
+}
+
+// samples（frame_length 標本）の1フレームを解析する
+void formant_analyze(FormantTracker *t, const double *samples, FormantFrame *out)
+{
+    int L = t->frame_length, n = t->fft_size;
+    for (int i = 0; i < L; ++i) // kadai4 の apply_hamming_window と同じ窓
+        t->frame[i] = samples[i] * t->window[i];
+    // L以降は作成時にゼロ詰め済み
+
+    double *r = t->ac;
+    formant_autocorr(t, t->frame, r);
+    out->energy_db = 10.0 * log10(r[0] / L + 1e-12);
+    out->f0 = out->f1 = out->f2 = out->voicing = 0.0;
+    if (r[0] <= 0.0)
+        return;
+
+    // F0: 窓の自己相関で正規化した自己相関の最大ピーク
+    int lag_min = (int)(t->sample_rate / FORMANT_F0_MAX);
+    int lag_max = (int)(t->sample_rate / FORMANT_F0_MIN);
+    if (lag_max > L * 2 / 3) // 窓の端では正規化が不安定になる
+        lag_max = L * 2 / 3;
+    int best = -1;
+    double best_v = 0.0;
+    for (int k = lag_min; k <= lag_max; ++k)
+    {
+        double v = (r[k] / r[0]) / (t->win_ac[k] / t->win_ac[0]);
+        double prev = (r[k - 1] / r[0]) / (t->win_ac[k - 1] / t->win_ac[0]);
+        double next = (r[k + 1] / r[0]) / (t->win_ac[k + 1] / t->win_ac[0]);
+        if (v > prev && v >= next && v > best_v)
+        {
+            best_v = v;
+            best = k;
+        }
+    }
+    out->voicing = best_v;
+    if (best > 0 && best_v >= FORMANT_VOICING)
+    {
+        double y[3];
+        for (int d = -1; d <= 1; ++d)
+            y[d + 1] = r[best + d] / t->win_ac[best + d];
+        double lag = best - 1 + parabolic_peak(y, 1);
+        out->f0 = t->sample_rate / lag;
+    }
+
+    // LPC: プリエンファシス後の自己相関 r'[k] = (1+μ²) r[k] - μ (r[k-1] + r[k+1])
+    double mu = FORMANT_PREEMPHASIS;
+    double *rp = t->rp;
+    for (int k = 0; k <= t->order; ++k) // r[-1] = r[1]
+        rp[k] = (1.0 + mu * mu) * r[k] - mu * ((k > 0 ? r[k - 1] : r[1]) + r[k + 1]);
+    rp[0] *= 1.0 + 1e-9; // 数値的に安定させる（わずかな白色雑音の付加）
+    levinson_durbin(rp, t->order, t->a, t->tmp);
+
+    // LPC スペクトル包絡: A(z) の係数をゼロ詰めしてFFTし，-10log10|A|² を求める
+    double *env = t->ac; // 自己相関はもう使わない
+    memset(t->frame, 0, sizeof(double) * n);
+    memcpy(t->frame, t->a, sizeof(double) * (t->order + 1));
+    rfft_forward(t->plan, t->frame, t->Xr, t->Xi);
+    memset(t->frame, 0, sizeof(double) * (t->order + 1));
+    for (int k = 0; k < t->bins; ++k)
+        env[k] = -10.0 * log10(t->Xr[k] * t->Xr[k] + t->Xi[k] * t->Xi[k] + 1e-12);
+
+    double bin_hz = (double)t->sample_rate / n;
+    int found = 0;
+    for (int k = (int)(FORMANT_F1_MIN / bin_hz) + 1; k < t->bins - 1 && found < 2; ++k)
+    {
+        if (env[k] > env[k - 1] && env[k] >= env[k + 1])
+        {
+            double f = parabolic_peak(env, k) * bin_hz;
+            if (found++ == 0)
+                out->f1 = f;
+            else
+                out->f2 = f;
+        }
+    }
+}
+
+#endif
@@ -1,61 +1,92 @@
 ﻿#include <stdio.h>
 #include <stdlib.h>
-#include <sys/stat.h>
+
+#include <unistd.h>
+
+#include "pcm_io.h"   // rawファイルの読み込み（mmap）
+#include "pcm_gain.h" // int16 → float の一括変換
+#include "out_io.h"   // テキスト／バイナリ出力
 
 int main(int argc, char *argv[]) {
-    FILE *fp_in, *fp_out;
-    struct stat st;
-    short sample;
-    int num_samples;
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    PCMData pcm;
+    long num_samples;
     const double sampling_rate = 16000.0;
+    int format = OUT_TEXT;
+
+    // オプション: -f txt|bin で出力形式を選ぶ
+    int opt;
+    while ((opt = getopt(argc, argv, "f:")) != -1) {
+        if (opt != 'f' || (format = out_format_from_name(optarg)) < 0) {
+            argc = 0;
+        }
+    }
 
     // 引数チェック
-    if (argc != 3) {
-        fprintf(stderr, "使い方: %s <入力rawファイル> <出力txtファイル>\n", argv[0]);
+    if (argc - optind != 2) {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] [-f txt|bin] <入力rawファイル> <出力ファイル>\n", argv[0]);
         return 1;
     }
 
     // 入出力ファイル名
-    const char *input_filename = argv[1];
-    const char *output_filename = argv[2];
+    const char *input_filename = argv[optind];
+    const char *output_filename = argv[optind + 1];
 
     // 入力ファイルを開く
-    fp_in = fopen(input_filename, "rb");
-    if (fp_in == NULL) {
+    if (pcm_open(input_filename, &pcm) != 0) {
         perror("入力ファイルが開けませんでした");
         return 1;
     }
 
-    // 出力ファイルを開く
-    fp_out = fopen(output_filename, "w");
-    if (fp_out == NULL) {
-        perror("出力ファイルが開けませんでした");
-        fclose(fp_in);
-        return 1;
-    }
+    // 標本数（WAVならヘッダを除いた分）
+    num_samples = pcm.length;
 
-    // ファイルサイズ取得
-    if (stat(input_filename, &st) != 0) {
-        perror("ファイルサイズ取得失敗");
-        fclose(fp_in);
-        fclose(fp_out);
-        return 1;
-    }
+    int ret;
+    TRACE_BEGIN(t);
+    if (format == OUT_TEXT) {
+        // 出力ファイルを開く
+        TextWriter *out = tw_open(output_filename);
+        if (out == NULL) {
+            TRACE_END(t, STAGE_WRITE, 0);
+            perror("出力ファイルが開けませんでした");
+            pcm_close(&pcm);
+            return 1;
+        }
 
-    // 標本数 = バイト数 / 2（16bit = 2バイト）
-    num_samples = st.st_size / sizeof(short);
+        // 出力（ミリ秒単位）: "%.3f %d\n"
+        for (long i = 0; i < num_samples; i++) {
+            double time_ms = (i * 1000.0) / sampling_rate;
+            tw_fixed(out, time_ms, 3);
+            tw_char(out, ' ');
+            tw_int(out, pcm.samples[i]);
+            tw_char(out, '\n');
+        }
+        ret = tw_close(out);
+    } else {
+        // 軸 = 時刻[ms]，値 = 標本値
+        ColumnWriter *out = col_open(output_filename, num_samples, 1, 0.0, 1000.0 / sampling_rate, "ms", "sample");
+        if (out == NULL) {
+            TRACE_END(t, STAGE_WRITE, 0);
+            perror("出力ファイルが開けませんでした");
+            pcm_close(&pcm);
+            return 1;
+        }
 
-    // 読み取りと出力（ミリ秒単位）
-    for (int i = 0; i < num_samples; i++) {
-        if (fread(&sample, sizeof(short), 1, fp_in) != 1) {
-            break;
+        float block[4096];
+        for (long i = 0; i < num_samples; i += 4096) {
+            long n = num_samples - i < 4096 ? num_samples - i : 4096;
+            pcm_to_float(pcm.samples + i, block, n);
+            col_write(out, block, n);
         }
-        double time_ms = (i * 1000.0) / sampling_rate;
-        fprintf(fp_out, "%.3f %d\n", time_ms, sample);
+        ret = col_close(out);
     }
+    TRACE_END(t, STAGE_WRITE, num_samples);
 
-    fclose(fp_in);
-    fclose(fp_out);
+    pcm_close(&pcm);
+    if (ret != 0) {
+        perror("出力ファイルの書き込みに失敗しました");
+        return 1;
+    }
     printf("出力完了: %s\n", output_filename);
 
     return 0;
@@ -1,27 +1,44 @@
 #include <stdio.h>
 #include <stdlib.h>
-#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pcm_io.h"   // rawファイルの読み込み（mmap）
+#include "pcm_gain.h" // 一括ゲイン・飽和処理
+
+#define BLOCK 65536 // 1回に処理・書き出す標本数
 
 int main(int argc, char *argv[]) {
-    FILE *fp_in, *fp_out;
-    struct stat st;
-    short sample, scaled_sample;
-    int num_samples;
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    FILE *fp_out;
+    PCMData pcm;
+    long num_samples;
     double gain = 30.0;
+    int normalize = 0;     // 0: 固定ゲイン，'p': ピーク正規化，'r': 実効値正規化
+    double target_db = 0.0; // 正規化の目標レベル [dBFS]
+
+    // オプション: -g 倍率，-p 目標ピーク[dBFS]，-r 目標実効値[dBFS]
+    int opt;
+    while ((opt = getopt(argc, argv, "g:p:r:")) != -1) {
+        switch (opt) {
+        case 'g': gain = atof(optarg); break;
+        case 'p': normalize = 'p'; target_db = atof(optarg); break;
+        case 'r': normalize = 'r'; target_db = atof(optarg); break;
+        default: argc = 0;
+        }
+    }
 
     // 引数チェック
-    if (argc != 3) {
-        printf("使い方: %s <入力ファイル> <出力ファイル>\n", argv[0]);
+    if (argc - optind != 2) {
+        printf("使い方: %s [--stats] [--trace=トレース.json] [-g 倍率 | -p 目標ピーク[dBFS] | -r 目標実効値[dBFS]] <入力ファイル> <出力ファイル>\n", argv[0]);
         return 1;
     }
 
     // 入出力ファイル名
-    const char *input_filename = argv[1];
-    const char *output_filename = argv[2];
+    const char *input_filename = argv[optind];
+    const char *output_filename = argv[optind + 1];
 
     // 入力ファイルを開く
-    fp_in = fopen(input_filename, "rb");
-    if (fp_in == NULL) {
+    if (pcm_open(input_filename, &pcm) != 0) {
         perror("入力ファイルが開けませんでした");
         return 1;
     }
@@ -30,32 +47,35 @@ int main(int argc, char *argv[]) {
     fp_out = fopen(output_filename, "wb");
     if (fp_out == NULL) {
         perror("出力ファイルが開けませんでした");
-        fclose(fp_in);
+        pcm_close(&pcm);
         return 1;
     }
 
-    // ファイルサイズ取得
-    if (stat(input_filename, &st) != 0) {
-        perror("ファイルサイズ取得失敗");
-        fclose(fp_in);
-        fclose(fp_out);
-        return 1;
-    }
+    num_samples = pcm.length;
 
-    num_samples = st.st_size / sizeof(short);
-
-    for (int i = 0; i < num_samples; i++) {
-        if (fread(&sample, sizeof(short), 1, fp_in) != 1) break;
-
-        int temp = (int)(sample * gain);
-        // if (temp > 32767) temp = 32767;
-        // if (temp < -32768) temp = -32768;
-        scaled_sample = (short)temp;
+    // 正規化なら1回の走査でピーク／実効値を測ってゲインを決める
+    if (normalize == 'p') {
+        gain = pcm_peak_gain(pcm.samples, num_samples, target_db);
+    } else if (normalize == 'r') {
+        gain = pcm_rms_gain(pcm.samples, num_samples, target_db);
+    }
 
-        fwrite(&scaled_sample, sizeof(short), 1, fp_out);
+    // ブロックごとに gain 倍し，16bitの範囲に飽和させて書き出す（桁あふれで符号が反転しない）
+    short *block = (short *)malloc(sizeof(short) * BLOCK);
+    if (!block) {
+        perror("malloc");
+        return 1;
+    }
+    for (long i = 0; i < num_samples; i += BLOCK) {
+        long n = num_samples - i < BLOCK ? num_samples - i : BLOCK;
+        pcm_apply_gain(pcm.samples + i, block, n, (float)gain);
+        TRACE_BEGIN(t);
+        fwrite(block, sizeof(short), n, fp_out);
+        TRACE_END(t, STAGE_WRITE, n);
     }
 
-    fclose(fp_in);
+    free(block);
+    pcm_close(&pcm);
     fclose(fp_out);
 
     printf("振幅を %.1f 倍した音声を %s に出力しました。\n", gain, output_filename);
@@ -64,4 +84,4 @@ int main(int argc, char *argv[]) {
 
 // a00 8000
 // a000-loud3 15000
-// a000-loud30 400000
\ No newline at end of file
+// a000-loud30 400000
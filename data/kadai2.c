@@ -1,79 +1,149 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
-#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pcm_io.h"       // rawファイルの読み込み（mmap）
+#include "out_io.h"       // テキスト出力
+#include "vad.h"          // 音声区間検出
+#include "result_cache.h" // 結果キャッシュ
 
 #define SAMPLE_RATE 16000                                          // サンプリング周波数を16kHzに設定
 #define SEGMENT_DURATION_MS 20                                     // セグメントの長さを20msに設定
 #define SEGMENT_SAMPLES (SAMPLE_RATE * SEGMENT_DURATION_MS / 1000) // セグメントのサンプル数を計算=320サンプル
+#define MAX_SEGMENTS 64                                            // 検出する音声区間の最大数
+#define OUTPUT_VERSION 1                                           // 出力の版（キャッシュのキーに入る．vad.h を含め出力が変わったら上げる）
+
+ResultCache *cache = NULL; // 結果キャッシュ（-C dir）
 
 void cut_center_segment(const char *in_filename, const char *out_txt_filename) // 関数の定義
 {
-    struct stat st;                  // ファイルの情報を取得するための構造体
-    if (stat(in_filename, &st) != 0) // ファイルの情報を取得
+    PCMData pcm;                         // ファイル全体への読み取り専用アクセス
+    if (pcm_open(in_filename, &pcm) != 0) // ファイルを開く（mmapするので読み込みは必要な部分だけ）
     {
-        perror("stat");
+        perror("open input");
         return;
     }
 
-    long file_size = st.st_size;                     // ファイルサイズを取得
-    int total_samples = file_size / sizeof(int16_t); // ファイルサイズを16ビット整数のサイズで割ってサンプル数を計算
+    long total_samples = pcm.length; // サンプル数
 
-    int start_sample;           // セグメントの開始サンプルを格納する変数
-    if (total_samples % 2 == 0) // サンプル数が偶数の場合
+    // 同じ入力の切り出しはキャッシュから出す
+    uint64_t key = 0;
+    if (cache)
     {
-        start_sample = total_samples / 2 - SEGMENT_SAMPLES / 2; // セグメントの開始サンプルを計算
+        char params[128];
+        snprintf(params, sizeof(params), "kadai2;v=%d;fs=%d;seg=%d;vad=default", OUTPUT_VERSION, SAMPLE_RATE, SEGMENT_SAMPLES);
+        key = cache_key(pcm.samples, total_samples, params);
+        CacheEntry e;
+        if (cache_lookup(cache, key, &e))
+        {
+            if (cache_write_file(&e, out_txt_filename) != 0)
+                perror("fopen output");
+            else
+                printf("Saved %s (cached)\n", out_txt_filename);
+            cache_release(&e);
+            pcm_close(&pcm);
+            return;
+        }
     }
-    else // サンプル数が奇数の場合
+
+    // 音声区間を検出し，最も長い区間の中央を切り出す（区間がなければファイル全体の中央）
+    VADParams params;
+    VADSegment segs[MAX_SEGMENTS];
+    vad_default_params(&params, SAMPLE_RATE);
+    int num_segs = vad_segments(&params, pcm.samples, total_samples, segs, MAX_SEGMENTS);
+    long seg_start = 0, seg_end = total_samples;
+    for (int i = 0; i < num_segs; ++i)
     {
-        start_sample = (total_samples + 1) / 2 - SEGMENT_SAMPLES / 2; // セグメントの開始サンプルを計算
+        if (i == 0 || segs[i].end - segs[i].start > seg_end - seg_start)
+        {
+            seg_start = segs[i].start;
+            seg_end = segs[i].end;
+        }
     }
+    long seg_length = seg_end - seg_start;
 
-    long start_byte = start_sample * sizeof(int16_t); // 開始サンプルをバイトに変換
-
-    FILE *in_fp = fopen(in_filename, "rb"); // 入力ファイルをバイナリモードで開く
-    if (!in_fp)
+    long start_sample;          // セグメントの開始サンプルを格納する変数
+    if (seg_length % 2 == 0) // サンプル数が偶数の場合
     {
-        perror("fopen input");
-        return;
+        start_sample = seg_start + seg_length / 2 - SEGMENT_SAMPLES / 2; // セグメントの開始サンプルを計算
+    }
+    else // サンプル数が奇数の場合
+    {
+        start_sample = seg_start + (seg_length + 1) / 2 - SEGMENT_SAMPLES / 2; // セグメントの開始サンプルを計算
     }
 
-    if (fseek(in_fp, start_byte, SEEK_SET) != 0) // ファイルポインタをセグメントの開始位置に移動
+    if (start_sample < 0) // ファイルがセグメントより短い場合は先頭から
     {
-        perror("fseek");
-        fclose(in_fp);
-        return;
+        start_sample = 0;
     }
 
-    int16_t buffer[SEGMENT_SAMPLES];                                              // セグメントのサンプルを格納するバッファを定義
-    size_t read_samples = fread(buffer, sizeof(int16_t), SEGMENT_SAMPLES, in_fp); // セグメントのサンプルを読み込む
-    fclose(in_fp);                                                                // 入力ファイルを閉じる
+    const int16_t *buffer = pcm.samples + start_sample;                 // セグメントの先頭（コピーしない）
+    size_t read_samples = total_samples - start_sample < SEGMENT_SAMPLES // 読めるサンプル数
+                              ? (size_t)(total_samples - start_sample)
+                              : SEGMENT_SAMPLES;
 
     if (read_samples != SEGMENT_SAMPLES) // 読み込んだサンプル数が期待値と異なる場合
     {
         fprintf(stderr, "error: expected %d samples, read %zu\n", SEGMENT_SAMPLES, read_samples);
     }
 
-    FILE *out_fp = fopen(out_txt_filename, "w"); // 出力ファイルをテキストモードで開く
+    TextWriter *out_fp = tw_open(out_txt_filename); // 出力ファイルを開く
     if (!out_fp)
     {
         perror("fopen output");
+        pcm_close(&pcm);
         return;
     }
 
+    TRACE_BEGIN(t);
     double start_time_ms = (double)start_sample * 1000.0 / SAMPLE_RATE; // セグメントの開始時間をミリ秒で計算
     for (size_t i = 0; i < read_samples; ++i) // 読み込んだサンプル数分ループ
     {
         double time_ms = start_time_ms + i * 1000.0 / SAMPLE_RATE; // 各サンプルの時間をミリ秒で計算
-        fprintf(out_fp, "%.3f %d\n", time_ms, buffer[i]); // 時間とサンプル値を出力ファイルに書き込む
+        tw_fixed(out_fp, time_ms, 3);                              // 時間とサンプル値を出力ファイルに書き込む（"%.3f %d\n"）
+        tw_char(out_fp, ' ');
+        tw_int(out_fp, buffer[i]);
+        tw_char(out_fp, '\n');
     }
 
-    fclose(out_fp); // 出力ファイルを閉じる
+    tw_close(out_fp); // 出力ファイルを閉じる
+    TRACE_END(t, STAGE_WRITE, read_samples);
+    pcm_close(&pcm); // 入力ファイルを閉じる
     printf("Saved %s (%zu samples)\n", out_txt_filename, read_samples); // 保存したファイル名とサンプル数を表示
+
+    if (cache && cache_store_file(cache, key, out_txt_filename) != 0) // 次回のためにキャッシュへ保存
+    {
+        perror("cache store");
+    }
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    const char *cachedir = NULL;
+    long cache_max = CACHE_DEFAULT_MAX;
+    int opt;
+    while ((opt = getopt(argc, argv, "C:S:")) != -1) // -C でキャッシュを選ぶ
+    {
+        switch (opt)
+        {
+        case 'C': cachedir = optarg; break;
+        case 'S': cache_max = (long)(atof(optarg) * (1 << 20)); break;
+        default: argc = 0;
+        }
+    }
+    if (argc == 0)
+    {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] [-C キャッシュディレクトリ [-S 上限MB]]\n", argv[0]);
+        return 1;
+    }
+    if (cachedir && !(cache = cache_open(cachedir, cache_max)))
+    {
+        perror(cachedir);
+        return 1;
+    }
+
     const char *in_files[] = {"a00.raw", "i00.raw", "u00.raw", "e00.raw", "o00.raw"}; // 入力ファイル名
     const char *out_txts[] = {"a00_cut.txt", "i00_cut.txt", "u00_cut.txt", "e00_cut.txt", "o00_cut.txt"}; // 出力ファイル名
 
@@ -82,5 +152,6 @@ int main()
         cut_center_segment(in_files[i], out_txts[i]);
     }
 
+    cache_close(cache);
     return 0;
 }
\ No newline at end of file
@@ -2,46 +2,40 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <stdint.h>
+#include <unistd.h>
 #include "DFT_IDFT_kadai3.h"
+#include "out_io.h" // テキスト／バイナリ出力
 
 
 #define SAMPLE_RATE 16000 // サンプリング周波数を16kHzに設定
 #define N 1024            // データの長さを1024サンプルに設定
 #define K 10              // 周波数成分のインデックスを10に設定
 
+int out_format = OUT_TEXT; // 出力形式（-f txt|bin）
+
 void write_txt(const char *filename, double *data)
 {
-    FILE *fp = fopen(filename, "w");
-    if (!fp)
+    // 2列出力: 周波数[kHz], 値（"%.6f\t%.6f\n"）
+    char name[256];
+    out_filename(name, sizeof(name), filename, out_format);
+    if (out_write_series(name, out_format, data, N, 0.0, (double)SAMPLE_RATE / N / 1000.0, 6, 6, '\t', "kHz", "") != 0)
     {
         perror("fopen");
         exit(1);
     }
-
-    for (int i = 0; i < N; ++i)
-    {
-        double freq_khz = (double)i * SAMPLE_RATE / N / 1000.0; // 周波数[kHz]
-        fprintf(fp, "%.6f\t%.6f\n", freq_khz, data[i]); // 2列出力: 周波数[kHz], 値
-    }
-
-    fclose(fp);
 }
 
 void write_txt_time(const char *filename, double *data)
 {
-    FILE *fp = fopen(filename, "w");
-    if (!fp)
+    // 時間インデックスと値（"%d\t%.6f\n"）
+    char name[256];
+    out_filename(name, sizeof(name), filename, out_format);
+    if (out_write_series(name, out_format, data, N, 0.0, 1.0, -1, 6, '\t', "index", "") != 0)
     {
         perror("fopen");
         exit(1);
     }
-
-    for (int i = 0; i < N; ++i)
-    {
-        fprintf(fp, "%d\t%.6f\n", i, data[i]); // 時間インデックスと値
-    }
-
-    fclose(fp);
 }
 
 void write_raw(const char *filename, double *data) {
@@ -59,8 +53,19 @@ void write_raw(const char *filename, double *data) {
     fclose(fp);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    int opt;
+    while ((opt = getopt(argc, argv, "f:")) != -1) // -f txt|bin で出力形式を選ぶ
+    {
+        if (opt != 'f' || (out_format = out_format_from_name(optarg)) < 0)
+        {
+            fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] [-f txt|bin]\n", argv[0]);
+            return 1;
+        }
+    }
+
     double sin_wave[N] = {0}, cos_wave[N] = {0}; // 正弦波と余弦波の配列を初期化
     double sin_i[N] = {0}, cos_i[N] = {0};       // DFTの虚部を格納する配列を初期化
 
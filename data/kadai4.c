@@ -2,124 +2,181 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "DFT_IDFT_kadai3.h" // 課題3で作成したDFT関数をインクルード
+#include "pcm_io.h"          // rawファイルの読み込み（mmap）
+#include "out_io.h"          // テキスト／バイナリ出力
+#include "result_cache.h"    // 結果キャッシュ
 
 #define SAMPLE_RATE 16000                            // サンプリング周波数 [Hz]
 #define FRAME_MS 20                                  // 切り出す中央フレームの長さ [ms]
 #define FRAME_LENGTH (SAMPLE_RATE * FRAME_MS / 1000) // フレームの標本数 = 320
 #define N 1024                                       // DFT点数
+#define BINS (N / 2 + 1)                             // 実数FFTの出力ビン数（0〜ナイキスト周波数）
+#define OUTPUT_VERSION 1                             // 出力の版（キャッシュのキーに入る．出力が変わったら上げる）
 
 // ハミング窓関数を適用する
 void apply_hamming_window(double *x, int L)
 {
+    TRACE_BEGIN(t);
     for (int n = 0; n < L; ++n)
     {
         // ハミング窓の定義式：w[n] = 0.54 - 0.46 * cos(2πn / (L-1))
         double w = 0.54 - 0.46 * cos(2.0 * M_PI * n / (L - 1));
         x[n] *= w;
     }
+    TRACE_END(t, STAGE_WINDOW, L);
 }
 
 // 対数パワースペクトルを計算する関数（dB単位）
+// xr, xi は実数FFTの出力（0〜N/2 の BINS 本）
 void compute_log_power_spectrum(double *xr, double *xi, double *log_power)
 {
-    for (int k = 0; k < N; ++k)
+    TRACE_BEGIN(t);
+    for (int k = 0; k < BINS; ++k)
     {
         double power = xr[k] * xr[k] + xi[k] * xi[k]; // パワースペクトル = |X[k]|^2
         log_power[k] = 10.0 * log10(power + 1e-12);   // dB変換（log(0)回避のため微小値を加算）
     }
+    TRACE_END(t, STAGE_LOG_POWER, BINS);
 }
 
 // 音声ファイルから中央20msのデータを読み込む関数
 int load_center_frame(const char *filename, double *frame)
 {
-    FILE *fp = fopen(filename, "rb");
-    if (!fp)
+    PCMData pcm;
+    if (pcm_open(filename, &pcm) != 0)
     {
         perror("ファイルオープン失敗");
         return -1;
     }
 
-    // 16bitの整数データを一時的に読み込むためのバッファ
-    short *buffer = (short *)malloc(sizeof(short) * N);
-    memset(buffer, 0, sizeof(short) * N);
-
-    // ファイルサイズからサンプル数を計算
-    fseek(fp, 0, SEEK_END);
-    long filesize = ftell(fp);
-    int total_samples = filesize / sizeof(short);
-
     // 中央FRAME_LENGTHサンプルの開始位置を計算
-    int start = total_samples / 2 - FRAME_LENGTH / 2;
-    fseek(fp, start * sizeof(short), SEEK_SET);
-    fread(buffer, sizeof(short), FRAME_LENGTH, fp);
-
-    // 読み込んだデータをdoubleに変換してframe[]に格納
-    for (int i = 0; i < FRAME_LENGTH; ++i)
+    long total_samples = pcm.length;
+    long start = total_samples / 2 - FRAME_LENGTH / 2;
+    if (start < 0)
     {
-        frame[i] = (double)buffer[i];
+        start = 0;
     }
 
-    // 残りはゼロパディング（長さNまで）
-    for (int i = FRAME_LENGTH; i < N; ++i)
+    // 16bitの整数データをdoubleに変換してframe[]に格納（ファイル末尾を越えた分と残りはゼロパディング）
+    for (int i = 0; i < N; ++i)
     {
-        frame[i] = 0.0;
+        frame[i] = (i < FRAME_LENGTH && start + i < total_samples) ? (double)pcm.samples[start + i] : 0.0;
     }
 
-    free(buffer);
-    fclose(fp);
+    pcm_close(&pcm);
     return 0;
 }
 
 int main(int argc, char *argv[])
 {
-    if (argc != 3)
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    int format = OUT_TEXT; // -f txt|bin で出力形式を選ぶ
+    const char *cachedir = NULL;
+    long cache_max = CACHE_DEFAULT_MAX;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:C:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'f':
+            if ((format = out_format_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        case 'C': cachedir = optarg; break;
+        case 'S': cache_max = (long)(atof(optarg) * (1 << 20)); break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind != 2)
     {
-        fprintf(stderr, "使い方: %s <入力ファイル名.raw> <出力ファイル名.txt>\n", argv[0]);
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] [-f txt|bin] [-C キャッシュディレクトリ [-S 上限MB]] <入力ファイル名.raw> <出力ファイル名>\n", argv[0]);
         return 1;
     }
 
-    const char *input_filename = argv[1];
-    const char *output_filename = argv[2];
+    const char *input_filename = argv[optind];
+    const char *output_filename = argv[optind + 1];
+
+    // 同じ入力・同じパラメータの結果はキャッシュから出す
+    ResultCache *cache = NULL;
+    uint64_t key = 0;
+    if (cachedir)
+    {
+        PCMData pcm;
+        char params[128];
+        if (!(cache = cache_open(cachedir, cache_max)))
+        {
+            perror(cachedir);
+            return 1;
+        }
+        if (pcm_open(input_filename, &pcm) != 0)
+        {
+            perror("ファイルオープン失敗");
+            return 1;
+        }
+        snprintf(params, sizeof(params), "kadai4;v=%d;fmt=%s;fs=%d;L=%d;N=%d;win=hamming", OUTPUT_VERSION,
+                 format == OUT_TEXT ? "txt" : "bin", SAMPLE_RATE, FRAME_LENGTH, N);
+        key = cache_key(pcm.samples, pcm.length, params);
+        pcm_close(&pcm);
+
+        CacheEntry e;
+        if (cache_lookup(cache, key, &e))
+        {
+            int ret = cache_write_file(&e, output_filename);
+            cache_release(&e);
+            cache_close(cache);
+            if (ret != 0)
+            {
+                perror("出力ファイル書き込み失敗");
+                return 1;
+            }
+            printf("%s のスペクトルをキャッシュから %s に出力しました。\n", input_filename, output_filename);
+            return 0;
+        }
+    }
 
-    double xr[N] = {0};  // DFT入力の実部
-    double xi[N] = {0};  // DFT入力の虚部（初期値は0）
-    double log_power[N]; // 対数パワースペクトル
+    double frame[N] = {0};  // 入力フレーム（実信号）
+    double Xr[BINS];        // スペクトルの実部
+    double Xi[BINS];        // スペクトルの虚部
+    double log_power[BINS]; // 対数パワースペクトル
 
     // 音声データを中央20ms分読み込み
-    if (load_center_frame(input_filename, xr) != 0)
+    if (load_center_frame(input_filename, frame) != 0)
     {
         fprintf(stderr, "読み込みエラー: %s\n", input_filename);
         return 1;
     }
 
     // ハミング窓を適用
-    apply_hamming_window(xr, FRAME_LENGTH);
-
-    // 離散フーリエ変換を実行
-    DFT(N, xr, xi);
-
-    // 対数パワースペクトルを計算
-    compute_log_power_spectrum(xr, xi, log_power);
+    apply_hamming_window(frame, FRAME_LENGTH);
 
-    // 出力ファイルを開く
-    FILE *out = fopen(output_filename, "w");
-    if (!out)
+    // 実数FFTを実行（負の周波数は正の周波数の共役なので計算しない）
+    RFFTPlan *plan = rfft_plan_create(N);
+    if (!plan)
     {
-        perror("出力ファイルオープン失敗");
+        fprintf(stderr, "FFTプランの作成に失敗しました\n");
         return 1;
     }
+    rfft_forward(plan, frame, Xr, Xi);
+    rfft_plan_destroy(plan);
 
-    // 出力：1列目=周波数[kHz], 2列目=パワー[dB]
-    for (int k = 0; k < N; ++k)
+    // 対数パワースペクトルを計算
+    compute_log_power_spectrum(Xr, Xi, log_power);
+
+    // 出力：1列目=周波数[kHz], 2列目=パワー[dB]（0〜8kHz，"%f %f\n"）
+    double freq_step = (double)SAMPLE_RATE / N / 1000.0; // kHz単位
+    if (out_write_series(output_filename, format, log_power, BINS, 0.0, freq_step, 6, 6, ' ', "kHz", "dB") != 0)
     {
-        double freq = (double)k * SAMPLE_RATE / N / 1000.0; // kHz単位
-        fprintf(out, "%f %f\n", freq, log_power[k]);
+        perror("出力ファイル書き込み失敗");
+        return 1;
     }
-
-    fclose(out);
     printf("%s のスペクトルを %s に出力しました。\n", input_filename, output_filename);
 
+    if (cache && cache_store_file(cache, key, output_filename) != 0)
+        perror(cachedir);
+    cache_close(cache);
     return 0;
 }
\ No newline at end of file
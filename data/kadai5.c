@@ -2,80 +2,143 @@
 #include <stdlib.h>
 #include <math.h>
 #include <string.h>
+#include <unistd.h>
 
 #include "DFT_IDFT_kadai3.h"  // 課題3のDFT関数をインクルード
+#include "fir_filter.h"       // 低域通過フィルタの係数
+#include "out_io.h"           // テキスト／バイナリ出力
+#include "result_cache.h"     // 結果キャッシュ
 
 #define PI M_PI
 #define CUTOFF 0.4
 #define DFT_SIZE 1024
+#define DFT_BINS (DFT_SIZE / 2 + 1) // 実数FFTの出力ビン数
+#define OUTPUT_VERSION 1 // 出力の版（キャッシュのキーに入る．fir_filter.h・out_io.h を含め出力が変わったら上げる）
+
+int out_format = OUT_TEXT; // 出力形式（-f txt|bin）
+ResultCache *cache = NULL; // 結果キャッシュ（-C dir）
 
 // フィルタ係数 h[n] を計算
 double calc_h(int n, int N) {
-    int mid = N / 2;
-    if (n == mid) {
-        return CUTOFF; // 特異点：sin(0)/0 → CUTOFF
-    } else {
-        double x = PI * (n - mid);
-        return sin(CUTOFF * x) / x;
-    }
+    return sinc_h(n, N, CUTOFF);
 }
 
 // スペクトルを dB に変換して保存
+// xr, xi は実数FFTの出力（0〜size/2 の size/2+1 本）
 void save_spectrum(const char *filename, double *xr, double *xi, int size) {
-    FILE *fp = fopen(filename, "w");
-    if (!fp) {
+    double gain_db[DFT_BINS];
+    for (int k = 0; k < size / 2; ++k) {  // Nyquistまで
+        double magnitude = sqrt(xr[k] * xr[k] + xi[k] * xi[k]);
+        gain_db[k] = 20.0 * log10(magnitude + 1e-12); // log(0)対策
+    }
+
+    // 1列目=正規化周波数 k/(size/2)，2列目=ゲイン[dB]（"%.4f %.4f\n"）
+    if (out_write_series(filename, out_format, gain_db, size / 2, 0.0, 1.0 / (size / 2), 4, 4, ' ', "", "dB") != 0) {
         perror("スペクトルファイル書き込み失敗");
         exit(1);
     }
+}
 
-    for (int k = 0; k < size / 2; ++k) {  // Nyquistまで
-        double magnitude = sqrt(xr[k] * xr[k] + xi[k] * xi[k]);
-        double gain_db = 20.0 * log10(magnitude + 1e-12); // log(0)対策
-        double freq = (double)k / (size / 2);
-        fprintf(fp, "%.4f %.4f\n", freq, gain_db);
-    }
+// 出力ファイルのキャッシュのキー（入力標本はないので出力の版・次数・カットオフ・DFT点数・形式だけで決まる）
+uint64_t output_key(const char *kind, int N) {
+    char params[128];
+    snprintf(params, sizeof(params), "kadai5;%s;v=%d;N=%d;cutoff=%g;dft=%d;fmt=%d", kind, OUTPUT_VERSION, N, CUTOFF, DFT_SIZE, out_format);
+    return cache_key(NULL, 0, params);
+}
 
-    fclose(fp);
+// 両方の出力がキャッシュにあればそのまま書き出して1を返す
+int restore_from_cache(const char *impulse_file, const char *spectrum_file, int N) {
+    CacheEntry impulse, spectrum;
+    if (!cache_lookup(cache, output_key("impulse", N), &impulse))
+        return 0;
+    int ok = cache_lookup(cache, output_key("spectrum", N), &spectrum);
+    if (ok) {
+        if (cache_write_file(&impulse, impulse_file) != 0 || cache_write_file(&spectrum, spectrum_file) != 0) {
+            perror("キャッシュからの書き出し失敗");
+            exit(1);
+        }
+        cache_release(&spectrum);
+    }
+    cache_release(&impulse);
+    return ok;
 }
 
 // N次フィルタの処理（係数保存 & DFT実行）
 void process_filter(int N) {
     char impulse_file[64], spectrum_file[64];
-    sprintf(impulse_file, "impulse_N%d.txt", N);
-    sprintf(spectrum_file, "spectrum_N%d.txt", N);
-
-    double xr[DFT_SIZE] = {0}; // 実部：h[n] + zero-padding
-    double xi[DFT_SIZE] = {0}; // 虚部：0
+    const char *ext = out_format == OUT_BINARY ? "bin" : "txt";
+    sprintf(impulse_file, "impulse_N%d.%s", N, ext);
+    sprintf(spectrum_file, "spectrum_N%d.%s", N, ext);
 
-    // インパルス応答の生成と書き出し
-    FILE *fp = fopen(impulse_file, "w");
-    if (!fp) {
-        perror("係数ファイル書き込み失敗");
-        exit(1);
+    if (cache && restore_from_cache(impulse_file, spectrum_file, N)) {
+        printf("キャッシュから出力: %s, %s\n", impulse_file, spectrum_file);
+        return;
     }
 
+    double h[DFT_SIZE] = {0}; // h[n] + zero-padding
+    double Xr[DFT_BINS];      // スペクトルの実部
+    double Xi[DFT_BINS];      // スペクトルの虚部
+
+    // インパルス応答の生成と書き出し（"%d %.6f\n"）
     for (int n = 0; n <= N; ++n) {
-        xr[n] = calc_h(n, N);
-        fprintf(fp, "%d %.6f\n", n, xr[n]);
+        h[n] = calc_h(n, N);
+    }
+    if (out_write_series(impulse_file, out_format, h, N + 1, 0.0, 1.0, -1, 6, ' ', "n", "") != 0) {
+        perror("係数ファイル書き込み失敗");
+        exit(1);
     }
-    fclose(fp);
     printf("係数ファイルを保存: %s\n", impulse_file);
 
-    // DFTによるスペクトル解析
-    DFT(DFT_SIZE, xr, xi);
+    // 実数FFTによるスペクトル解析
+    static RFFTPlan *plan = NULL; // 全フィルタで同じ長さなので使い回す
+    if (!plan && !(plan = rfft_plan_create(DFT_SIZE))) {
+        fprintf(stderr, "FFTプランの作成に失敗しました\n");
+        exit(1);
+    }
+    rfft_forward(plan, h, Xr, Xi);
 
     // 振幅スペクトルの保存
-    save_spectrum(spectrum_file, xr, xi, DFT_SIZE);
+    save_spectrum(spectrum_file, Xr, Xi, DFT_SIZE);
     printf("スペクトルファイルを保存: %s\n", spectrum_file);
+
+    if (cache && (cache_store_file(cache, output_key("impulse", N), impulse_file) != 0 ||
+                  cache_store_file(cache, output_key("spectrum", N), spectrum_file) != 0)) {
+        perror("キャッシュへの保存失敗");
+    }
 }
 
-int main() {
+int main(int argc, char *argv[]) {
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    const char *cachedir = NULL;
+    long cache_max = CACHE_DEFAULT_MAX;
+    int opt;
+    while ((opt = getopt(argc, argv, "f:C:S:")) != -1) { // -f txt|bin で出力形式，-C でキャッシュを選ぶ
+        switch (opt) {
+        case 'f':
+            if ((out_format = out_format_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        case 'C': cachedir = optarg; break;
+        case 'S': cache_max = (long)(atof(optarg) * (1 << 20)); break;
+        default: argc = 0;
+        }
+    }
+    if (argc == 0) {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] [-f txt|bin] [-C キャッシュディレクトリ [-S 上限MB]]\n", argv[0]);
+        return 1;
+    }
+    if (cachedir && !(cache = cache_open(cachedir, cache_max))) {
+        perror(cachedir);
+        return 1;
+    }
+
     int N_list[] = {100, 500, 1000};
     int num = sizeof(N_list) / sizeof(N_list[0]);
 
     for (int i = 0; i < num; ++i) {
         process_filter(N_list[i]);
     }
+    cache_close(cache);
 
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,316 @@
+#ifndef OUT_IO_H
+#define OUT_IO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "trace.h" // 段階ごとの計時
+
+// 解析結果の出力
+// テキスト: 行ごとの fprintf の代わりに数値を自前で文字列にしてまとめて書き出す（printf と同じ丸め）
+// バイナリ: 小さなヘッダ＋float32 の列データ．軸（時刻・周波数）は等間隔なので開始値と間隔だけを持つ
+
+enum
+{
+    OUT_TEXT,
+    OUT_BINARY
+};
+
+// "txt" / "bin" を出力形式に変換する（不明なら-1）
+int out_format_from_name(const char *name)
+{
+    if (strcmp(name, "txt") == 0)
+        return OUT_TEXT;
+    if (strcmp(name, "bin") == 0)
+        return OUT_BINARY;
+    return -1;
+}
+
+// 出力形式に合わせてファイル名の拡張子 .txt を .bin に置き換える（dstにsizeバイトまで）
+void out_filename(char *dst, size_t size, const char *name, int format)
+{
+    size_t len = strlen(name);
+    if (format == OUT_BINARY && len > 4 && strcmp(name + len - 4, ".txt") == 0)
+        snprintf(dst, size, "%.*s.bin", (int)(len - 4), name);
+    else
+        snprintf(dst, size, "%s", name);
+}
+
+#define TEXT_WRITER_BUFFER (1 << 16)
+
+typedef struct
+{
+    FILE *fp;
+    size_t len;
+    int error;
+    char buf[TEXT_WRITER_BUFFER];
+} TextWriter;
+
+TextWriter *tw_open(const char *filename)
+{
+    TextWriter *w = (TextWriter *)malloc(sizeof(TextWriter));
+    if (!w)
+        return NULL;
+    w->fp = strcmp(filename, "-") == 0 ? stdout : fopen(filename, "w");
+    if (!w->fp)
+    {
+        free(w);
+        return NULL;
+    }
+    w->len = 0;
+    w->error = 0;
+    return w;
+}
+
+void tw_flush(TextWriter *w)
+{
+    if (w->len > 0 && fwrite(w->buf, 1, w->len, w->fp) != w->len)
+        w->error = 1;
+    w->len = 0;
+}
+
+// 書き込みに失敗していれば-1を返す
+int tw_close(TextWriter *w)
+{
+    tw_flush(w);
+    int ret = w->error ? -1 : 0;
+    if (w->fp == stdout)
+        ret |= fflush(stdout) ? -1 : 0;
+    else
+        ret |= fclose(w->fp) ? -1 : 0;
+    free(w);
+    return ret;
+}
+
+// nバイトの空きを確保して書き込み位置を返す
+char *tw_reserve(TextWriter *w, size_t n)
+{
+    if (w->len + n > TEXT_WRITER_BUFFER)
+        tw_flush(w);
+    return w->buf + w->len;
+}
+
+void tw_char(TextWriter *w, char c)
+{
+    *tw_reserve(w, 1) = c;
+    w->len++;
+}
+
+// 整数（"%ld"）
+void tw_int(TextWriter *w, long v)
+{
+    char *start = tw_reserve(w, 24), *p = start;
+    char tmp[24];
+    int n = 0;
+    unsigned long u = v < 0 ? 0UL - (unsigned long)v : (unsigned long)v;
+    do
+    {
+        tmp[n++] = (char)('0' + u % 10);
+        u /= 10;
+    } while (u);
+    if (v < 0)
+        *p++ = '-';
+    while (n)
+        *p++ = tmp[--n];
+    w->len += (size_t)(p - start);
+}
+
+// 積 a*b を丸めた値 p と丸め誤差 e（a*b = p + e が正確に成り立つ）に分ける（Dekkerの方法）
+void two_product(double a, double b, double *p, double *e)
+{
+    const double split = 134217729.0; // 2^27 + 1
+    double ca = split * a, cb = split * b;
+    double ah = ca - (ca - a), al = a - ah;
+    double bh = cb - (cb - b), bl = b - bh;
+    *p = a * b;
+    *e = ((ah * bh - *p) + ah * bl + al * bh) + al * bl;
+}
+
+// 固定小数点（"%.*f"，decimals は 0〜9）
+// |v|·10^decimals の丸め誤差まで考慮して整数に丸める（ちょうど半分なら偶数側．printf と同じ結果になる）
+void tw_fixed(TextWriter *w, double v, int decimals)
+{
+    static const double pow10[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9};
+    char *p = tw_reserve(w, 64);
+
+    double scaled, err;
+    two_product(fabs(v), pow10[decimals], &scaled, &err);
+    if (!(scaled < 4e15)) // 大きな値・無限大・NaN は snprintf に任せる
+    {
+        int n = snprintf(p, 64, "%.*f", decimals, v);
+        w->len += (size_t)(n < 64 ? n : 63);
+        return;
+    }
+
+    double fl = floor(scaled);
+    double d = (scaled - fl - 0.5) + err; // 真の小数部 - 0.5 の符号
+    uint64_t r = (uint64_t)fl;
+    if (d > 0 || (d == 0 && (r & 1)))
+        r++;
+    uint64_t ip = r, fp = 0;
+    if (decimals > 0)
+    {
+        uint64_t div = (uint64_t)pow10[decimals];
+        ip = r / div;
+        fp = r % div;
+    }
+
+    char *start = p;
+    if (signbit(v)) // printf は負の値が 0 に丸められても "-0.000" と書く
+        *p++ = '-';
+    char tmp[24];
+    int n = 0;
+    do
+    {
+        tmp[n++] = (char)('0' + ip % 10);
+        ip /= 10;
+    } while (ip);
+    while (n)
+        *p++ = tmp[--n];
+    if (decimals > 0)
+    {
+        *p++ = '.';
+        for (int i = decimals - 1; i >= 0; --i)
+        {
+            p[i] = (char)('0' + fp % 10);
+            fp /= 10;
+        }
+        p += decimals;
+    }
+    w->len += (size_t)(p - start);
+}
+
+// バイナリ列形式
+// ファイル = ColumnHeader，列0の値 × rows，列1の値 × rows，…（float32，リトルエンディアン）
+// 行iの軸の値は axis_start + i * axis_step
+#define COLUMN_MAGIC "COLS"
+#define COLUMN_VERSION 1
+
+typedef struct
+{
+    char magic[4];        // "COLS"
+    int32_t version;      // COLUMN_VERSION
+    int32_t rows;         // 行数
+    int32_t columns;      // 値の列数
+    double axis_start;    // 軸の開始値
+    double axis_step;     // 軸の間隔
+    char axis_unit[16];   // 軸の単位（例: "ms", "kHz"）
+    char value_unit[16];  // 値の単位（例: "dB"）
+} ColumnHeader;
+
+typedef struct
+{
+    FILE *fp;
+    long remaining; // まだ書いていない値の数
+    int error;
+} ColumnWriter;
+
+// 列は0番から順に，各列 rows 個ずつ col_write で書き込む
+ColumnWriter *col_open(const char *filename, long rows, int columns, double axis_start, double axis_step,
+                       const char *axis_unit, const char *value_unit)
+{
+    ColumnWriter *c = (ColumnWriter *)calloc(1, sizeof(ColumnWriter));
+    if (!c)
+        return NULL;
+    c->fp = fopen(filename, "wb");
+    if (!c->fp)
+    {
+        free(c);
+        return NULL;
+    }
+
+    ColumnHeader h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, COLUMN_MAGIC, 4);
+    h.version = COLUMN_VERSION;
+    h.rows = (int32_t)rows;
+    h.columns = columns;
+    h.axis_start = axis_start;
+    h.axis_step = axis_step;
+    strncpy(h.axis_unit, axis_unit, sizeof(h.axis_unit) - 1);
+    strncpy(h.value_unit, value_unit, sizeof(h.value_unit) - 1);
+    if (fwrite(&h, sizeof(h), 1, c->fp) != 1)
+        c->error = 1;
+    c->remaining = rows * columns;
+    return c;
+}
+
+void col_write(ColumnWriter *c, const float *values, long n)
+{
+    TRACE_BEGIN(t);
+    if (fwrite(values, sizeof(float), n, c->fp) != (size_t)n)
+        c->error = 1;
+    c->remaining -= n;
+    TRACE_END(t, STAGE_WRITE, n);
+}
+
+// double の値を float32 にして書き込む
+void col_write_double(ColumnWriter *c, const double *values, long n)
+{
+    float buf[1024];
+    for (long i = 0; i < n; i += 1024)
+    {
+        long m = n - i < 1024 ? n - i : 1024;
+        for (long j = 0; j < m; ++j)
+            buf[j] = (float)values[i + j];
+        col_write(c, buf, m);
+    }
+}
+
+// 書き込みに失敗したか値の数が足りなければ-1を返す
+int col_close(ColumnWriter *c)
+{
+    int ret = (c->error || c->remaining != 0) ? -1 : 0;
+    ret |= fclose(c->fp) ? -1 : 0;
+    free(c);
+    return ret;
+}
+
+// out_write_series の本体（計時なし）
+int out_write_series_file(const char *filename, int format, const double *values, long rows,
+                          double axis_start, double axis_step, int axis_decimals, int value_decimals, char sep,
+                          const char *axis_unit, const char *value_unit)
+{
+    if (format == OUT_BINARY)
+    {
+        ColumnWriter *c = col_open(filename, rows, 1, axis_start, axis_step, axis_unit, value_unit);
+        if (!c)
+            return -1;
+        col_write_double(c, values, rows);
+        return col_close(c);
+    }
+
+    TextWriter *w = tw_open(filename);
+    if (!w)
+        return -1;
+    for (long i = 0; i < rows; ++i)
+    {
+        if (axis_decimals < 0)
+            tw_int(w, (long)(axis_start + i * axis_step));
+        else
+            tw_fixed(w, axis_start + i * axis_step, axis_decimals);
+        tw_char(w, sep);
+        tw_fixed(w, values[i], value_decimals);
+        tw_char(w, '\n');
+    }
+    return tw_close(w);
+}
+
+// 等間隔の軸を持つ1列のデータを書き出す
+// テキストなら1行に "軸の値<sep>値"（axis_decimals < 0 なら軸は整数，それ以外は "%.*f"）
+// バイナリなら ColumnHeader＋float32 値
+int out_write_series(const char *filename, int format, const double *values, long rows,
+                     double axis_start, double axis_step, int axis_decimals, int value_decimals, char sep,
+                     const char *axis_unit, const char *value_unit)
+{
+    TRACE_BEGIN(t);
+    int ret = out_write_series_file(filename, format, values, rows, axis_start, axis_step, axis_decimals,
+                                    value_decimals, sep, axis_unit, value_unit);
+    TRACE_END(t, STAGE_WRITE, ret == 0 ? rows : 0); // 開けなかったときも区間は閉じる
+    return ret;
+}
+
+#endif
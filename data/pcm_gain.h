@@ -0,0 +1,147 @@
+#ifndef PCM_GAIN_H
+#define PCM_GAIN_H
+
+#include <math.h>
+#include <string.h>
+
+// 16bit PCM と float の一括変換・ゲイン・飽和処理
+// GCC/Clang のベクトル拡張で8標本ずつ処理し，端数だけ逐次処理する．
+// float → int16 は [-32768, 32767] に飽和させ，0から遠い方へ丸める．
+
+typedef float pcm_v8f __attribute__((vector_size(32)));
+typedef int pcm_v8i __attribute__((vector_size(32)));
+typedef short pcm_v8s __attribute__((vector_size(16)));
+
+// マスクが立っている要素はa，それ以外はbを選ぶ
+#define PCM_V8F_SELECT(mask, a, b) ((pcm_v8f)(((mask) & (pcm_v8i)(a)) | (~(mask) & (pcm_v8i)(b))))
+
+// 8標本を飽和・丸めして int16 で out に書き込む
+// （32バイトのベクトルを値渡しすると AVX なしの x86 で ABI 警告が出るのでポインタで受け取る）
+static inline void pcm_store_v8f(short *out, const pcm_v8f *in)
+{
+    const pcm_v8f hi = {32767, 32767, 32767, 32767, 32767, 32767, 32767, 32767};
+    const pcm_v8f lo = -hi - 1.0f;
+    const pcm_v8f half = {0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f, 0.5f};
+    pcm_v8f v = *in;
+    v = PCM_V8F_SELECT(v > hi, hi, v);
+    v = PCM_V8F_SELECT(v < lo, lo, v);
+    v += PCM_V8F_SELECT(v < 0, -half, half);
+    pcm_v8s s = __builtin_convertvector(__builtin_convertvector(v, pcm_v8i), pcm_v8s);
+    memcpy(out, &s, sizeof(s));
+}
+
+// 1標本版（端数処理用）
+short pcm_float_to_short(float v)
+{
+    if (v > 32767.0f)
+        return 32767;
+    if (v < -32768.0f)
+        return -32768;
+    return (short)(v < 0 ? v - 0.5f : v + 0.5f);
+}
+
+// int16 → float
+void pcm_to_float(const short *in, float *out, long n)
+{
+    long i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        pcm_v8s s;
+        memcpy(&s, in + i, sizeof(s));
+        pcm_v8f f = __builtin_convertvector(s, pcm_v8f);
+        memcpy(out + i, &f, sizeof(f));
+    }
+    for (; i < n; ++i)
+        out[i] = (float)in[i];
+}
+
+// float → int16（飽和）
+void float_to_pcm(const float *in, short *out, long n)
+{
+    long i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        pcm_v8f f;
+        memcpy(&f, in + i, sizeof(f));
+        pcm_store_v8f(out + i, &f);
+    }
+    for (; i < n; ++i)
+        out[i] = pcm_float_to_short(in[i]);
+}
+
+// int16 をgain倍して int16 に戻す（int16 → float → 乗算 → 飽和を1回で行う．in と out は同じでもよい）
+void pcm_apply_gain(const short *in, short *out, long n, float gain)
+{
+    const pcm_v8f g = {gain, gain, gain, gain, gain, gain, gain, gain};
+    long i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        pcm_v8s s;
+        memcpy(&s, in + i, sizeof(s));
+        pcm_v8f f = __builtin_convertvector(s, pcm_v8f) * g;
+        pcm_store_v8f(out + i, &f);
+    }
+    for (; i < n; ++i)
+        out[i] = pcm_float_to_short(in[i] * gain);
+}
+
+// 1回の走査でピーク（絶対値の最大）と二乗和を求める
+void pcm_measure(const short *in, long n, int *peak, double *sum_squares)
+{
+    pcm_v8i vmax = {0};
+    double sum = 0.0;
+    long i = 0;
+    while (i + 8 <= n)
+    {
+        // float の部分和は精度が落ちないように4096標本ごとに double へ足し込む
+        pcm_v8f acc = {0};
+        long end = i + 4096 < n ? i + 4096 : n;
+        for (; i + 8 <= end; i += 8)
+        {
+            pcm_v8s s;
+            memcpy(&s, in + i, sizeof(s));
+            pcm_v8i v = __builtin_convertvector(s, pcm_v8i);
+            v = (v ^ (v >> 31)) - (v >> 31); // 絶対値
+            vmax = (vmax & (vmax > v)) | (v & ~(vmax > v));
+            pcm_v8f f = __builtin_convertvector(v, pcm_v8f);
+            acc += f * f;
+        }
+        for (int k = 0; k < 8; ++k)
+            sum += acc[k];
+    }
+
+    int m = 0;
+    for (int k = 0; k < 8; ++k)
+        m = vmax[k] > m ? vmax[k] : m;
+    for (; i < n; ++i)
+    {
+        int v = in[i] < 0 ? -in[i] : in[i];
+        m = v > m ? v : m;
+        sum += (double)in[i] * in[i];
+    }
+    *peak = m;
+    *sum_squares = sum;
+}
+
+// ピークを target_db [dBFS] にするゲイン（無音なら1）
+float pcm_peak_gain(const short *in, long n, double target_db)
+{
+    int peak;
+    double sum;
+    pcm_measure(in, n, &peak, &sum);
+    return peak > 0 ? (float)(32767.0 * pow(10.0, target_db / 20.0) / peak) : 1.0f;
+}
+
+// 実効値を target_db [dBFS]（フルスケール正弦波 = 0dB とせず，32767 を 0dB とする）にするゲイン（無音なら1）
+float pcm_rms_gain(const short *in, long n, double target_db)
+{
+    int peak;
+    double sum;
+    pcm_measure(in, n, &peak, &sum);
+    if (n <= 0 || sum <= 0.0)
+        return 1.0f;
+    double rms = sqrt(sum / n);
+    return (float)(32767.0 * pow(10.0, target_db / 20.0) / rms);
+}
+
+#endif
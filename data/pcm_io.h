@@ -0,0 +1,331 @@
+#ifndef PCM_IO_H
+#define PCM_IO_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "trace.h" // 段階ごとの計時
+
+// 16bitモノラルrawファイルの逐次読み込み
+// ファイル全体をメモリに載せず，固定長のバッファ単位で読み進める（"-" なら標準入力）
+#define PCM_STREAM_BUFFER (1 << 16) // stdioバッファの大きさ [バイト]
+
+typedef struct
+{
+    FILE *fp;
+    int is_stdin; // 標準入力なら1（closeしない）
+} PCMStream;
+
+PCMStream *pcm_stream_open(const char *filename)
+{
+    PCMStream *s = (PCMStream *)calloc(1, sizeof(PCMStream));
+    if (!s)
+        return NULL;
+
+    if (strcmp(filename, "-") == 0)
+    {
+        s->fp = stdin;
+        s->is_stdin = 1;
+    }
+    else
+    {
+        s->fp = fopen(filename, "rb");
+        if (!s->fp)
+        {
+            free(s);
+            return NULL;
+        }
+    }
+    setvbuf(s->fp, NULL, _IOFBF, PCM_STREAM_BUFFER);
+    return s;
+}
+
+// 最大n標本を読み込み，実際に読めた標本数を返す（0ならファイル終端）
+size_t pcm_stream_read(PCMStream *s, short *buf, size_t n)
+{
+    TRACE_BEGIN(t);
+    size_t got = fread(buf, sizeof(short), n, s->fp);
+    TRACE_END(t, STAGE_READ, got);
+    return got;
+}
+
+void pcm_stream_close(PCMStream *s)
+{
+    if (!s)
+        return;
+    if (!s->is_stdin)
+        fclose(s->fp);
+    free(s);
+}
+
+// 録音全体への読み取り専用アクセス
+// 通常ファイルは mmap するのでコピーせず一定時間で開け，実際に触れたページだけが読み込まれる．
+// パイプや標準入力（"-"）は mmap できないので，逐次読み込みでメモリにコピーする．
+// 先頭が RIFF/WAVE ならヘッダを読み飛ばす（16bitモノラルPCMのみ対応）．
+// 標本はリトルエンディアンのままホストの short として扱う．
+typedef struct
+{
+    const short *samples; // 標本列
+    long length;          // 標本数
+    int sample_rate;      // WAVヘッダの標本化周波数（rawなら0）
+    void *map;            // mmapした領域（なければNULL）
+    size_t map_size;
+    short *owned;         // コピーした場合のバッファ
+} PCMData;
+
+uint32_t pcm_le32(const unsigned char *p)
+{
+    return (uint32_t)p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// WAVヘッダを解析してデータ部の位置と大きさ[バイト]を求める
+// WAVなら1，WAVでなければ0，対応していない形式なら-1を返す
+int wav_parse_header(const unsigned char *p, size_t size, size_t *offset, size_t *bytes, int *sample_rate)
+{
+    if (size < 12 || memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0)
+        return 0;
+
+    int have_fmt = 0;
+    size_t pos = 12;
+    while (pos + 8 <= size)
+    {
+        size_t chunk = pcm_le32(p + pos + 4);
+        const unsigned char *body = p + pos + 8;
+        if (memcmp(p + pos, "fmt ", 4) == 0 && chunk >= 16 && pos + 8 + 16 <= size)
+        {
+            int format = body[0] | body[1] << 8;
+            int channels = body[2] | body[3] << 8;
+            int bits = body[14] | body[15] << 8;
+            if ((format != 1 && format != 0xFFFE) || channels != 1 || bits != 16)
+                return -1;
+            *sample_rate = (int)pcm_le32(body + 4);
+            have_fmt = 1;
+        }
+        else if (memcmp(p + pos, "data", 4) == 0)
+        {
+            if (!have_fmt)
+                return -1;
+            *offset = pos + 8;
+            if (chunk == 0 || chunk == 0xFFFFFFFFu) // 録音中に書かれた長さ未記入のヘッダは末尾までとみなす
+                chunk = size - *offset;
+            *bytes = chunk < size - *offset ? chunk : size - *offset; // 途中で切れたファイルも読めるだけ読む
+            return 1;
+        }
+        pos += 8 + chunk + (chunk & 1); // チャンクは偶数バイト境界に揃う
+    }
+    return -1;
+}
+
+void pcm_close(PCMData *pcm)
+{
+    if (pcm->map)
+        munmap(pcm->map, pcm->map_size);
+    free(pcm->owned);
+    memset(pcm, 0, sizeof(*pcm));
+}
+
+// パイプ・標準入力用：全体をメモリに読み込む
+int pcm_read_stream(const char *filename, unsigned char **data, size_t *size)
+{
+    PCMStream *s = pcm_stream_open(filename);
+    if (!s)
+        return -1;
+
+    size_t cap = 1 << 16, len = 0;
+    unsigned char *buf = (unsigned char *)malloc(cap);
+    while (buf)
+    {
+        size_t got = fread(buf + len, 1, cap - len, s->fp);
+        len += got;
+        if (got == 0)
+            break;
+        if (len == cap)
+        {
+            cap *= 2;
+            unsigned char *grown = (unsigned char *)realloc(buf, cap);
+            if (!grown)
+                free(buf);
+            buf = grown;
+        }
+    }
+    pcm_stream_close(s);
+
+    *data = buf;
+    *size = len;
+    return buf ? 0 : -1;
+}
+
+// pcm_open の本体（計時なし．途中で失敗して戻っても計時の区間が閉じ忘れにならないように分けてある）
+int pcm_open_file(const char *filename, PCMData *pcm)
+{
+    memset(pcm, 0, sizeof(*pcm));
+
+    const unsigned char *bytes = NULL;
+    size_t size = 0;
+    struct stat st;
+    int fd = -1;
+
+    if (strcmp(filename, "-") != 0 && (fd = open(filename, O_RDONLY)) < 0)
+        return -1;
+
+    if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode))
+    {
+        size = (size_t)st.st_size;
+        if (size > 0)
+        {
+            void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (map == MAP_FAILED)
+            {
+                close(fd);
+                return -1;
+            }
+            pcm->map = map;
+            pcm->map_size = size;
+            bytes = (const unsigned char *)map;
+        }
+        close(fd);
+    }
+    else
+    {
+        if (fd >= 0)
+            close(fd);
+        unsigned char *data;
+        if (pcm_read_stream(filename, &data, &size) != 0)
+            return -1;
+        pcm->owned = (short *)data;
+        bytes = data;
+    }
+
+    size_t offset = 0, data_bytes = size;
+    int wav = bytes ? wav_parse_header(bytes, size, &offset, &data_bytes, &pcm->sample_rate) : 0;
+    if (wav < 0)
+    {
+        fprintf(stderr, "%s: 16bitモノラルPCM以外のWAVには対応していません\n", filename);
+        pcm_close(pcm);
+        errno = EINVAL; // 呼び出し側の perror が "Success" を出さないように
+        return -1;
+    }
+
+    pcm->length = (long)(data_bytes / sizeof(short));
+    if (offset % sizeof(short) == 0)
+    {
+        pcm->samples = (const short *)(bytes + offset);
+    }
+    else // データ部が奇数番地から始まるときだけコピーする
+    {
+        short *copy = (short *)malloc(sizeof(short) * (pcm->length ? pcm->length : 1));
+        if (!copy)
+        {
+            pcm_close(pcm);
+            return -1;
+        }
+        memcpy(copy, bytes + offset, sizeof(short) * pcm->length);
+        if (pcm->map)
+        {
+            munmap(pcm->map, pcm->map_size);
+            pcm->map = NULL;
+        }
+        free(pcm->owned);
+        pcm->owned = copy;
+        pcm->samples = copy;
+    }
+    return 0;
+}
+
+// ファイルを開いて標本列を得る（成功なら0，失敗なら-1でerrnoまたはメッセージを残す）
+int pcm_open(const char *filename, PCMData *pcm)
+{
+    TRACE_BEGIN(t);
+    int ret = pcm_open_file(filename, pcm);
+    TRACE_END(t, STAGE_READ, pcm->length); // 失敗したときも区間は閉じる（length は0）
+    return ret;
+}
+
+// 入力ファイル名の一覧
+typedef struct
+{
+    char **paths;
+    int count;
+    int cap;
+} RawFileList;
+
+int ends_with_raw(const char *name)
+{
+    size_t len = strlen(name);
+    return len > 4 && strcmp(name + len - 4, ".raw") == 0;
+}
+
+// 一覧に1件追加する
+void raw_list_add(RawFileList *l, const char *path)
+{
+    if (l->count == l->cap)
+    {
+        l->cap = l->cap ? l->cap * 2 : 64;
+        l->paths = (char **)realloc(l->paths, sizeof(char *) * l->cap);
+        if (!l->paths)
+        {
+            perror("realloc");
+            exit(1);
+        }
+    }
+    l->paths[l->count++] = strdup(path);
+}
+
+int raw_list_compare(const void *a, const void *b)
+{
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+// ディレクトリならその中の .raw を名前順に，ファイルならそのまま追加する
+void raw_list_collect(RawFileList *l, const char *path)
+{
+    struct stat st;
+    if (stat(path, &st) != 0)
+    {
+        perror(path);
+        return;
+    }
+    if (!S_ISDIR(st.st_mode))
+    {
+        raw_list_add(l, path);
+        return;
+    }
+
+    DIR *dir = opendir(path);
+    if (!dir)
+    {
+        perror(path);
+        return;
+    }
+    int first = l->count;
+    struct dirent *ent;
+    while ((ent = readdir(dir)) != NULL)
+    {
+        if (!ends_with_raw(ent->d_name))
+            continue;
+        char full[4096];
+        snprintf(full, sizeof(full), "%s/%s", path, ent->d_name);
+        raw_list_add(l, full);
+    }
+    closedir(dir);
+    qsort(l->paths + first, l->count - first, sizeof(char *), raw_list_compare);
+}
+
+void raw_list_free(RawFileList *l)
+{
+    for (int i = 0; i < l->count; ++i)
+        free(l->paths[i]);
+    free(l->paths);
+    l->paths = NULL;
+    l->count = l->cap = 0;
+}
+
+#endif
@@ -0,0 +1,991 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "stft.h"       // 窓関数・実数FFT・スペクトログラム形式・rawファイルの逐次読み込み
+#include "fir_filter.h" // FIRフィルタ
+#include "vad.h"        // 音声区間検出
+#include "out_io.h"     // テキスト出力
+#include "pcm_gain.h"   // float → int16 の飽和
+#include "spsc_ring.h"  // スレッド間の受け渡し
+
+// 処理段階をつないだパイプラインを1つのプロセスの中で実行する
+//   例: ./pipeline 'read a00.raw | vad | window hamming 320 | fft 1024 | logpower | write bin a00.bin'
+// 各段階は作成時に確保した出力バッファを次の段階に渡すだけで，途中でテキストやファイルを介さない．
+// 段階名の前に @ を付けた段階（-T なら全段階）は自分のスレッドで動き，前の段階とはリングバッファでつながる．
+//
+// 段階（入力 → 出力）:
+//   read [ファイル|-]                    → 標本列（PIPE_BLOCK 標本ずつ）
+//   vad                         標本列 → 標本列（音声区間だけを通す．時刻は元のまま）
+//   center <標本数>             標本列 → 標本列（最も長い連続区間の中央だけ．kadai4 と同じ位置）
+//   fir <次数> [遮断周波数] [窓]  標本列 → 標本列（kadai5 の低域通過フィルタ）
+//   window <窓> <長さ> [シフト]  標本列 → フレーム（シフトの既定は長さの半分）
+//   fft <点数>                 フレーム → スペクトル（実数FFT，フレーム長を超えた分はゼロ詰め）
+//   logpower                 スペクトル → パワー [dB]
+//   write txt|bin [ファイル|-]  標本列・パワー → ファイル
+//     標本列: txt は kadai1-convert と同じ "時刻[ms] 標本値"，bin は16bit raw
+//     パワー: txt は kadai4 と同じ "周波数[kHz] パワー[dB]"（フレームの間は空行），bin は stft と同じスペクトログラム形式
+
+#define SAMPLE_RATE 16000
+#define PIPE_BLOCK 4096     // read が1回に出す標本数
+#define PIPE_MAX_STAGES 16
+#define PIPE_MAX_ARGS 8
+#define PIPE_RING_SLOTS 16  // スレッド境界のリングバッファの要素数
+#define PIPE_IDLE_NS 50000  // リングバッファが空・満杯のときの待ち時間 [ns]
+
+// 段階の間を流れるデータの種類
+enum
+{
+    PIPE_SAMPLES,  // 標本列（長さは可変）
+    PIPE_FRAME,    // 窓を掛けたフレーム
+    PIPE_SPECTRUM, // 複素スペクトル（非負周波数）
+    PIPE_POWER     // 対数パワースペクトル [dB]
+};
+static const char *const pipe_kind_names[] = {"標本列", "フレーム", "スペクトル", "パワー"};
+
+// データの形式（組み立て時に上流から下流へ伝える）
+typedef struct
+{
+    int kind;
+    int max_length; // 1バッファの値の最大数
+    int sample_rate, frame_length, hop, fft_size;
+} PipeFormat;
+
+typedef struct
+{
+    long length;     // 値の数
+    long index;      // 先頭の標本の番号（フレームならフレームの先頭）
+    double *re, *im; // 値（im は複素スペクトルのみ）
+} PipeBuffer;
+
+// スレッド境界のリングバッファの1要素（この後ろに re[max_length], im[max_length] が続く）
+typedef struct
+{
+    long length, index;
+    int eof;
+} PipeSlot;
+
+typedef struct Stage Stage;
+struct Stage
+{
+    const char *name;
+    PipeFormat in, out;
+    PipeBuffer buf; // 出力バッファ（作成時に確保して使い回す）
+    Stage *next;
+    int (*push)(Stage *s, const PipeBuffer *in); // 入力を処理して pipe_emit で次に渡す（失敗なら非0）
+    int (*finish)(Stage *s);                     // 入力の終わり．残りを出して pipe_finish を呼ぶ
+    void (*destroy)(Stage *s);
+    void *state;
+
+    int threaded;  // 自分のスレッドで動く
+    SPSCRing *ring; // 前の段階からの入力（threaded のとき）
+    pthread_t thread;
+    int result;
+};
+
+const struct timespec pipe_idle = {0, PIPE_IDLE_NS};
+
+// 出力バッファを確保する（im は複素スペクトルのときだけ）
+int pipe_alloc_output(Stage *s)
+{
+    s->buf.re = (double *)calloc(s->out.max_length, sizeof(double));
+    if (s->out.kind == PIPE_SPECTRUM)
+        s->buf.im = (double *)calloc(s->out.max_length, sizeof(double));
+    return (!s->buf.re || (s->out.kind == PIPE_SPECTRUM && !s->buf.im)) ? -1 : 0;
+}
+
+// b を次の段階に渡す．次がスレッドで動くならリングバッファにコピーする
+int pipe_emit(Stage *s, const PipeBuffer *b)
+{
+    Stage *n = s->next;
+    if (!n)
+        return 0;
+    if (!n->threaded)
+        return n->push(n, b);
+
+    PipeSlot *slot;
+    while (!(slot = (PipeSlot *)spsc_reserve(n->ring)))
+        nanosleep(&pipe_idle, NULL);
+    double *re = (double *)(slot + 1), *im = re + n->in.max_length;
+    slot->length = b->length;
+    slot->index = b->index;
+    slot->eof = 0;
+    memcpy(re, b->re, sizeof(double) * b->length);
+    if (b->im)
+        memcpy(im, b->im, sizeof(double) * b->length);
+    spsc_commit(n->ring);
+    return 0;
+}
+
+// 次の段階に入力の終わりを伝える
+int pipe_finish(Stage *s)
+{
+    Stage *n = s->next;
+    if (!n)
+        return 0;
+    if (!n->threaded)
+        return n->finish(n);
+
+    PipeSlot *slot;
+    while (!(slot = (PipeSlot *)spsc_reserve(n->ring)))
+        nanosleep(&pipe_idle, NULL);
+    slot->length = 0;
+    slot->eof = 1;
+    spsc_commit(n->ring);
+    return 0;
+}
+
+// スレッドで動く段階: リングバッファから取り出して push し，終わりが来たら finish する
+void *pipe_thread_main(void *arg)
+{
+    Stage *s = (Stage *)arg;
+    for (;;)
+    {
+        PipeSlot *slot = (PipeSlot *)spsc_peek(s->ring);
+        if (!slot)
+        {
+            nanosleep(&pipe_idle, NULL);
+            continue;
+        }
+        if (slot->eof)
+        {
+            spsc_release(s->ring);
+            s->result |= s->finish(s);
+            break;
+        }
+        double *re = (double *)(slot + 1);
+        PipeBuffer view = {slot->length, slot->index, re, s->in.kind == PIPE_SPECTRUM ? re + s->in.max_length : NULL};
+        s->result |= s->push(s, &view); // 失敗しても上流が止まらないように読み続ける
+        spsc_release(s->ring);
+    }
+    return NULL;
+}
+
+// ---- read ----
+
+typedef struct
+{
+    PCMStream *in;
+    short *pcm;
+} ReadState;
+
+int read_run(Stage *s)
+{
+    ReadState *st = (ReadState *)s->state;
+    int ret = 0;
+    size_t got;
+    while (ret == 0 && (got = pcm_stream_read(st->in, st->pcm, PIPE_BLOCK)) > 0)
+    {
+        for (size_t i = 0; i < got; ++i)
+            s->buf.re[i] = st->pcm[i];
+        s->buf.length = (long)got;
+        ret = pipe_emit(s, &s->buf);
+        s->buf.index += (long)got;
+    }
+    return ret | pipe_finish(s);
+}
+
+void read_destroy(Stage *s)
+{
+    ReadState *st = (ReadState *)s->state;
+    pcm_stream_close(st->in);
+    free(st->pcm);
+}
+
+int read_create(Stage *s, int argc, char **argv)
+{
+    const char *filename = argc > 1 ? argv[1] : "-";
+    ReadState *st = (ReadState *)calloc(1, sizeof(ReadState));
+    if (!st || !(st->pcm = (short *)malloc(sizeof(short) * PIPE_BLOCK)) || !(st->in = pcm_stream_open(filename)))
+    {
+        perror(filename);
+        return -1;
+    }
+    s->state = st;
+    s->destroy = read_destroy;
+    s->out.kind = PIPE_SAMPLES;
+    s->out.max_length = PIPE_BLOCK;
+    return 0;
+}
+
+// ---- vad ----
+// 10ms ごとに判定し，区間中のフレームをそのまま通す．区間の開始が確定したときは
+// 開始位置（前のマージンを含む）までさかのぼって出すので，直近の数フレームを持っておく．
+
+typedef struct
+{
+    VAD vad;
+    int frame_length;
+    short *frame;    // 判定中のフレーム
+    int filled;
+    double *history; // 直近 capacity 標本（history[0] の番号は history_start）
+    long history_start;
+    int history_length, capacity;
+    long position;   // これまでに判定した標本数
+    long offset;     // 入力の標本番号 = position + offset
+    int started;
+} VADState;
+
+int vad_flush_frame(Stage *s, int n)
+{
+    VADState *st = (VADState *)s->state;
+
+    // 履歴に足す（あふれた分は古い方から捨てる）
+    if (st->history_length + n > st->capacity)
+    {
+        int drop = st->history_length + n - st->capacity;
+        memmove(st->history, st->history + drop, sizeof(double) * (st->history_length - drop));
+        st->history_length -= drop;
+        st->history_start += drop;
+    }
+    for (int i = 0; i < n; ++i)
+        st->history[st->history_length + i] = st->frame[i];
+    st->history_length += n;
+
+    VADSegment seg;
+    int was_speech = st->vad.in_speech;
+    int event = vad_push_frame(&st->vad, st->frame, n, &seg);
+    st->position += n;
+
+    long from;
+    if (event == VAD_START)
+        from = seg.start > st->history_start ? seg.start : st->history_start;
+    else if (was_speech) // 区間中（終了を確定したフレームまで区間に含まれる）
+        from = st->position - n;
+    else
+        return 0;
+
+    long count = st->position - from;
+    memcpy(s->buf.re, st->history + (from - st->history_start), sizeof(double) * count);
+    s->buf.length = count;
+    s->buf.index = from + st->offset;
+    return pipe_emit(s, &s->buf);
+}
+
+int vad_stage_push(Stage *s, const PipeBuffer *in)
+{
+    VADState *st = (VADState *)s->state;
+    if (!st->started)
+    {
+        st->offset = in->index;
+        st->started = 1;
+    }
+    int ret = 0;
+    for (long i = 0; i < in->length && ret == 0; ++i)
+    {
+        st->frame[st->filled++] = pcm_float_to_short((float)in->re[i]);
+        if (st->filled == st->frame_length)
+        {
+            ret = vad_flush_frame(s, st->filled);
+            st->filled = 0;
+        }
+    }
+    return ret;
+}
+
+int vad_stage_finish(Stage *s)
+{
+    VADState *st = (VADState *)s->state;
+    int ret = st->filled > 0 ? vad_flush_frame(s, st->filled) : 0;
+    return ret | pipe_finish(s);
+}
+
+void vad_stage_destroy(Stage *s)
+{
+    VADState *st = (VADState *)s->state;
+    free(st->frame);
+    free(st->history);
+}
+
+int vad_stage_create(Stage *s, int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    VADParams p;
+    vad_default_params(&p, s->in.sample_rate);
+    VADState *st = (VADState *)calloc(1, sizeof(VADState));
+    if (!st)
+        return -1;
+    vad_init(&st->vad, &p);
+    st->frame_length = p.frame_length;
+    st->capacity = (p.head_frames + p.min_frames + 1) * p.frame_length;
+    st->frame = (short *)malloc(sizeof(short) * p.frame_length);
+    st->history = (double *)malloc(sizeof(double) * st->capacity);
+    s->state = st;
+    s->push = vad_stage_push;
+    s->finish = vad_stage_finish;
+    s->destroy = vad_stage_destroy;
+    s->out.kind = PIPE_SAMPLES;
+    s->out.max_length = st->capacity;
+    return (st->frame && st->history) ? 0 : -1;
+}
+
+// ---- center ----
+// 入力を全部ためて，標本番号が連続している最も長い区間の中央 length 標本を出す
+
+typedef struct
+{
+    int length;
+    double *samples;
+    long count, capacity;
+    long run_first, run_start, run_length;  // 現在の連続区間（バッファ内の位置・標本番号・長さ）
+    long best_first, best_start, best_length; // 最も長い連続区間
+    long next_index;
+} CenterState;
+
+int center_push(Stage *s, const PipeBuffer *in)
+{
+    CenterState *st = (CenterState *)s->state;
+    if (st->count + in->length > st->capacity)
+    {
+        long cap = st->capacity ? st->capacity : PIPE_BLOCK;
+        while (cap < st->count + in->length)
+            cap *= 2;
+        double *p = (double *)realloc(st->samples, sizeof(double) * cap);
+        if (!p)
+            return -1;
+        st->samples = p;
+        st->capacity = cap;
+    }
+    if (st->count == 0 || in->index != st->next_index) // 新しい連続区間
+    {
+        st->run_first = st->count;
+        st->run_start = in->index;
+        st->run_length = 0;
+    }
+    memcpy(st->samples + st->count, in->re, sizeof(double) * in->length);
+    st->count += in->length;
+    st->run_length += in->length;
+    st->next_index = in->index + in->length;
+    if (st->run_length > st->best_length)
+    {
+        st->best_first = st->run_first;
+        st->best_start = st->run_start;
+        st->best_length = st->run_length;
+    }
+    return 0;
+}
+
+int center_finish(Stage *s)
+{
+    CenterState *st = (CenterState *)s->state;
+    int ret = 0;
+    if (st->best_length > 0)
+    {
+        long start = st->best_length / 2 - st->length / 2; // kadai4 と同じ位置
+        if (start < 0)
+            start = 0;
+        for (int i = 0; i < st->length; ++i) // 区間の外はゼロ詰め
+            s->buf.re[i] = start + i < st->best_length ? st->samples[st->best_first + start + i] : 0.0;
+        s->buf.length = st->length;
+        s->buf.index = st->best_start + start;
+        ret = pipe_emit(s, &s->buf);
+    }
+    return ret | pipe_finish(s);
+}
+
+void center_destroy(Stage *s)
+{
+    free(((CenterState *)s->state)->samples);
+}
+
+int center_create(Stage *s, int argc, char **argv)
+{
+    int length = argc > 1 ? atoi(argv[1]) : 0;
+    CenterState *st = (CenterState *)calloc(1, sizeof(CenterState));
+    if (length <= 0 || !st)
+        return -1;
+    st->length = length;
+    s->state = st;
+    s->push = center_push;
+    s->finish = center_finish;
+    s->destroy = center_destroy;
+    s->out.kind = PIPE_SAMPLES;
+    s->out.max_length = length;
+    return 0;
+}
+
+// ---- fir ----
+
+typedef struct
+{
+    FIRFilter *fir;
+    float *in, *out;
+    int filled;
+    long index; // in[0] の標本番号
+} FIRState;
+
+int fir_stage_block(Stage *s, int n)
+{
+    FIRState *st = (FIRState *)s->state;
+    int B = st->fir->block;
+    memset(st->in + n, 0, sizeof(float) * (B - n)); // 最後の半端なブロックはゼロ詰め
+    fir_process_block(st->fir, st->in, st->out);
+    for (int i = 0; i < n; ++i)
+        s->buf.re[i] = st->out[i];
+    s->buf.length = n;
+    s->buf.index = st->index;
+    st->index += n;
+    st->filled = 0;
+    return pipe_emit(s, &s->buf);
+}
+
+int fir_stage_push(Stage *s, const PipeBuffer *in)
+{
+    FIRState *st = (FIRState *)s->state;
+    int ret = 0;
+    // 標本番号が飛んだら（vad の区間の切れ目など）それまでの分を出し切り，前の区間の履歴を消す
+    if (in->index != st->index + st->filled)
+    {
+        if (st->filled > 0)
+            ret = fir_stage_block(s, st->filled);
+        fir_reset(st->fir);
+    }
+    if (st->filled == 0)
+        st->index = in->index;
+    for (long i = 0; i < in->length && ret == 0; ++i)
+    {
+        st->in[st->filled++] = (float)in->re[i];
+        if (st->filled == st->fir->block)
+            ret = fir_stage_block(s, st->filled);
+    }
+    return ret;
+}
+
+int fir_stage_finish(Stage *s)
+{
+    FIRState *st = (FIRState *)s->state;
+    int ret = st->filled > 0 ? fir_stage_block(s, st->filled) : 0;
+    return ret | pipe_finish(s);
+}
+
+void fir_stage_destroy(Stage *s)
+{
+    FIRState *st = (FIRState *)s->state;
+    fir_destroy(st->fir);
+    free(st->in);
+    free(st->out);
+}
+
+int fir_stage_create(Stage *s, int argc, char **argv)
+{
+    int order = argc > 1 ? atoi(argv[1]) : 0;
+    double cutoff = argc > 2 ? atof(argv[2]) : 0.4;
+    int window_type = argc > 3 ? window_type_from_name(argv[3]) : WINDOW_RECT;
+    if (order <= 0 || window_type < 0)
+        return -1;
+
+    int taps = order + 1;
+    double *h = (double *)malloc(sizeof(double) * taps);
+    double *w = (double *)malloc(sizeof(double) * taps);
+    FIRState *st = (FIRState *)calloc(1, sizeof(FIRState));
+    if (!h || !w || !st)
+        return -1;
+    make_window(window_type, w, taps);
+    for (int n = 0; n < taps; ++n)
+        h[n] = sinc_h(n, order, cutoff) * w[n];
+    st->fir = fir_create(h, taps, FIR_AUTO, 0);
+    free(h);
+    free(w);
+    if (!st->fir)
+        return -1;
+    st->in = (float *)malloc(sizeof(float) * st->fir->block);
+    st->out = (float *)malloc(sizeof(float) * st->fir->block);
+    s->state = st;
+    s->push = fir_stage_push;
+    s->finish = fir_stage_finish;
+    s->destroy = fir_stage_destroy;
+    s->out.kind = PIPE_SAMPLES;
+    s->out.max_length = st->fir->block;
+    return (st->in && st->out) ? 0 : -1;
+}
+
+// ---- window ----
+// stft_next_frame と同じく，最初は frame_length 標本，以降は hop 標本ずつ進め，
+// 最後に新しい標本が残っていればゼロ詰めしたフレームを出す
+
+typedef struct
+{
+    double *window, *samples;
+    int filled;
+    int pending; // まだどのフレームにも入っていない標本数
+    long index;  // samples[0] の標本番号
+} WindowState;
+
+int window_emit(Stage *s)
+{
+    WindowState *st = (WindowState *)s->state;
+    int L = s->out.frame_length;
+    for (int n = 0; n < L; ++n)
+        s->buf.re[n] = n < st->filled ? st->samples[n] * st->window[n] : 0.0;
+    s->buf.length = L;
+    s->buf.index = st->index;
+    st->pending = 0;
+    return pipe_emit(s, &s->buf);
+}
+
+int window_push(Stage *s, const PipeBuffer *in)
+{
+    WindowState *st = (WindowState *)s->state;
+    int L = s->out.frame_length, hop = s->out.hop;
+    int ret = 0;
+    // 標本番号が飛んだら，前の区間の残りをゼロ詰めのフレームで出して最初のフレームからやり直す
+    if (st->filled > 0 && in->index != st->index + st->filled)
+    {
+        if (st->pending > 0)
+            ret = window_emit(s);
+        st->filled = 0;
+        st->pending = 0;
+    }
+    for (long i = 0; i < in->length && ret == 0; ++i)
+    {
+        if (st->filled == 0)
+            st->index = in->index + i;
+        st->samples[st->filled++] = in->re[i];
+        st->pending++;
+        if (st->filled == L)
+        {
+            ret = window_emit(s);
+            memmove(st->samples, st->samples + hop, sizeof(double) * (L - hop));
+            st->filled = L - hop;
+            st->index += hop;
+        }
+    }
+    return ret;
+}
+
+int window_finish(Stage *s)
+{
+    WindowState *st = (WindowState *)s->state;
+    int ret = st->pending > 0 ? window_emit(s) : 0;
+    return ret | pipe_finish(s);
+}
+
+void window_destroy(Stage *s)
+{
+    WindowState *st = (WindowState *)s->state;
+    free(st->window);
+    free(st->samples);
+}
+
+int window_create(Stage *s, int argc, char **argv)
+{
+    int type = argc > 1 ? window_type_from_name(argv[1]) : -1;
+    int L = argc > 2 ? atoi(argv[2]) : 0;
+    int hop = argc > 3 ? atoi(argv[3]) : L / 2;
+    WindowState *st = (WindowState *)calloc(1, sizeof(WindowState));
+    if (type < 0 || L <= 0 || hop <= 0 || hop > L || !st)
+        return -1;
+    st->window = (double *)malloc(sizeof(double) * L);
+    st->samples = (double *)malloc(sizeof(double) * L);
+    if (!st->window || !st->samples)
+        return -1;
+    make_window(type, st->window, L);
+    s->state = st;
+    s->push = window_push;
+    s->finish = window_finish;
+    s->destroy = window_destroy;
+    s->out.kind = PIPE_FRAME;
+    s->out.max_length = L;
+    s->out.frame_length = L;
+    s->out.hop = hop;
+    return 0;
+}
+
+// ---- fft ----
+
+typedef struct
+{
+    RFFTPlan *plan;
+    double *x; // FFT入力（fft_size，フレーム長以降はゼロのまま）
+} FFTState;
+
+int fft_stage_push(Stage *s, const PipeBuffer *in)
+{
+    FFTState *st = (FFTState *)s->state;
+    memcpy(st->x, in->re, sizeof(double) * in->length);
+    rfft_forward(st->plan, st->x, s->buf.re, s->buf.im);
+    s->buf.length = s->out.max_length;
+    s->buf.index = in->index;
+    return pipe_emit(s, &s->buf);
+}
+
+int fft_stage_finish(Stage *s)
+{
+    return pipe_finish(s);
+}
+
+void fft_stage_destroy(Stage *s)
+{
+    FFTState *st = (FFTState *)s->state;
+    rfft_plan_destroy(st->plan);
+    free(st->x);
+}
+
+int fft_stage_create(Stage *s, int argc, char **argv)
+{
+    int size = argc > 1 ? atoi(argv[1]) : 0;
+    FFTState *st = (FFTState *)calloc(1, sizeof(FFTState));
+    if (size < s->in.frame_length || !st)
+        return -1;
+    st->plan = rfft_plan_create(size);
+    st->x = (double *)calloc(size, sizeof(double));
+    if (!st->plan || !st->x)
+        return -1;
+    s->state = st;
+    s->push = fft_stage_push;
+    s->finish = fft_stage_finish;
+    s->destroy = fft_stage_destroy;
+    s->out.kind = PIPE_SPECTRUM;
+    s->out.max_length = size / 2 + 1;
+    s->out.fft_size = size;
+    return 0;
+}
+
+// ---- logpower ----
+
+int logpower_push(Stage *s, const PipeBuffer *in)
+{
+    TRACE_BEGIN(t);
+    for (long k = 0; k < in->length; ++k) // stft_analyze と同じ式
+    {
+        double power = in->re[k] * in->re[k] + in->im[k] * in->im[k];
+        s->buf.re[k] = 10.0 * log10(power + 1e-12);
+    }
+    TRACE_END(t, STAGE_LOG_POWER, in->length);
+    s->buf.length = in->length;
+    s->buf.index = in->index;
+    return pipe_emit(s, &s->buf);
+}
+
+int logpower_create(Stage *s, int argc, char **argv)
+{
+    (void)argc;
+    (void)argv;
+    s->push = logpower_push;
+    s->finish = fft_stage_finish;
+    s->out.kind = PIPE_POWER;
+    return 0;
+}
+
+// ---- write ----
+
+typedef struct
+{
+    int format;
+    const char *filename;
+    FILE *fp;        // バイナリ
+    TextWriter *tw;  // テキスト
+    short *pcm;      // 標本列のバイナリ出力用
+    float *row;      // スペクトログラムの1行
+    SpectrogramHeader header;
+    long frames;
+} WriteState;
+
+int write_push(Stage *s, const PipeBuffer *in)
+{
+    WriteState *st = (WriteState *)s->state;
+    TRACE_BEGIN(t);
+    if (s->in.kind == PIPE_SAMPLES && st->format == OUT_TEXT) // "%.3f %d"
+    {
+        for (long i = 0; i < in->length; ++i)
+        {
+            tw_fixed(st->tw, ((in->index + i) * 1000.0) / s->in.sample_rate, 3);
+            tw_char(st->tw, ' ');
+            tw_int(st->tw, pcm_float_to_short((float)in->re[i]));
+            tw_char(st->tw, '\n');
+        }
+    }
+    else if (s->in.kind == PIPE_SAMPLES)
+    {
+        for (long i = 0; i < in->length; ++i)
+            st->pcm[i] = pcm_float_to_short((float)in->re[i]);
+        fwrite(st->pcm, sizeof(short), in->length, st->fp);
+    }
+    else if (st->format == OUT_TEXT) // "%f %f"（周波数 [kHz]，パワー [dB]）
+    {
+        double freq_step = (double)s->in.sample_rate / s->in.fft_size / 1000.0;
+        if (st->frames > 0)
+            tw_char(st->tw, '\n');
+        for (long k = 0; k < in->length; ++k)
+        {
+            tw_fixed(st->tw, 0.0 + k * freq_step, 6);
+            tw_char(st->tw, ' ');
+            tw_fixed(st->tw, in->re[k], 6);
+            tw_char(st->tw, '\n');
+        }
+    }
+    else
+    {
+        for (long k = 0; k < in->length; ++k)
+            st->row[k] = (float)in->re[k];
+        fwrite(st->row, sizeof(float), in->length, st->fp);
+    }
+    st->frames++;
+    TRACE_END(t, STAGE_WRITE, in->length);
+    return 0;
+}
+
+int write_finish(Stage *s)
+{
+    WriteState *st = (WriteState *)s->state;
+    int ret = 0;
+    if (st->tw)
+    {
+        ret = tw_close(st->tw);
+        st->tw = NULL;
+    }
+    else
+    {
+        if (s->in.kind == PIPE_POWER) // フレーム数は最後にわかるのでヘッダを書き直す
+        {
+            st->header.frames = (int32_t)st->frames;
+            if (fseek(st->fp, 0, SEEK_SET) != 0 || fwrite(&st->header, sizeof(st->header), 1, st->fp) != 1)
+                ret = -1;
+        }
+        ret |= (st->fp == stdout ? fflush(st->fp) : fclose(st->fp)) ? -1 : 0;
+        st->fp = NULL;
+    }
+    if (ret != 0)
+        perror(st->filename);
+    return ret;
+}
+
+void write_destroy(Stage *s)
+{
+    WriteState *st = (WriteState *)s->state;
+    free(st->pcm);
+    free(st->row);
+}
+
+int write_create(Stage *s, int argc, char **argv)
+{
+    if (s->in.kind != PIPE_SAMPLES && s->in.kind != PIPE_POWER)
+    {
+        fprintf(stderr, "write には標本列かパワーを渡してください（%s が来ています）\n", pipe_kind_names[s->in.kind]);
+        return -1;
+    }
+    WriteState *st = (WriteState *)calloc(1, sizeof(WriteState));
+    if (!st || argc < 2 || (st->format = out_format_from_name(argv[1])) < 0)
+        return -1;
+    st->filename = argc > 2 ? argv[2] : "-";
+    s->state = st;
+    s->push = write_push;
+    s->finish = write_finish;
+    s->destroy = write_destroy;
+
+    if (st->format == OUT_TEXT)
+    {
+        if (!(st->tw = tw_open(st->filename)))
+        {
+            perror(st->filename);
+            return -1;
+        }
+        return 0;
+    }
+    st->fp = strcmp(st->filename, "-") == 0 ? stdout : fopen(st->filename, "wb");
+    st->pcm = (short *)malloc(sizeof(short) * s->in.max_length);
+    st->row = (float *)malloc(sizeof(float) * s->in.max_length);
+    if (!st->fp || !st->pcm || !st->row)
+    {
+        perror(st->filename);
+        return -1;
+    }
+    if (s->in.kind == PIPE_POWER)
+    {
+        memcpy(st->header.magic, SPECTROGRAM_MAGIC, 4);
+        st->header.sample_rate = s->in.sample_rate;
+        st->header.frame_length = s->in.frame_length;
+        st->header.hop = s->in.hop;
+        st->header.fft_size = s->in.fft_size;
+        st->header.bins = s->in.max_length;
+        st->header.frames = 0;
+        fwrite(&st->header, sizeof(st->header), 1, st->fp);
+    }
+    return 0;
+}
+
+// ---- 組み立て ----
+
+typedef struct
+{
+    const char *name;
+    int in_kind; // 受け取るデータ（-1: 始点，-2: 標本列かパワー）
+    int (*create)(Stage *s, int argc, char **argv);
+} StageType;
+
+static const StageType stage_types[] = {
+    {"read", -1, read_create},
+    {"vad", PIPE_SAMPLES, vad_stage_create},
+    {"center", PIPE_SAMPLES, center_create},
+    {"fir", PIPE_SAMPLES, fir_stage_create},
+    {"window", PIPE_SAMPLES, window_create},
+    {"fft", PIPE_FRAME, fft_stage_create},
+    {"logpower", PIPE_SPECTRUM, logpower_create},
+    {"write", -2, write_create},
+};
+
+void pipeline_destroy(Stage *stages, int count)
+{
+    for (int i = 0; i < count; ++i)
+    {
+        if (stages[i].destroy && stages[i].state)
+            stages[i].destroy(&stages[i]);
+        free(stages[i].state);
+        free(stages[i].buf.re);
+        free(stages[i].buf.im);
+        spsc_destroy(stages[i].ring);
+    }
+}
+
+// spec（'|' 区切り）を解析して stages に段階を作る．段階数を返す（失敗なら-1）
+// spec の中身は書き換えて各段階の引数として使う
+int pipeline_build(char *spec, Stage *stages, int sample_rate, int all_threaded)
+{
+    int count = 0;
+    PipeFormat format = {-1, 0, sample_rate, 0, 0, 0};
+    for (char *part = strtok(spec, "|"); part; part = strtok(NULL, "|"))
+    {
+        char *argv[PIPE_MAX_ARGS + 1];
+        int argc = 0;
+        char *save;
+        for (char *tok = strtok_r(part, " \t\n", &save); tok && argc < PIPE_MAX_ARGS; tok = strtok_r(NULL, " \t\n", &save))
+            argv[argc++] = tok;
+        if (argc == 0)
+            continue;
+        if (count == PIPE_MAX_STAGES)
+        {
+            fprintf(stderr, "段階が多すぎます（最大 %d）\n", PIPE_MAX_STAGES);
+            return -1;
+        }
+
+        Stage *s = &stages[count];
+        memset(s, 0, sizeof(*s));
+        s->threaded = argv[0][0] == '@' || (all_threaded && count > 0);
+        if (argv[0][0] == '@')
+            argv[0]++;
+
+        const StageType *type = NULL;
+        for (size_t i = 0; i < sizeof(stage_types) / sizeof(stage_types[0]); ++i)
+            if (strcmp(stage_types[i].name, argv[0]) == 0)
+                type = &stage_types[i];
+        if (!type)
+        {
+            fprintf(stderr, "不明な段階です: %s\n", argv[0]);
+            return -1;
+        }
+        if ((type->in_kind == -1) != (count == 0) ||
+            (type->in_kind >= 0 && type->in_kind != format.kind))
+        {
+            fprintf(stderr, "%s の入力が合いません（前の段階の出力: %s）\n", argv[0],
+                    count == 0 ? "なし" : pipe_kind_names[format.kind]);
+            return -1;
+        }
+        if (count == 0)
+            s->threaded = 0; // 始点は main のスレッドで動く
+
+        s->name = type->name;
+        s->in = format;
+        s->out = format; // 各段階は変わるところだけ書き換える
+        if (type->create(s, argc, argv) != 0)
+        {
+            fprintf(stderr, "%s の引数が不正です\n", argv[0]);
+            pipeline_destroy(stages, count + 1);
+            return -1;
+        }
+        if (strcmp(s->name, "write") != 0 && pipe_alloc_output(s) != 0)
+        {
+            perror("malloc");
+            pipeline_destroy(stages, count + 1);
+            return -1;
+        }
+        if (s->threaded)
+        {
+            size_t slot = sizeof(PipeSlot) + sizeof(double) * s->in.max_length * (s->in.kind == PIPE_SPECTRUM ? 2 : 1);
+            if (!(s->ring = spsc_create(PIPE_RING_SLOTS, slot)))
+            {
+                perror("malloc");
+                pipeline_destroy(stages, count + 1);
+                return -1;
+            }
+        }
+        if (count > 0)
+            stages[count - 1].next = s;
+        format = s->out;
+        count++;
+    }
+    if (count == 0 || strcmp(stages[count - 1].name, "write") != 0)
+    {
+        fprintf(stderr, "パイプラインは read で始まり write で終わる必要があります\n");
+        pipeline_destroy(stages, count);
+        return -1;
+    }
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    int sample_rate = SAMPLE_RATE, all_threaded = 0;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "r:T")) != -1)
+    {
+        switch (opt)
+        {
+        case 'r': sample_rate = atoi(optarg); break;
+        case 'T': all_threaded = 1; break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind != 1 || sample_rate <= 0)
+    {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] [-T] [-r 標本化周波数] '<段階> | <段階> | ...'\n"
+                        "  段階: read [file] | vad | center <n> | fir <order> [cutoff] [window] | window <hamming|hann|rect> <len> [hop]\n"
+                        "        | fft <n> | logpower | write <txt|bin> [file]（段階名の前の @ でその段階を別スレッドにする）\n",
+                argv[0]);
+        return 1;
+    }
+
+    char *spec = strdup(argv[optind]);
+    Stage stages[PIPE_MAX_STAGES];
+    int count = spec ? pipeline_build(spec, stages, sample_rate, all_threaded) : -1;
+    if (count < 0)
+        return 1;
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    int threads = 0;
+    for (int i = 1; i < count; ++i)
+        if (stages[i].threaded && pthread_create(&stages[i].thread, NULL, pipe_thread_main, &stages[i]) == 0)
+            threads++;
+    int ret = read_run(&stages[0]);
+    for (int i = 1; i < count; ++i)
+    {
+        if (stages[i].threaded)
+            pthread_join(stages[i].thread, NULL);
+        ret |= stages[i].result;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    long samples = stages[0].buf.index;
+    fprintf(stderr, "%d 段階（%d スレッド）で %ld 標本を処理しました: %.3f ms", count, threads + 1, samples, elapsed * 1e3);
+    if (elapsed > 0 && samples > 0)
+        fprintf(stderr, "（実時間の %.0f 倍）", (double)samples / sample_rate / elapsed);
+    fprintf(stderr, "\n");
+
+    pipeline_destroy(stages, count);
+    free(spec);
+    return ret ? 1 : 0;
+}
+
+// 例:
+// ./pipeline 'read a00.raw | center 320 | window hamming 320 | fft 1024 | logpower | write txt a00_spec.txt'   (kadai4 と同じ出力)
+// ./pipeline 'read music1.raw | window hamming 320 160 | fft 1024 | logpower | write bin music1.bin'          (stft と同じ出力)
+// ./pipeline -T 'read mix.raw | vad | fir 100 0.4 | @window hann 512 | @fft 512 | logpower | write bin mix.bin'
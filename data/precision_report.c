@@ -0,0 +1,134 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stft.h"   // 窓関数・FFT（double / float / Q15）
+#include "pcm_io.h" // rawファイルの読み込み（mmap）
+
+// 単精度・Q15 の対数パワースペクトルを double と比べる精度レポート
+// 各ファイルの全フレームについて，フレームのピークから range dB 以内のビンの誤差 [dB] を集計し，
+// 1フレームあたりの処理時間も測る．
+
+#define FRAME_LENGTH 320 // フレーム長 = 20ms
+#define HOP 160          // フレームシフト = 10ms
+#define N 1024           // FFT点数
+#define RANGE_DB 60.0    // 誤差を見るダイナミックレンジ [dB]
+
+typedef struct
+{
+    double max_err;  // 最大誤差 [dB]
+    double sum_sq;   // 二乗誤差の和
+    long count;      // 比較したビン数
+    double seconds;  // 解析にかかった時間
+} Accuracy;
+
+double now_sec(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// 録音全体を解析し，frames × bins の対数パワーを out に書く（戻り値は解析時間）
+double analyze_all(STFT *s, const PCMData *pcm, long frames, double *frame, double *out)
+{
+    double t0 = now_sec();
+    for (long f = 0; f < frames; ++f)
+    {
+        long start = f * HOP;
+        for (int n = 0; n < FRAME_LENGTH; ++n)
+            frame[n] = start + n < pcm->length ? pcm->samples[start + n] : 0.0;
+        stft_analyze(s, frame);
+        memcpy(out + f * s->bins, s->log_power, sizeof(double) * s->bins);
+    }
+    return now_sec() - t0;
+}
+
+int main(int argc, char *argv[])
+{
+    double range = RANGE_DB;
+    int opt;
+    while ((opt = getopt(argc, argv, "r:")) != -1)
+    {
+        if (opt == 'r')
+            range = atof(optarg);
+        else
+            argc = 0;
+    }
+    if (argc <= 0)
+    {
+        fprintf(stderr, "使い方: %s [-r 比較するレンジ[dB]] [入力ファイル名.raw ...]\n", argv[0]);
+        return 1;
+    }
+
+    const char *defaults[] = {"sin.raw", "cos.raw", "a00.raw", "White_noise_16kHz16bit_mono.raw"};
+    const char **files = optind < argc ? (const char **)argv + optind : defaults;
+    int num_files = optind < argc ? argc - optind : 4;
+
+    const int tiers[] = {PRECISION_FLOAT, PRECISION_Q15};
+    const char *tier_names[] = {"float", "q15"};
+    STFT *ref = stft_create(FRAME_LENGTH, HOP, N, WINDOW_HAMMING);
+    STFT *lp[2];
+    for (int t = 0; t < 2; ++t)
+    {
+        lp[t] = stft_create(FRAME_LENGTH, HOP, N, WINDOW_HAMMING);
+        if (!lp[t] || stft_set_precision(lp[t], tiers[t]) != 0)
+        {
+            fprintf(stderr, "STFTの作成に失敗しました\n");
+            return 1;
+        }
+    }
+    double frame[FRAME_LENGTH];
+    int bins = ref->bins;
+
+    printf("%-34s %-6s %7s %12s %12s %12s\n", "file", "tier", "frames", "max err[dB]", "rms err[dB]", "us/frame");
+    for (int i = 0; i < num_files; ++i)
+    {
+        PCMData pcm;
+        if (pcm_open(files[i], &pcm) != 0)
+        {
+            perror(files[i]);
+            continue;
+        }
+        long frames = pcm.length <= FRAME_LENGTH ? 1 : 1 + (pcm.length - FRAME_LENGTH + HOP - 1) / HOP;
+        double *want = (double *)malloc(sizeof(double) * frames * bins);
+        double *got = (double *)malloc(sizeof(double) * frames * bins);
+        double ref_sec = analyze_all(ref, &pcm, frames, frame, want);
+        printf("%-34s %-6s %7ld %12s %12s %12.2f\n", files[i], "double", frames, "-", "-", ref_sec * 1e6 / frames);
+
+        for (int t = 0; t < 2; ++t)
+        {
+            Accuracy acc = {0};
+            acc.seconds = analyze_all(lp[t], &pcm, frames, frame, got);
+            for (long f = 0; f < frames; ++f)
+            {
+                const double *w = want + f * bins, *g = got + f * bins;
+                double peak = w[0];
+                for (int k = 1; k < bins; ++k)
+                    peak = w[k] > peak ? w[k] : peak;
+                for (int k = 0; k < bins; ++k)
+                {
+                    if (w[k] < peak - range)
+                        continue;
+                    double err = fabs(g[k] - w[k]);
+                    acc.max_err = err > acc.max_err ? err : acc.max_err;
+                    acc.sum_sq += err * err;
+                    acc.count++;
+                }
+            }
+            printf("%-34s %-6s %7ld %12.4f %12.4f %12.2f\n", "", tier_names[t], frames, acc.max_err,
+                   acc.count ? sqrt(acc.sum_sq / acc.count) : 0.0, acc.seconds * 1e6 / frames);
+        }
+        free(want);
+        free(got);
+        pcm_close(&pcm);
+    }
+
+    stft_destroy(ref);
+    stft_destroy(lp[0]);
+    stft_destroy(lp[1]);
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "render.h" // 画像出力
+#include "stft.h"   // スペクトログラムの計算と SPEC 形式
+#include "pcm_io.h" // rawファイルの読み込み（mmap）
+
+#define FRAME_LENGTH 320 // フレーム長 = 20ms
+#define HOP 160          // フレームシフト = 10ms
+#define N 1024           // FFT点数
+#define WIDTH 800        // 既定の画像サイズ [画素]
+#define HEIGHT 300
+#define RANGE_DB 80.0    // スペクトログラムの表示範囲 [dB]
+
+// SPEC 形式（stft / batch_spec -m stft の出力）を読み込む（SPEC でなければ0，失敗なら-1）
+int load_spectrogram(const char *filename, float **db, long *frames, int *bins)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (!fp)
+        return -1;
+    SpectrogramHeader h;
+    if (fread(&h, sizeof(h), 1, fp) != 1 || memcmp(h.magic, SPECTROGRAM_MAGIC, 4) != 0)
+    {
+        fclose(fp);
+        return 0;
+    }
+    *frames = h.frames;
+    *bins = h.bins;
+    *db = (float *)malloc(sizeof(float) * h.frames * h.bins + 1);
+    size_t n = *db ? fread(*db, sizeof(float), (size_t)h.frames * h.bins, fp) : 0;
+    fclose(fp);
+    return n == (size_t)h.frames * h.bins ? 1 : -1;
+}
+
+// 録音全体のスペクトログラムをメモリ上で求める
+float *compute_spectrogram(const PCMData *pcm, long *frames, int *bins)
+{
+    STFT *s = stft_create(FRAME_LENGTH, HOP, N, WINDOW_HAMMING);
+    long nf = pcm->length <= FRAME_LENGTH ? 1 : 1 + (pcm->length - FRAME_LENGTH + HOP - 1) / HOP;
+    float *db = s ? (float *)malloc(sizeof(float) * nf * s->bins) : NULL;
+    if (!db)
+    {
+        stft_destroy(s);
+        return NULL;
+    }
+    double frame[FRAME_LENGTH];
+    for (long f = 0; f < nf; ++f)
+    {
+        long start = f * HOP;
+        for (int n = 0; n < FRAME_LENGTH; ++n) // 末尾はゼロ詰め
+            frame[n] = start + n < pcm->length ? pcm->samples[start + n] : 0.0;
+        stft_analyze(s, frame);
+        for (int k = 0; k < s->bins; ++k)
+            db[f * s->bins + k] = (float)s->log_power[k];
+    }
+    *frames = nf;
+    *bins = s->bins;
+    stft_destroy(s);
+    return db;
+}
+
+int main(int argc, char *argv[])
+{
+    int width = WIDTH, height = HEIGHT, spectrogram = 0;
+    double range_db = RANGE_DB;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "W:H:m:r:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'W': width = atoi(optarg); break;
+        case 'H': height = atoi(optarg); break;
+        case 'r': range_db = atof(optarg); break;
+        case 'm':
+            if (strcmp(optarg, "wave") == 0)
+                spectrogram = 0;
+            else if (strcmp(optarg, "spec") == 0)
+                spectrogram = 1;
+            else
+                argc = 0;
+            break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind != 2 || width <= 0 || height <= 0 || range_db <= 0.0)
+    {
+        fprintf(stderr, "使い方: %s [-m wave|spec] [-W 幅] [-H 高さ] [-r 表示範囲[dB]] <入力ファイル名.raw|スペクトログラム.bin> <出力ファイル名.png|.ppm>\n", argv[0]);
+        return 1;
+    }
+    const char *input_filename = argv[optind];
+    const char *output_filename = argv[optind + 1];
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    float *db = NULL;
+    long frames = 0;
+    int bins = 0;
+    int is_spec = load_spectrogram(input_filename, &db, &frames, &bins);
+    if (is_spec < 0)
+    {
+        perror(input_filename);
+        return 1;
+    }
+
+    const unsigned char white[3] = {255, 255, 255}, blue[3] = {31, 119, 180};
+    Image *img = image_create(width, height, white);
+    if (!img)
+    {
+        fprintf(stderr, "画像の確保に失敗しました\n");
+        return 1;
+    }
+
+    PCMData pcm = {0};
+    if (!is_spec && pcm_open(input_filename, &pcm) != 0)
+    {
+        perror(input_filename);
+        return 1;
+    }
+
+    if (is_spec || spectrogram)
+    {
+        if (!is_spec && !(db = compute_spectrogram(&pcm, &frames, &bins)))
+        {
+            fprintf(stderr, "スペクトログラムの計算に失敗しました\n");
+            return 1;
+        }
+        render_spectrogram(img, db, frames, bins, range_db);
+    }
+    else
+    {
+        render_waveform(img, pcm.samples, pcm.length, blue);
+    }
+
+    if (image_write(img, output_filename) != 0)
+    {
+        perror(output_filename);
+        return 1;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    printf("%s を %s (%d × %d) に描きました（%.3f ms）\n", input_filename, output_filename, width, height,
+           ((t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9) * 1e3);
+
+    free(db);
+    image_destroy(img);
+    pcm_close(&pcm);
+    return 0;
+}
+
+// 例:
+// ./render a00.raw a00.png
+// ./render -m spec -W 1200 ../data3/music1.raw music1_spec.png
+// ./stft a00.raw a00.bin && ./render a00.bin a00_spec.ppm
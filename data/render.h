@@ -0,0 +1,317 @@
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "pcm_gain.h" // ベクトル型
+
+// 波形・スペクトログラムの画像出力（PPM / PNG，外部ライブラリなし）
+// PNG は無圧縮の deflate ブロックで書く（zlib 不要，読み込みは普通の PNG と同じ）．
+// 長い録音は画素の列ごとに最小値・最大値を求めて縦線で描くので，描画の手間は標本数ではなく画像の幅で決まる．
+
+typedef struct
+{
+    int width, height;
+    unsigned char *rgb; // width × height × 3
+} Image;
+
+Image *image_create(int width, int height, const unsigned char bg[3])
+{
+    if (width <= 0 || height <= 0)
+        return NULL;
+    Image *img = (Image *)malloc(sizeof(Image));
+    if (!img)
+        return NULL;
+    img->width = width;
+    img->height = height;
+    img->rgb = (unsigned char *)malloc((size_t)width * height * 3);
+    if (!img->rgb)
+    {
+        free(img);
+        return NULL;
+    }
+    for (long i = 0; i < (long)width * height; ++i)
+        memcpy(img->rgb + i * 3, bg, 3);
+    return img;
+}
+
+void image_destroy(Image *img)
+{
+    if (!img)
+        return;
+    free(img->rgb);
+    free(img);
+}
+
+void image_pixel(Image *img, int x, int y, const unsigned char c[3])
+{
+    if (x >= 0 && x < img->width && y >= 0 && y < img->height)
+        memcpy(img->rgb + ((size_t)y * img->width + x) * 3, c, 3);
+}
+
+// x 列の y0〜y1（両端を含む）に縦線を引く
+void image_vline(Image *img, int x, int y0, int y1, const unsigned char c[3])
+{
+    if (y0 > y1)
+    {
+        int t = y0;
+        y0 = y1;
+        y1 = t;
+    }
+    for (int y = y0; y <= y1; ++y)
+        image_pixel(img, x, y, c);
+}
+
+int image_write_ppm(const Image *img, const char *filename)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (!fp)
+        return -1;
+    fprintf(fp, "P6\n%d %d\n255\n", img->width, img->height);
+    fwrite(img->rgb, 3, (size_t)img->width * img->height, fp);
+    return fclose(fp);
+}
+
+// ---- PNG ----
+
+uint32_t png_crc_table[256];
+
+void png_crc_init(void)
+{
+    for (uint32_t n = 0; n < 256; ++n)
+    {
+        uint32_t c = n;
+        for (int k = 0; k < 8; ++k)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        png_crc_table[n] = c;
+    }
+}
+
+uint32_t png_crc(uint32_t crc, const unsigned char *p, size_t n)
+{
+    for (size_t i = 0; i < n; ++i)
+        crc = png_crc_table[(crc ^ p[i]) & 0xFF] ^ (crc >> 8);
+    return crc;
+}
+
+void png_be32(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)(v >> 24);
+    p[1] = (unsigned char)(v >> 16);
+    p[2] = (unsigned char)(v >> 8);
+    p[3] = (unsigned char)v;
+}
+
+// チャンク（長さ・種類・データ・CRC）を書く
+void png_chunk(FILE *fp, const char *type, const unsigned char *data, uint32_t len)
+{
+    unsigned char head[8], tail[4];
+    png_be32(head, len);
+    memcpy(head + 4, type, 4);
+    uint32_t crc = png_crc(0xFFFFFFFFu, head + 4, 4);
+    crc = png_crc(crc, data, len) ^ 0xFFFFFFFFu;
+    png_be32(tail, crc);
+    fwrite(head, 1, 8, fp);
+    fwrite(data, 1, len, fp);
+    fwrite(tail, 1, 4, fp);
+}
+
+int image_write_png(const Image *img, const char *filename)
+{
+    static int crc_ready = 0;
+    if (!crc_ready)
+    {
+        png_crc_init();
+        crc_ready = 1;
+    }
+
+    FILE *fp = fopen(filename, "wb");
+    if (!fp)
+        return -1;
+    static const unsigned char signature[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+    fwrite(signature, 1, 8, fp);
+
+    unsigned char ihdr[13];
+    png_be32(ihdr, img->width);
+    png_be32(ihdr + 4, img->height);
+    ihdr[8] = 8;  // 1チャンネル8bit
+    ihdr[9] = 2;  // RGB
+    ihdr[10] = 0; // deflate
+    ihdr[11] = 0; // フィルタ方式
+    ihdr[12] = 0; // インターレースなし
+    png_chunk(fp, "IHDR", ihdr, 13);
+
+    // 画像データ = 各行の先頭にフィルタ種別0を付けたもの．これを無圧縮ブロックに分けて zlib 形式で包む
+    size_t row = (size_t)img->width * 3 + 1;
+    size_t raw_len = row * img->height;
+    size_t blocks = (raw_len + 65534) / 65535;
+    size_t idat_len = 2 + raw_len + blocks * 5 + 4;
+    unsigned char *idat = (unsigned char *)malloc(idat_len);
+    if (!idat)
+    {
+        fclose(fp);
+        return -1;
+    }
+
+    unsigned char *p = idat;
+    *p++ = 0x78; // zlib ヘッダ（deflate，32KiB 窓）
+    *p++ = 0x01;
+    uint32_t s1 = 1, s2 = 0; // Adler-32
+    size_t left = 0, done = 0;
+    for (int y = 0; y < img->height; ++y)
+    {
+        for (size_t i = 0; i < row; ++i)
+        {
+            if (left == 0) // 新しい無圧縮ブロック（最大65535バイト）
+            {
+                size_t n = raw_len - done < 65535 ? raw_len - done : 65535;
+                *p++ = (done + n == raw_len); // 最後のブロックなら BFINAL
+                p[0] = (unsigned char)n;
+                p[1] = (unsigned char)(n >> 8);
+                p[2] = (unsigned char)~n;
+                p[3] = (unsigned char)(~n >> 8);
+                p += 4;
+                left = n;
+            }
+            unsigned char b = i == 0 ? 0 : img->rgb[(size_t)y * img->width * 3 + i - 1];
+            *p++ = b;
+            s1 = (s1 + b) % 65521;
+            s2 = (s2 + s1) % 65521;
+            left--;
+            done++;
+        }
+    }
+    png_be32(p, (s2 << 16) | s1);
+    png_chunk(fp, "IDAT", idat, (uint32_t)idat_len);
+    png_chunk(fp, "IEND", NULL, 0);
+    free(idat);
+    return fclose(fp);
+}
+
+// 拡張子 .png なら PNG，それ以外は PPM で書く
+int image_write(const Image *img, const char *filename)
+{
+    size_t len = strlen(filename);
+    if (len >= 4 && strcmp(filename + len - 4, ".png") == 0)
+        return image_write_png(img, filename);
+    return image_write_ppm(img, filename);
+}
+
+// ---- 描画 ----
+
+// x[0..n) の最小値・最大値（16標本ずつ）
+void pcm_min_max(const short *x, long n, short *min_out, short *max_out)
+{
+    short lo = 32767, hi = -32768;
+    long i = 0;
+    if (n >= 16)
+    {
+        typedef short v16s __attribute__((vector_size(32)));
+        v16s vlo, vhi;
+        memcpy(&vlo, x, sizeof(vlo));
+        vhi = vlo;
+        for (i = 16; i + 16 <= n; i += 16)
+        {
+            v16s v;
+            memcpy(&v, x + i, sizeof(v));
+            vlo = (v16s)((v < vlo) & v) | (v16s)(~(v < vlo) & vlo);
+            vhi = (v16s)((v > vhi) & v) | (v16s)(~(v > vhi) & vhi);
+        }
+        for (int k = 0; k < 16; ++k)
+        {
+            lo = vlo[k] < lo ? vlo[k] : lo;
+            hi = vhi[k] > hi ? vhi[k] : hi;
+        }
+    }
+    for (; i < n; ++i)
+    {
+        lo = x[i] < lo ? x[i] : lo;
+        hi = x[i] > hi ? x[i] : hi;
+    }
+    *min_out = lo;
+    *max_out = hi;
+}
+
+// 波形を描く（列ごとの最小値・最大値を縦線に．1列が1標本未満なら隣の標本まで線でつなぐ）
+void render_waveform(Image *img, const short *samples, long length, const unsigned char color[3])
+{
+    const unsigned char axis[3] = {200, 200, 200};
+    int W = img->width, H = img->height;
+    double half = (H - 1) / 2.0;
+    for (int x = 0; x < W; ++x)
+        image_pixel(img, x, (int)(half + 0.5), axis);
+    if (length <= 0)
+        return;
+
+    for (int x = 0; x < W; ++x)
+    {
+        long a = (long)((double)x * length / W);
+        long b = (long)((double)(x + 1) * length / W) + 1; // 次の列とつながるよう1標本重ねる
+        if (b > length)
+            b = length;
+        if (a >= b)
+            a = b - 1;
+        short lo, hi;
+        pcm_min_max(samples + a, b - a, &lo, &hi);
+        int y0 = (int)(half - hi / 32768.0 * half + 0.5);
+        int y1 = (int)(half - lo / 32768.0 * half + 0.5);
+        image_vline(img, x, y0, y1, color);
+    }
+}
+
+// 0〜1 の値を黒→紫→赤→黄→白のカラーマップで色にする
+void colormap(double t, unsigned char c[3])
+{
+    static const double stops[5][3] = {{0, 0, 4}, {87, 16, 110}, {188, 55, 84}, {249, 142, 9}, {252, 255, 164}};
+    t = t < 0.0 ? 0.0 : t > 1.0 ? 1.0 : t;
+    double pos = t * 4.0;
+    int i = pos >= 4.0 ? 3 : (int)pos;
+    double f = pos - i;
+    for (int k = 0; k < 3; ++k)
+        c[k] = (unsigned char)(stops[i][k] + (stops[i + 1][k] - stops[i][k]) * f + 0.5);
+}
+
+// スペクトログラム（frames × bins の dB 値，行優先）を描く
+// 1画素に複数のフレーム・ビンが入るときはその最大値を使う．range_db はピークから下に表示する範囲
+void render_spectrogram(Image *img, const float *db, long frames, int bins, double range_db)
+{
+    int W = img->width, H = img->height;
+    if (frames <= 0 || bins <= 0)
+        return;
+    float peak = db[0];
+    for (long i = 1; i < frames * bins; ++i)
+        peak = db[i] > peak ? db[i] : peak;
+
+    float *column = (float *)malloc(sizeof(float) * bins);
+    if (!column)
+        return;
+    for (int x = 0; x < W; ++x)
+    {
+        long f0 = (long)((double)x * frames / W), f1 = (long)((double)(x + 1) * frames / W);
+        if (f1 <= f0)
+            f1 = f0 + 1;
+        memcpy(column, db + f0 * bins, sizeof(float) * bins);
+        for (long f = f0 + 1; f < f1; ++f)
+            for (int k = 0; k < bins; ++k)
+                column[k] = db[f * bins + k] > column[k] ? db[f * bins + k] : column[k];
+
+        for (int y = 0; y < H; ++y) // 上が高い周波数
+        {
+            int k0 = (int)((double)(H - 1 - y) * bins / H), k1 = (int)((double)(H - y) * bins / H);
+            if (k1 <= k0)
+                k1 = k0 + 1;
+            float v = column[k0];
+            for (int k = k0 + 1; k < k1; ++k)
+                v = column[k] > v ? column[k] : v;
+            unsigned char c[3];
+            colormap(1.0 - (peak - v) / range_db, c);
+            image_pixel(img, x, y, c);
+        }
+    }
+    free(column);
+}
+
+#endif
@@ -0,0 +1,119 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "resample.h" // ポリフェーズ標本化周波数変換
+#include "pcm_io.h"   // rawファイルの読み込み（mmap）
+#include "pcm_gain.h" // int16 ⇔ float の一括変換
+
+#define OUT_RATE 16000 // 既定の出力標本化周波数（解析系の SAMPLE_RATE）
+#define IN_RATE 48000  // raw 入力の既定の標本化周波数
+
+// 48kHz / 44.1kHz などの音声を 16kHz の raw に変換する（WAV なら入力の標本化周波数はヘッダから読む）
+int main(int argc, char *argv[])
+{
+    int in_rate = 0, out_rate = OUT_RATE, taps = RESAMPLE_TAPS, window_type = WINDOW_HAMMING;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "i:o:t:w:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'i': in_rate = atoi(optarg); break;
+        case 'o': out_rate = atoi(optarg); break;
+        case 't': taps = atoi(optarg); break;
+        case 'w':
+            if ((window_type = window_type_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind != 2)
+    {
+        fprintf(stderr, "使い方: %s [-i 入力の標本化周波数] [-o 出力の標本化周波数] [-t フィルタ長（低い方の標本化周波数の標本数）] [-w hamming|hann|rect] <入力ファイル名.raw|.wav|-> <出力ファイル名.raw>\n", argv[0]);
+        return 1;
+    }
+    const char *input_filename = argv[optind];
+    const char *output_filename = argv[optind + 1];
+
+    PCMData pcm;
+    if (pcm_open(input_filename, &pcm) != 0)
+    {
+        perror("入力ファイルが開けませんでした");
+        return 1;
+    }
+    if (in_rate == 0)
+        in_rate = pcm.sample_rate ? pcm.sample_rate : IN_RATE;
+
+    Resampler *r = resampler_create(in_rate, out_rate, taps, window_type);
+    if (!r)
+    {
+        fprintf(stderr, "パラメータが不正です\n");
+        return 1;
+    }
+
+    FILE *out = fopen(output_filename, "wb");
+    if (!out)
+    {
+        perror("出力ファイルが開けませんでした");
+        return 1;
+    }
+
+    long out_cap = resampler_max_output(r, RESAMPLE_BLOCK > r->P ? RESAMPLE_BLOCK : r->P);
+    float *fin = (float *)malloc(sizeof(float) * RESAMPLE_BLOCK);
+    float *fout = (float *)malloc(sizeof(float) * out_cap);
+    short *sout = (short *)malloc(sizeof(short) * out_cap);
+    if (!fin || !fout || !sout)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    long written = 0;
+    for (long pos = 0;; pos += RESAMPLE_BLOCK)
+    {
+        long n;
+        if (pos < pcm.length)
+        {
+            int len = pcm.length - pos < RESAMPLE_BLOCK ? (int)(pcm.length - pos) : RESAMPLE_BLOCK;
+            pcm_to_float(pcm.samples + pos, fin, len);
+            n = resampler_process(r, fin, len, fout);
+        }
+        else
+        {
+            n = resampler_flush(r, fout); // フィルタの遅延分の残り
+        }
+        float_to_pcm(fout, sout, n);
+        fwrite(sout, sizeof(short), n, out);
+        written += n;
+        if (pos >= pcm.length)
+            break;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    double audio_sec = (double)pcm.length / in_rate;
+    printf("%s (%d Hz, %ld 標本) を %d Hz (%ld 標本, 比 %d/%d) に変換して %s に出力しました。\n",
+           input_filename, in_rate, pcm.length, out_rate, written, r->L, r->M, output_filename);
+    if (elapsed > 0)
+        printf("処理時間 %.3f ms（実時間の %.0f 倍）\n", elapsed * 1e3, audio_sec / elapsed);
+
+    fclose(out);
+    free(fin);
+    free(fout);
+    free(sout);
+    resampler_destroy(r);
+    pcm_close(&pcm);
+    return 0;
+}
+
+// 例:
+// ./resample -i 48000 in48k.raw out16k.raw
+// ./resample in44k.wav out16k.raw
@@ -0,0 +1,182 @@
+#ifndef RESAMPLE_H
+#define RESAMPLE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "fir_filter.h" // kadai5 の sinc_h とベクトル型
+#include "stft.h"       // 窓関数
+
+// 有理数比のポリフェーズ標本化周波数変換（例: 48000 → 16000 は 1/3，44100 → 16000 は 160/441）
+//
+// L 倍に補間（ゼロ挿入）→ 低域通過フィルタ → 1/M に間引き，を出力に必要な係数だけで計算する．
+// フィルタは kadai5 の sinc_h に窓を掛けたもので，長さは低い方の標本化周波数の taps 標本分
+// （L·fin の速さで次数 taps·max(L, M)）．阻止域が低い方のナイキスト周波数から始まるように，
+// 窓で決まる遷移帯域の半分だけ遮断周波数を下げる（ナイキスト周波数のすぐ上の成分も折り返さない）．
+// L 個の位相ごとに係数を逆順・8の倍数長に並べておき，出力1標本を8要素ずつの内積1回で求める．
+// 出力はフィルタの遅延を補正して入力と時刻を揃える．
+
+#define RESAMPLE_TAPS 32    // 既定のタップ数（低い方の標本化周波数の標本数で数えたフィルタ長）
+#define RESAMPLE_BLOCK 4096 // 1回に渡せる入力標本数の上限
+
+typedef struct
+{
+    int in_rate, out_rate;
+    int L, M;          // 変換比 L/M（既約分数）
+    int P;             // 1位相あたりの係数の数（8の倍数）
+    float *bank;       // L × P の係数（位相ごとに逆順）
+    float *buf;        // 過去 P-1 標本 + 入力ブロック
+    int filled;        // buf に入っている標本数
+    long base;         // 次の出力が使う最後の入力標本の buf 上の位置
+    int phase;         // 次の出力の位相（0〜L-1）
+    long in_total, out_total; // これまでの入出力標本数
+} Resampler;
+
+// 窓を掛けた sinc の遷移帯域の幅（フィルタ長 N に対して 幅 ≈ 係数/N [周期/標本]）
+double resample_transition(int window_type)
+{
+    if (window_type == WINDOW_HANN)
+        return 3.1;
+    if (window_type == WINDOW_RECT)
+        return 0.9;
+    return 3.3; // ハミング窓
+}
+
+long resample_gcd(long a, long b)
+{
+    while (b)
+    {
+        long t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+void resampler_destroy(Resampler *r)
+{
+    if (!r)
+        return;
+    free(r->bank);
+    free(r->buf);
+    free(r);
+}
+
+// in_rate → out_rate の変換器を作成する（taps は低い方の標本化周波数で数えたフィルタ長，失敗時はNULL）
+Resampler *resampler_create(int in_rate, int out_rate, int taps, int window_type)
+{
+    if (in_rate <= 0 || out_rate <= 0 || taps <= resample_transition(window_type))
+        return NULL;
+
+    Resampler *r = (Resampler *)calloc(1, sizeof(Resampler));
+    if (!r)
+        return NULL;
+    long g = resample_gcd(in_rate, out_rate);
+    r->in_rate = in_rate;
+    r->out_rate = out_rate;
+    r->L = (int)(out_rate / g);
+    r->M = (int)(in_rate / g);
+    int K = r->L > r->M ? r->L : r->M;
+    int order = taps * K; // 補間後の速さでの次数（偶数なら中心がちょうど標本点）
+    r->P = (order / r->L + 1 + 7) / 8 * 8;
+
+    int L = r->L, P = r->P;
+    double *h = (double *)malloc(sizeof(double) * (order + 1));
+    double *w = (double *)malloc(sizeof(double) * (order + 1));
+    r->bank = (float *)calloc((size_t)L * P, sizeof(float));
+    r->buf = (float *)calloc(P - 1 + RESAMPLE_BLOCK, sizeof(float));
+    if (!h || !w || !r->bank || !r->buf)
+    {
+        free(h);
+        free(w);
+        resampler_destroy(r);
+        return NULL;
+    }
+
+    // 補間後の速さで見た遮断周波数（ナイキスト周波数に対する比）
+    // 遷移帯域の幅はこの比で 2·係数/order なので，低い方のナイキスト周波数 1/K からその半分だけ下げる
+    double cutoff = (1.0 - resample_transition(window_type) / taps) / K;
+    make_window(window_type, w, order + 1);
+    for (int n = 0; n <= order; ++n)
+        h[n] = sinc_h(n, order, cutoff) * w[n] * L; // ゼロ挿入で下がる振幅を L 倍して戻す
+
+    // 位相 p の係数 h[p + jL]（j = 0, 1, ...）を逆順に並べる
+    for (int p = 0; p < L; ++p)
+        for (int j = 0; p + j * L <= order; ++j)
+            r->bank[(size_t)p * P + (P - 1 - j)] = (float)h[p + j * L];
+    free(h);
+    free(w);
+
+    // 遅延 order/2（補間後の速さ）だけ先の入力を待ってから最初の出力を作る
+    r->filled = P - 1; // 過去の標本はゼロ
+    long delay = order / 2;
+    r->base = P - 1 + delay / L;
+    r->phase = (int)(delay % L);
+    return r;
+}
+
+// n 標本の入力で得られる出力の最大数
+long resampler_max_output(const Resampler *r, long n)
+{
+    return (n * r->L + r->M - 1) / r->M + 1;
+}
+
+// 入力 n 標本（n ≤ RESAMPLE_BLOCK）を与え，得られた出力を out に書いて個数を返す
+long resampler_process(Resampler *r, const float *in, int n, float *out)
+{
+    int P = r->P, L = r->L, M = r->M;
+    memcpy(r->buf + r->filled, in, sizeof(float) * n);
+    r->filled += n;
+    r->in_total += n;
+
+    long count = 0;
+    while (r->base < r->filled)
+    {
+        const float *x = r->buf + r->base - (P - 1);
+        const float *hp = r->bank + (size_t)r->phase * P;
+        fir_v8f acc = {0};
+        for (int k = 0; k < P; k += 8)
+        {
+            fir_v8f hv, xv;
+            memcpy(&hv, hp + k, sizeof(hv));
+            memcpy(&xv, x + k, sizeof(xv));
+            acc += hv * xv;
+        }
+        out[count++] = acc[0] + acc[1] + acc[2] + acc[3] + acc[4] + acc[5] + acc[6] + acc[7];
+
+        r->phase += M;
+        r->base += r->phase / L;
+        r->phase %= L;
+    }
+
+    // 次の出力に必要な過去 P-1 標本だけを残す
+    long keep_from = r->base - (P - 1);
+    if (keep_from > r->filled)
+        keep_from = r->filled;
+    if (keep_from > 0)
+    {
+        memmove(r->buf, r->buf + keep_from, sizeof(float) * (r->filled - keep_from));
+        r->filled -= (int)keep_from;
+        r->base -= keep_from;
+    }
+    r->out_total += count;
+    return count;
+}
+
+// 入力の終わりで残りの出力（フィルタの遅延分）を書き出す．出力の総数は ceil(入力数 × L / M)
+// out には resampler_max_output(r, r->P) 個以上の領域が必要
+long resampler_flush(Resampler *r, float *out)
+{
+    long want = (r->in_total * r->L + r->M - 1) / r->M;
+    long count = 0;
+    const float zero = 0.0f;
+    while (r->out_total < want)
+        count += resampler_process(r, &zero, 1, out + count);
+    count -= r->out_total - want; // 行き過ぎた分は捨てる
+    r->out_total = want;
+    return count;
+}
+
+#endif
@@ -0,0 +1,359 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// 内容で引く解析結果のキャッシュ
+// キーは入力標本のハッシュと解析パラメータ（文字列）のハッシュを組み合わせた64bit値で，
+// 結果はキャッシュディレクトリの <キー16進>.cache に置く．ヒットしたら mmap で読み，更新時刻を触って
+// 最近使ったことを記録する．保存で合計サイズが上限を超えたら更新時刻の古い順（LRU）に消す．
+// キーは入力とパラメータしか見ないので，パラメータには各ツールの出力の版（"v=1" など）も入れ，
+// 出力が変わる変更（解析・書式・使っているヘッダ）をしたら版を上げて古い結果を使わないようにする．
+
+#define CACHE_SUFFIX ".cache"
+#define CACHE_DEFAULT_MAX (256L << 20) // 既定の上限 [バイト]
+
+// ---- ハッシュ（XXH64）----
+
+#define XXH_P1 11400714785074694791ULL
+#define XXH_P2 14029467366897019727ULL
+#define XXH_P3 1609587929392839161ULL
+#define XXH_P4 9650029242287828579ULL
+#define XXH_P5 2870177450012600261ULL
+
+static inline uint64_t xxh_rotl(uint64_t x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline uint64_t xxh_read64(const unsigned char *p)
+{
+    uint64_t v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+static inline uint64_t xxh_round(uint64_t acc, uint64_t input)
+{
+    acc += input * XXH_P2;
+    acc = xxh_rotl(acc, 31);
+    return acc * XXH_P1;
+}
+
+static inline uint64_t xxh_merge(uint64_t acc, uint64_t v)
+{
+    acc ^= xxh_round(0, v);
+    return acc * XXH_P1 + XXH_P4;
+}
+
+// data（len バイト）の64bitハッシュ（リトルエンディアン環境の XXH64 と同じ値）
+uint64_t cache_hash(const void *data, size_t len, uint64_t seed)
+{
+    const unsigned char *p = (const unsigned char *)data, *end = p + len;
+    uint64_t h;
+
+    if (len >= 32) // 4本の独立な累積で32バイトずつ
+    {
+        uint64_t v1 = seed + XXH_P1 + XXH_P2, v2 = seed + XXH_P2, v3 = seed, v4 = seed - XXH_P1;
+        do
+        {
+            v1 = xxh_round(v1, xxh_read64(p));
+            v2 = xxh_round(v2, xxh_read64(p + 8));
+            v3 = xxh_round(v3, xxh_read64(p + 16));
+            v4 = xxh_round(v4, xxh_read64(p + 24));
+            p += 32;
+        } while (p + 32 <= end);
+        h = xxh_rotl(v1, 1) + xxh_rotl(v2, 7) + xxh_rotl(v3, 12) + xxh_rotl(v4, 18);
+        h = xxh_merge(h, v1);
+        h = xxh_merge(h, v2);
+        h = xxh_merge(h, v3);
+        h = xxh_merge(h, v4);
+    }
+    else
+    {
+        h = seed + XXH_P5;
+    }
+    h += len;
+
+    for (; p + 8 <= end; p += 8)
+        h = xxh_rotl(h ^ xxh_round(0, xxh_read64(p)), 27) * XXH_P1 + XXH_P4;
+    if (p + 4 <= end)
+    {
+        uint32_t v;
+        memcpy(&v, p, 4);
+        h = xxh_rotl(h ^ (v * XXH_P1), 23) * XXH_P2 + XXH_P3;
+        p += 4;
+    }
+    for (; p < end; ++p)
+        h = xxh_rotl(h ^ (*p * XXH_P5), 11) * XXH_P1;
+
+    h ^= h >> 33;
+    h *= XXH_P2;
+    h ^= h >> 29;
+    h *= XXH_P3;
+    h ^= h >> 32;
+    return h;
+}
+
+// 入力標本と解析パラメータ（例: "center;v=1;L=320;N=1024;win=hamming;fmt=txt"）からキーを作る
+uint64_t cache_key(const short *samples, long length, const char *params)
+{
+    uint64_t h = cache_hash(samples, sizeof(short) * length, 0);
+    return cache_hash(params, strlen(params), h);
+}
+
+// ---- キャッシュ本体 ----
+
+typedef struct
+{
+    char dir[1024];
+    long max_bytes;   // 合計サイズの上限
+    long total_bytes; // 合計サイズ（開いたときに数え，保存のたびに足す）
+    long hits, misses, evicted;
+} ResultCache;
+
+typedef struct
+{
+    const void *data; // mmap した結果
+    size_t size;
+    void *map;
+} CacheEntry;
+
+typedef struct
+{
+    char name[64];
+    long size;
+    struct timespec used;
+} CacheFileInfo;
+
+// 更新時刻（最後に使った時刻）．macOS では st_mtim ではなく st_mtimespec
+struct timespec cache_mtime(const struct stat *st)
+{
+#ifdef __APPLE__
+    return st->st_mtimespec;
+#else
+    return st->st_mtim;
+#endif
+}
+
+int cache_compare_used(const void *a, const void *b)
+{
+    const CacheFileInfo *x = (const CacheFileInfo *)a, *y = (const CacheFileInfo *)b;
+    if (x->used.tv_sec != y->used.tv_sec)
+        return x->used.tv_sec < y->used.tv_sec ? -1 : 1;
+    return (x->used.tv_nsec > y->used.tv_nsec) - (x->used.tv_nsec < y->used.tv_nsec);
+}
+
+// ディレクトリの結果ファイルの合計サイズを返す．files が NULL でなければ一覧（名前・サイズ・更新時刻）も作る
+long cache_scan(const ResultCache *c, CacheFileInfo **files, int *count)
+{
+    DIR *d = opendir(c->dir);
+    if (!d)
+        return 0;
+    CacheFileInfo *list = NULL;
+    int n = 0, cap = 0;
+    long total = 0;
+    struct dirent *ent;
+    while ((ent = readdir(d)) != NULL)
+    {
+        size_t len = strlen(ent->d_name);
+        if (len <= strlen(CACHE_SUFFIX) || len >= sizeof(list->name) ||
+            strcmp(ent->d_name + len - strlen(CACHE_SUFFIX), CACHE_SUFFIX) != 0)
+            continue;
+        char path[1100];
+        struct stat st;
+        snprintf(path, sizeof(path), "%s/%s", c->dir, ent->d_name);
+        if (stat(path, &st) != 0)
+            continue;
+        total += (long)st.st_size;
+        if (!files)
+            continue;
+        if (n == cap)
+        {
+            int grown_cap = cap ? cap * 2 : 64;
+            CacheFileInfo *grown = (CacheFileInfo *)realloc(list, sizeof(CacheFileInfo) * grown_cap);
+            if (!grown) // 確保できなければそこまでに見たファイルだけで判断する
+                break;
+            list = grown;
+            cap = grown_cap;
+        }
+        snprintf(list[n].name, sizeof(list[n].name), "%s", ent->d_name);
+        list[n].size = (long)st.st_size;
+        list[n].used = cache_mtime(&st);
+        n++;
+    }
+    closedir(d);
+    if (files)
+    {
+        *files = list;
+        *count = n;
+    }
+    return total;
+}
+
+// ディレクトリ dir をキャッシュとして開く（なければ作る．失敗時はNULL）
+ResultCache *cache_open(const char *dir, long max_bytes)
+{
+    mkdir(dir, 0755);
+    struct stat st;
+    if (stat(dir, &st) != 0 || !S_ISDIR(st.st_mode))
+        return NULL;
+    ResultCache *c = (ResultCache *)calloc(1, sizeof(ResultCache));
+    if (!c)
+        return NULL;
+    snprintf(c->dir, sizeof(c->dir), "%s", dir);
+    c->max_bytes = max_bytes > 0 ? max_bytes : CACHE_DEFAULT_MAX;
+    c->total_bytes = cache_scan(c, NULL, NULL);
+    return c;
+}
+
+void cache_close(ResultCache *c)
+{
+    free(c);
+}
+
+void cache_path(const ResultCache *c, uint64_t key, char *path, size_t size)
+{
+    snprintf(path, size, "%s/%016llx%s", c->dir, (unsigned long long)key, CACHE_SUFFIX);
+}
+
+// キーの結果があれば mmap して1を返す（なければ0）．使い終えたら cache_release
+int cache_lookup(ResultCache *c, uint64_t key, CacheEntry *e)
+{
+    char path[1100];
+    cache_path(c, key, path, sizeof(path));
+    memset(e, 0, sizeof(*e));
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+    {
+        c->misses++;
+        return 0;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        c->misses++;
+        return 0;
+    }
+    e->size = (size_t)st.st_size;
+    if (e->size > 0)
+    {
+        e->map = mmap(NULL, e->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (e->map == MAP_FAILED)
+        {
+            close(fd);
+            e->map = NULL;
+            c->misses++;
+            return 0;
+        }
+    }
+    e->data = e->map;
+    futimens(fd, NULL); // 最近使った印（LRU）
+    close(fd);
+    c->hits++;
+    return 1;
+}
+
+void cache_release(CacheEntry *e)
+{
+    if (e->map)
+        munmap(e->map, e->size);
+    memset(e, 0, sizeof(*e));
+}
+
+// ヒットした結果を filename にそのまま書き出す
+int cache_write_file(const CacheEntry *e, const char *filename)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (!fp)
+        return -1;
+    if (e->size > 0 && fwrite(e->data, 1, e->size, fp) != e->size)
+    {
+        fclose(fp);
+        return -1;
+    }
+    return fclose(fp);
+}
+
+// 合計サイズが上限以下になるまで，最後に使われたのが古いものから消す
+void cache_evict(ResultCache *c)
+{
+    CacheFileInfo *files = NULL;
+    int count = 0;
+    long total = cache_scan(c, &files, &count);
+    if (total > c->max_bytes)
+    {
+        qsort(files, count, sizeof(CacheFileInfo), cache_compare_used);
+        for (int i = 0; i < count && total > c->max_bytes; ++i)
+        {
+            char path[1100];
+            snprintf(path, sizeof(path), "%s/%s", c->dir, files[i].name);
+            if (unlink(path) == 0)
+            {
+                total -= files[i].size;
+                c->evicted++;
+            }
+        }
+    }
+    c->total_bytes = total;
+    free(files);
+}
+
+// data（size バイト）をキーの結果として保存する（一時ファイルに書いてから名前を変えるので途中の状態は見えない）
+int cache_store(ResultCache *c, uint64_t key, const void *data, size_t size)
+{
+    char path[1100], tmp[1200];
+    cache_path(c, key, path, sizeof(path));
+    snprintf(tmp, sizeof(tmp), "%s.%ld.tmp", path, (long)getpid());
+    FILE *fp = fopen(tmp, "wb");
+    if (!fp)
+        return -1;
+    struct stat old;
+    long replaced = stat(path, &old) == 0 ? (long)old.st_size : 0; // 同じキーを上書きするときはその分を引く
+    if ((size > 0 && fwrite(data, 1, size, fp) != size) | (fclose(fp) != 0) || rename(tmp, path) != 0)
+    {
+        unlink(tmp);
+        return -1;
+    }
+    // ディレクトリを見直すのは上限を超えたときだけ（保存のたびに全ファイルを stat しない）
+    c->total_bytes += (long)size - replaced;
+    if (c->total_bytes > c->max_bytes)
+        cache_evict(c);
+    return 0;
+}
+
+// 書き出し済みのファイル filename の内容をキーの結果として保存する
+int cache_store_file(ResultCache *c, uint64_t key, const char *filename)
+{
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    struct stat st;
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+    void *map = size > 0 ? mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    close(fd);
+    if (map == MAP_FAILED)
+        return -1;
+    int r = cache_store(c, key, map, size);
+    if (map)
+        munmap(map, size);
+    return r;
+}
+
+#endif
@@ -0,0 +1,344 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "stft.h"      // 窓関数・実数FFT・スペクトログラム形式
+#include "pcm_io.h"    // rawファイルの読み込み（mmap）
+#include "spsc_ring.h" // 取り込みスレッドと解析スレッドの受け渡し
+
+// 実時間の取り込み→解析パイプライン
+// 取り込みスレッドが標準入力・FIFO・（-r のとき）実時間の速さで再生したファイルからシフト幅ずつ読み，
+// ロックフリーのリングバッファで解析スレッドへ渡す．解析スレッドは窓掛け・FFT・対数パワーを行い，
+// 最後の標本が届いてから解析が終わるまでの遅延の分布と，リングが満杯で捨てたブロック数（オーバーラン）を報告する．
+
+#define SAMPLE_RATE 16000   // サンプリング周波数 [Hz]
+#define FRAME_LENGTH 320    // 既定のフレーム長 = 20ms
+#define HOP 160             // 既定のフレームシフト = 10ms
+#define N 1024              // 既定のFFT点数
+#define RING_BLOCKS 32      // 既定のリングの長さ [ブロック]
+#define IDLE_SLEEP_NS 100000 // リングが空のときの待ち時間 [ns]
+#define LATENCY_BUCKET_US 10 // 遅延ヒストグラムの刻み [µs]
+#define LATENCY_BUCKETS 10000 // 100ms まで（それ以上は最後の箱）
+
+// リングの1要素 = シフト幅分の標本と，その最後の標本が届いた時刻
+typedef struct
+{
+    double t_capture; // CLOCK_MONOTONIC [秒]
+    int count;        // 標本数（末尾のブロックだけ hop より少ない）
+    short samples[];
+} Block;
+
+typedef struct
+{
+    SPSCRing *ring;
+    int hop;
+    int sample_rate;
+    const char *input;
+    int replay;          // 1ならファイルを実時間で再生する
+    double speed;        // 再生速度（1 = 実時間）
+    long captured;       // 取り込んだブロック数
+    long overruns;       // リングが満杯で捨てたブロック数
+    atomic_int done;     // 取り込み終了
+    int failed;
+} Capture;
+
+typedef struct
+{
+    long counts[LATENCY_BUCKETS];
+    long total;
+    double sum, max;
+} LatencyHistogram;
+
+double now_sec(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+void latency_add(LatencyHistogram *h, double seconds)
+{
+    long b = (long)(seconds * 1e6 / LATENCY_BUCKET_US);
+    if (b < 0)
+        b = 0;
+    if (b >= LATENCY_BUCKETS)
+        b = LATENCY_BUCKETS - 1;
+    h->counts[b]++;
+    h->total++;
+    h->sum += seconds;
+    if (seconds > h->max)
+        h->max = seconds;
+}
+
+// p パーセンタイルの遅延 [ms]（箱の上端）
+double latency_percentile(const LatencyHistogram *h, double p)
+{
+    long target = (long)(h->total * p / 100.0 + 0.5), acc = 0;
+    if (target < 1)
+        target = 1;
+    for (int b = 0; b < LATENCY_BUCKETS; ++b)
+    {
+        acc += h->counts[b];
+        if (acc >= target)
+            return (b + 1) * LATENCY_BUCKET_US / 1000.0;
+    }
+    return h->max * 1e3;
+}
+
+// ブロックをリングへ渡す（満杯なら捨ててオーバーランを数える）
+void capture_push(Capture *c, const short *samples, int count, double t_capture)
+{
+    Block *b = (Block *)spsc_reserve(c->ring);
+    c->captured++;
+    if (!b)
+    {
+        c->overruns++;
+        return;
+    }
+    b->t_capture = t_capture;
+    b->count = count;
+    memcpy(b->samples, samples, sizeof(short) * count);
+    spsc_commit(c->ring);
+}
+
+// ファイルを実時間の速さで再生する（各ブロックは最後の標本の時刻に届いたものとする）
+void capture_replay(Capture *c)
+{
+    PCMData pcm;
+    if (pcm_open(c->input, &pcm) != 0)
+    {
+        perror(c->input);
+        c->failed = 1;
+        return;
+    }
+
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    double t0 = start.tv_sec + start.tv_nsec * 1e-9;
+
+    for (long pos = 0; pos < pcm.length; pos += c->hop)
+    {
+        int count = pcm.length - pos < c->hop ? (int)(pcm.length - pos) : c->hop;
+        double t = t0 + (pos + count) / (c->sample_rate * c->speed);
+        struct timespec due;
+        due.tv_sec = (time_t)t;
+        due.tv_nsec = (long)((t - due.tv_sec) * 1e9);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+            ;
+        capture_push(c, pcm.samples + pos, count, t);
+    }
+    pcm_close(&pcm);
+}
+
+// 標準入力・FIFO・ファイルから届いた順に読む
+void capture_stream(Capture *c)
+{
+    int fd = strcmp(c->input, "-") == 0 ? STDIN_FILENO : open(c->input, O_RDONLY); // FIFOは書き手が現れるまで待つ
+    if (fd < 0)
+    {
+        perror(c->input);
+        c->failed = 1;
+        return;
+    }
+
+    short *buf = (short *)malloc(sizeof(short) * c->hop);
+    size_t want = sizeof(short) * c->hop, got = 0;
+    for (;;)
+    {
+        ssize_t n = read(fd, (char *)buf + got, want - got);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        got += n;
+        if (got == want)
+        {
+            capture_push(c, buf, c->hop, now_sec());
+            got = 0;
+        }
+    }
+    if (got >= sizeof(short)) // 末尾の半端なブロック
+        capture_push(c, buf, (int)(got / sizeof(short)), now_sec());
+
+    free(buf);
+    if (fd != STDIN_FILENO)
+        close(fd);
+}
+
+void *capture_main(void *arg)
+{
+    Capture *c = (Capture *)arg;
+    if (c->replay)
+        capture_replay(c);
+    else
+        capture_stream(c);
+    atomic_store_explicit(&c->done, 1, memory_order_release);
+    return NULL;
+}
+
+int main(int argc, char *argv[])
+{
+    int frame_length = FRAME_LENGTH, hop = HOP, fft_size = N, sample_rate = SAMPLE_RATE;
+    int window_type = WINDOW_HAMMING, ring_blocks = RING_BLOCKS, replay = 0, load = 1;
+    double speed = 1.0;
+    const char *output_filename = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "l:s:n:w:q:rx:k:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l': frame_length = atoi(optarg); break;
+        case 's': hop = atoi(optarg); break;
+        case 'n': fft_size = atoi(optarg); break;
+        case 'q': ring_blocks = atoi(optarg); break;
+        case 'r': replay = 1; break;
+        case 'x': speed = atof(optarg); break;
+        case 'k': load = atoi(optarg); break;
+        case 'o': output_filename = optarg; break;
+        case 'w':
+            if ((window_type = window_type_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind != 1 || ring_blocks <= 0 || speed <= 0.0 || load <= 0 || (replay && strcmp(argv[optind], "-") == 0))
+    {
+        fprintf(stderr, "使い方: %s [-l フレーム長] [-s シフト] [-n FFT点数] [-w hamming|hann|rect] [-q リング長[ブロック]] [-k 負荷倍率] [-o 出力.bin] "
+                        "<-|FIFO|入力ファイル> | -r [-x 再生速度] <入力ファイル>\n", argv[0]);
+        return 1;
+    }
+
+    STFT *stft = stft_create(frame_length, hop, fft_size, window_type);
+    if (!stft)
+    {
+        fprintf(stderr, "パラメータが不正です（シフト ≤ フレーム長 ≤ FFT点数 が必要）\n");
+        return 1;
+    }
+
+    FILE *out = NULL;
+    SpectrogramHeader header;
+    if (output_filename)
+    {
+        if (!(out = fopen(output_filename, "wb")))
+        {
+            perror("出力ファイルオープン失敗");
+            return 1;
+        }
+        // フレーム数は最後にわかるので，ヘッダは後で書き直す
+        memcpy(header.magic, SPECTROGRAM_MAGIC, 4);
+        header.sample_rate = sample_rate;
+        header.frame_length = frame_length;
+        header.hop = hop;
+        header.fft_size = fft_size;
+        header.bins = stft->bins;
+        header.frames = 0;
+        fwrite(&header, sizeof(header), 1, out);
+    }
+
+    size_t block_size = (sizeof(Block) + sizeof(short) * hop + 7) & ~(size_t)7;
+    Capture cap = {0};
+    cap.ring = spsc_create(ring_blocks, block_size);
+    cap.hop = hop;
+    cap.sample_rate = sample_rate;
+    cap.input = argv[optind];
+    cap.replay = replay;
+    cap.speed = speed;
+    atomic_init(&cap.done, 0);
+
+    // 解析側の作業領域はすべてここで確保し，フレームごとには確保しない
+    double *frame = (double *)calloc(frame_length, sizeof(double));
+    float *row = (float *)malloc(sizeof(float) * stft->bins);
+    Block *block = (Block *)malloc(block_size);
+    LatencyHistogram *latency = (LatencyHistogram *)calloc(1, sizeof(LatencyHistogram));
+    if (!cap.ring || !frame || !row || !block || !latency)
+    {
+        fprintf(stderr, "作業バッファの確保に失敗しました\n");
+        return 1;
+    }
+
+    pthread_t tid;
+    pthread_create(&tid, NULL, capture_main, &cap);
+
+    double hop_sec = (double)hop / sample_rate;
+    long frames = 0, late = 0, filled = 0;
+    const struct timespec idle = {0, IDLE_SLEEP_NS};
+    double t_start = now_sec();
+
+    for (;;)
+    {
+        if (!spsc_pop(cap.ring, block))
+        {
+            if (atomic_load_explicit(&cap.done, memory_order_acquire) && !spsc_peek(cap.ring))
+                break;
+            nanosleep(&idle, NULL);
+            continue;
+        }
+
+        // フレームをシフト幅ぶん進めて新しい標本を後ろに足す（末尾の半端なブロックはゼロ詰め）
+        int keep = frame_length - hop;
+        memmove(frame, frame + hop, sizeof(double) * keep);
+        for (int i = 0; i < hop; ++i)
+            frame[keep + i] = i < block->count ? block->samples[i] : 0.0;
+        filled += block->count;
+        if (filled < frame_length)
+            continue;
+
+        for (int k = 0; k < load; ++k) // -k で解析負荷を上げて余裕を確かめる
+            stft_analyze(stft, frame);
+
+        double lat = now_sec() - block->t_capture;
+        latency_add(latency, lat);
+        late += lat > hop_sec;
+        frames++;
+
+        if (out)
+        {
+            for (int k = 0; k < stft->bins; ++k)
+                row[k] = (float)stft->log_power[k];
+            fwrite(row, sizeof(float), stft->bins, out);
+        }
+    }
+    pthread_join(tid, NULL);
+    double elapsed = now_sec() - t_start;
+
+    if (out)
+    {
+        header.frames = (int32_t)frames;
+        fseek(out, 0, SEEK_SET);
+        fwrite(&header, sizeof(header), 1, out);
+        fclose(out);
+    }
+
+    double audio_sec = (double)cap.captured * hop / sample_rate;
+    printf("%ld フレームを解析しました（%.2f 秒分の音声を %.2f 秒で処理）\n", frames, audio_sec, elapsed);
+    printf("オーバーラン: %ld / %ld ブロック, シフト幅 %.1f ms を超えた遅延: %ld フレーム\n",
+           cap.overruns, cap.captured, hop_sec * 1e3, late);
+    if (latency->total > 0)
+        printf("遅延 [ms]: 平均 %.3f, p50 %.2f, p90 %.2f, p99 %.2f, p99.9 %.2f, 最大 %.3f\n",
+               latency->sum / latency->total * 1e3,
+               latency_percentile(latency, 50.0), latency_percentile(latency, 90.0),
+               latency_percentile(latency, 99.0), latency_percentile(latency, 99.9), latency->max * 1e3);
+
+    spsc_destroy(cap.ring);
+    stft_destroy(stft);
+    free(frame);
+    free(row);
+    free(block);
+    free(latency);
+    return cap.failed ? 1 : 0;
+}
+
+// 例:
+// ./rt_pipeline -r a00.raw
+// ./rt_pipeline -r -x 4 -k 50 ../data3/music1.raw
+// arecord -r 16000 -f S16_LE -c 1 -t raw | ./rt_pipeline -o live.bin -
+// mkfifo /tmp/pcm && ./rt_pipeline /tmp/pcm
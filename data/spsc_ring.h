@@ -0,0 +1,107 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+
+// 単一生産者・単一消費者のロックフリーリングバッファ
+// 固定長の要素を capacity 個（2のべき乗に切り上げ）まで保持する．
+// head は生産者だけが，tail は消費者だけが進めるので，acquire/release の順序づけだけで排他なしに受け渡せる．
+#define SPSC_CACHE_LINE 64
+
+typedef struct
+{
+    _Atomic size_t head; // 書き込んだ要素数（生産者のみ更新）
+    char pad0[SPSC_CACHE_LINE - sizeof(size_t)];
+    _Atomic size_t tail; // 読み出した要素数（消費者のみ更新）
+    char pad1[SPSC_CACHE_LINE - sizeof(size_t)];
+    size_t capacity;  // 要素数（2のべき乗）
+    size_t elem_size; // 1要素のバイト数
+    unsigned char *data;
+} SPSCRing;
+
+SPSCRing *spsc_create(size_t capacity, size_t elem_size)
+{
+    size_t cap = 1;
+    while (cap < capacity)
+        cap <<= 1;
+
+    SPSCRing *r = (SPSCRing *)calloc(1, sizeof(SPSCRing));
+    if (!r)
+        return NULL;
+    r->data = (unsigned char *)malloc(cap * elem_size);
+    if (!r->data)
+    {
+        free(r);
+        return NULL;
+    }
+    r->capacity = cap;
+    r->elem_size = elem_size;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    return r;
+}
+
+void spsc_destroy(SPSCRing *r)
+{
+    if (!r)
+        return;
+    free(r->data);
+    free(r);
+}
+
+// 書き込み先を取得する（満杯ならNULL）．書き終えたら spsc_commit で公開する
+void *spsc_reserve(SPSCRing *r)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    if (head - tail == r->capacity)
+        return NULL;
+    return r->data + (head & (r->capacity - 1)) * r->elem_size;
+}
+
+void spsc_commit(SPSCRing *r)
+{
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+}
+
+// 先頭の要素を取得する（空ならNULL）．使い終えたら spsc_release で領域を返す
+void *spsc_peek(SPSCRing *r)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&r->head, memory_order_acquire);
+    if (head == tail)
+        return NULL;
+    return r->data + (tail & (r->capacity - 1)) * r->elem_size;
+}
+
+void spsc_release(SPSCRing *r)
+{
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+    atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+}
+
+// 要素をコピーして書き込む／読み出す（満杯・空なら0）
+int spsc_push(SPSCRing *r, const void *elem)
+{
+    void *slot = spsc_reserve(r);
+    if (!slot)
+        return 0;
+    memcpy(slot, elem, r->elem_size);
+    spsc_commit(r);
+    return 1;
+}
+
+int spsc_pop(SPSCRing *r, void *elem)
+{
+    void *slot = spsc_peek(r);
+    if (!slot)
+        return 0;
+    memcpy(elem, slot, r->elem_size);
+    spsc_release(r);
+    return 1;
+}
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "stft.h" // 短時間フーリエ変換
+
+#define SAMPLE_RATE 16000 // サンプリング周波数 [Hz]
+#define FRAME_LENGTH 320  // 既定のフレーム長 = 20ms
+#define HOP 160           // 既定のフレームシフト = 10ms
+#define N 1024            // 既定のFFT点数
+
+// 録音全体を先頭からフレームごとに解析し，スペクトログラムをバイナリで出力する
+int main(int argc, char *argv[])
+{
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    int frame_length = FRAME_LENGTH, hop = HOP, fft_size = N, sample_rate = SAMPLE_RATE;
+    int window_type = WINDOW_HAMMING;
+    int precision = PRECISION_DOUBLE;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "l:s:n:w:r:p:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'l': frame_length = atoi(optarg); break;
+        case 's': hop = atoi(optarg); break;
+        case 'n': fft_size = atoi(optarg); break;
+        case 'r': sample_rate = atoi(optarg); break;
+        case 'p':
+            precision = precision_from_name(optarg);
+            if (precision < 0)
+            {
+                fprintf(stderr, "不明な精度: %s\n", optarg);
+                return 1;
+            }
+            break;
+        case 'w':
+            window_type = window_type_from_name(optarg);
+            if (window_type < 0)
+            {
+                fprintf(stderr, "不明な窓関数: %s\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            argc = 0; // 使い方を表示させる
+        }
+    }
+
+    if (argc - optind != 2)
+    {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] [-l フレーム長] [-s シフト] [-n FFT点数] [-w hamming|hann|rect] [-r 標本化周波数] [-p double|float|q15] <入力ファイル名.raw|-> <出力ファイル名.bin>\n", argv[0]);
+        return 1;
+    }
+
+    const char *input_filename = argv[optind];
+    const char *output_filename = argv[optind + 1];
+
+    STFT *stft = stft_create(frame_length, hop, fft_size, window_type);
+    if (!stft)
+    {
+        fprintf(stderr, "パラメータが不正です（シフト ≤ フレーム長 ≤ FFT点数 が必要）\n");
+        return 1;
+    }
+    if (stft_set_precision(stft, precision) != 0)
+    {
+        fprintf(stderr, "単精度・Q15 の解析には2のべき乗のFFT点数が必要です\n");
+        stft_destroy(stft);
+        return 1;
+    }
+
+    PCMStream *in = pcm_stream_open(input_filename);
+    if (!in)
+    {
+        perror("入力ファイルオープン失敗");
+        stft_destroy(stft);
+        return 1;
+    }
+
+    FILE *out = fopen(output_filename, "wb");
+    if (!out)
+    {
+        perror("出力ファイルオープン失敗");
+        pcm_stream_close(in);
+        stft_destroy(stft);
+        return 1;
+    }
+
+    // フレーム数は最後にわかるので，ヘッダは後で書き直す
+    SpectrogramHeader header;
+    memcpy(header.magic, SPECTROGRAM_MAGIC, 4);
+    header.sample_rate = sample_rate;
+    header.frame_length = frame_length;
+    header.hop = hop;
+    header.fft_size = fft_size;
+    header.bins = stft->bins;
+    header.frames = 0;
+    fwrite(&header, sizeof(header), 1, out);
+
+    float *row = (float *)malloc(sizeof(float) * stft->bins);
+    if (!row)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    while (stft_next_frame(stft, in))
+    {
+        TRACE_BEGIN(t);
+        for (int k = 0; k < stft->bins; ++k)
+            row[k] = (float)stft->log_power[k];
+        fwrite(row, sizeof(float), stft->bins, out);
+        TRACE_END(t, STAGE_WRITE, stft->bins);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    header.frames = (int32_t)stft->frames;
+    if (fseek(out, 0, SEEK_SET) != 0 || fwrite(&header, sizeof(header), 1, out) != 1)
+    {
+        perror("ヘッダ書き込み失敗");
+        return 1;
+    }
+
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    double audio_sec = (double)(stft->frames - 1) * hop / sample_rate + (double)frame_length / sample_rate;
+    printf("%s のスペクトログラム (%ld フレーム × %d ビン) を %s に出力しました。\n",
+           input_filename, stft->frames, stft->bins, output_filename);
+    if (stft->frames > 0 && elapsed > 0)
+        printf("処理時間 %.3f ms（実時間の %.0f 倍）\n", elapsed * 1e3, audio_sec / elapsed);
+
+    free(row);
+    fclose(out);
+    pcm_stream_close(in);
+    stft_destroy(stft);
+    return 0;
+}
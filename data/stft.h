@@ -0,0 +1,258 @@
+#ifndef STFT_H
+#define STFT_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#include "DFT_IDFT_kadai3.h"
+#include "fft_precision.h"
+#include "pcm_io.h"
+
+// 窓関数の種類
+enum
+{
+    WINDOW_HAMMING,
+    WINDOW_HANN,
+    WINDOW_RECT
+};
+
+// 窓関数名（"hamming", "hann", "rect"）を種類に変換する（不明なら-1）
+int window_type_from_name(const char *name)
+{
+    if (strcmp(name, "hamming") == 0)
+        return WINDOW_HAMMING;
+    if (strcmp(name, "hann") == 0)
+        return WINDOW_HANN;
+    if (strcmp(name, "rect") == 0)
+        return WINDOW_RECT;
+    return -1;
+}
+
+// 長さLの窓係数をwに書き込む（kadai4のapply_hamming_windowと同じ定義式）
+void make_window(int type, double *w, int L)
+{
+    for (int n = 0; n < L; ++n)
+    {
+        double phase = (L > 1) ? 2.0 * M_PI * n / (L - 1) : 0.0;
+        if (type == WINDOW_HAMMING)
+            w[n] = 0.54 - 0.46 * cos(phase);
+        else if (type == WINDOW_HANN)
+            w[n] = 0.5 - 0.5 * cos(phase);
+        else
+            w[n] = 1.0;
+    }
+}
+
+// 短時間フーリエ変換（STFT）の状態
+// 窓係数・FFTプラン・フレームバッファは作成時に一度だけ確保し，全フレームで使い回す
+typedef struct
+{
+    int frame_length; // フレーム長（窓長）[標本]
+    int hop;          // フレームシフト [標本]
+    int fft_size;     // FFT点数（frame_length以上，超えた分はゼロ詰め）
+    int bins;         // 出力ビン数 = fft_size/2+1
+    long frames;      // これまでに出力したフレーム数
+    int filled;       // samplesに溜まっている標本数
+    int eof;          // 入力が終端に達したら1
+
+    double *window;    // 窓係数（長さframe_length）
+    double *samples;   // 直近frame_length標本の履歴
+    double *frame;     // 窓掛け後のFFT入力（長さfft_size）
+    double *Xr, *Xi;   // スペクトル（長さbins）
+    double *log_power; // 対数パワースペクトル [dB]（長さbins）
+    short *pcm;        // 読み込み用の一時バッファ（長さframe_length）
+    RFFTPlan *plan;
+
+    // 単精度・Q15 で解析するとき（stft_set_precision）の作業領域．Xr/Xi は更新されない
+    int precision;     // PRECISION_DOUBLE / FLOAT / Q15
+    RFFTPlanLP *lp;
+    float *wf, *fr, *fXr, *fXi; // float の窓係数（frame_length），FFT入力（fft_size），スペクトル（bins）
+    short *wq, *qr;             // Q15 の窓係数とFFT入力
+    int *qXr, *qXi;             // Q15 のスペクトル（bins）
+} STFT;
+
+void stft_destroy(STFT *s)
+{
+    if (!s)
+        return;
+    free(s->window);
+    free(s->samples);
+    free(s->frame);
+    free(s->Xr);
+    free(s->Xi);
+    free(s->log_power);
+    free(s->pcm);
+    rfft_plan_destroy(s->plan);
+    rfft_lp_plan_destroy(s->lp);
+    free(s->wf);
+    free(s->fr);
+    free(s->fXr);
+    free(s->fXi);
+    free(s->wq);
+    free(s->qr);
+    free(s->qXr);
+    free(s->qXi);
+    free(s);
+}
+
+// STFTを作成する（引数が不正・確保失敗ならNULL）
+STFT *stft_create(int frame_length, int hop, int fft_size, int window_type)
+{
+    if (frame_length <= 0 || hop <= 0 || hop > frame_length || fft_size < frame_length)
+        return NULL;
+
+    STFT *s = (STFT *)calloc(1, sizeof(STFT));
+    if (!s)
+        return NULL;
+    s->frame_length = frame_length;
+    s->hop = hop;
+    s->fft_size = fft_size;
+    s->bins = fft_size / 2 + 1;
+
+    s->window = (double *)malloc(sizeof(double) * frame_length);
+    s->samples = (double *)calloc(frame_length, sizeof(double));
+    s->frame = (double *)calloc(fft_size, sizeof(double));
+    s->Xr = (double *)malloc(sizeof(double) * s->bins);
+    s->Xi = (double *)malloc(sizeof(double) * s->bins);
+    s->log_power = (double *)malloc(sizeof(double) * s->bins);
+    s->pcm = (short *)malloc(sizeof(short) * frame_length);
+    s->plan = rfft_plan_create(fft_size);
+    if (!s->window || !s->samples || !s->frame || !s->Xr || !s->Xi || !s->log_power || !s->pcm || !s->plan)
+    {
+        stft_destroy(s);
+        return NULL;
+    }
+
+    make_window(window_type, s->window, frame_length);
+    return s;
+}
+
+// 解析の精度を切り替える（単精度・Q15 は FFT点数が2のべき乗のときのみ．失敗なら-1）
+int stft_set_precision(STFT *s, int precision)
+{
+    if (precision != PRECISION_DOUBLE && !s->lp)
+    {
+        int L = s->frame_length, n = s->fft_size;
+        s->lp = rfft_lp_plan_create(n);
+        s->wf = (float *)malloc(sizeof(float) * L);
+        s->fr = (float *)calloc(n, sizeof(float));
+        s->fXr = (float *)malloc(sizeof(float) * s->bins);
+        s->fXi = (float *)malloc(sizeof(float) * s->bins);
+        s->wq = (short *)malloc(sizeof(short) * L);
+        s->qr = (short *)calloc(n, sizeof(short));
+        s->qXr = (int *)malloc(sizeof(int) * s->bins);
+        s->qXi = (int *)malloc(sizeof(int) * s->bins);
+        if (!s->lp || !s->wf || !s->fr || !s->fXr || !s->fXi || !s->wq || !s->qr || !s->qXr || !s->qXi)
+            return -1;
+        window_to_float(s->window, s->wf, L);
+        window_to_q15(s->window, s->wq, L);
+    }
+    s->precision = precision;
+    return 0;
+}
+
+// 単精度で1フレームを解析する
+void stft_analyze_float(STFT *s, const double *samples)
+{
+    int L = s->frame_length;
+    TRACE_BEGIN(t);
+    for (int n = 0; n < L; ++n)
+        s->fr[n] = (float)samples[n] * s->wf[n];
+    TRACE_END(t, STAGE_WINDOW, L);
+    // frame_length以降は作成時にゼロ詰め済み
+    rfft_float(s->lp, s->fr, s->fXr, s->fXi);
+    log_power_float(s->fXr, s->fXi, s->log_power, s->bins);
+}
+
+// Q15 固定小数点で1フレームを解析する（標本は16bitに丸める）
+void stft_analyze_q15(STFT *s, const double *samples)
+{
+    int L = s->frame_length;
+    for (int n = 0; n < L; ++n)
+        s->pcm[n] = pcm_float_to_short((float)samples[n]);
+    int exponent = window_apply_q15(s->pcm, s->wq, s->qr, L);
+    exponent += rfft_q15(s->lp, s->qr, s->qXr, s->qXi);
+    log_power_q15(s->qXr, s->qXi, exponent, s->log_power, s->bins);
+}
+
+// samples（長さframe_length）の1フレームを窓掛け・FFTし，s->log_powerに対数パワースペクトルを求める
+void stft_analyze(STFT *s, const double *samples)
+{
+    if (s->precision == PRECISION_FLOAT)
+    {
+        stft_analyze_float(s, samples);
+        return;
+    }
+    if (s->precision == PRECISION_Q15)
+    {
+        stft_analyze_q15(s, samples);
+        return;
+    }
+
+    TRACE_BEGIN(tw);
+    for (int n = 0; n < s->frame_length; ++n)
+        s->frame[n] = samples[n] * s->window[n];
+    // frame_length以降は作成時にゼロ詰め済み
+    TRACE_END(tw, STAGE_WINDOW, s->frame_length);
+
+    rfft_forward(s->plan, s->frame, s->Xr, s->Xi);
+
+    TRACE_BEGIN(tl);
+    for (int k = 0; k < s->bins; ++k)
+    {
+        double power = s->Xr[k] * s->Xr[k] + s->Xi[k] * s->Xi[k];
+        s->log_power[k] = 10.0 * log10(power + 1e-12);
+    }
+    TRACE_END(tl, STAGE_LOG_POWER, s->bins);
+}
+
+// 入力から次のフレームを読み進めて解析する
+// フレームが得られたら1，入力が尽きたら0を返す（末尾の半端なフレームはゼロ詰めして出力する）
+int stft_next_frame(STFT *s, PCMStream *in)
+{
+    if (s->eof)
+        return 0;
+
+    int keep = (s->frames == 0) ? 0 : s->frame_length - s->hop; // 前のフレームから引き継ぐ標本数
+    if (keep > s->filled)
+        keep = s->filled;
+    memmove(s->samples, s->samples + (s->filled - keep), sizeof(double) * keep);
+
+    int want = s->frame_length - keep;
+    size_t got = pcm_stream_read(in, s->pcm, want);
+    for (size_t i = 0; i < got; ++i)
+        s->samples[keep + i] = (double)s->pcm[i];
+    s->filled = keep + (int)got;
+
+    if ((int)got < want)
+    {
+        s->eof = 1;
+        if (got == 0) // 新しい標本がなければフレームは出さない
+            return 0;
+        memset(s->samples + s->filled, 0, sizeof(double) * (s->frame_length - s->filled));
+    }
+
+    stft_analyze(s, s->samples);
+    s->frames++;
+    return 1;
+}
+
+// スペクトログラムのバイナリ出力形式
+// ヘッダの後に float32 の対数パワー [dB] が frames × bins の行優先で並ぶ
+#define SPECTROGRAM_MAGIC "SPEC"
+
+typedef struct
+{
+    char magic[4];        // "SPEC"
+    int32_t sample_rate;  // サンプリング周波数 [Hz]
+    int32_t frame_length; // フレーム長 [標本]
+    int32_t hop;          // フレームシフト [標本]
+    int32_t fft_size;     // FFT点数
+    int32_t bins;         // 1フレームあたりの値の数
+    int32_t frames;       // フレーム数
+} SpectrogramHeader;
+
+#endif
@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "sysid.h"  // ブロック平均のクロススペクトル
+#include "pcm_io.h" // rawファイルの逐次読み込み
+#include "out_io.h" // テキスト／バイナリ出力
+
+#define SAMPLE_RATE 16000 // サンプリング周波数 [Hz]
+#define BLOCK 4096        // 既定のブロック長（インパルス応答）
+#define TAPS 1024         // 既定のインパルス応答の長さ [標本]
+#define MAX_LAG_MS 500    // 既定の最大遅延 [ms]
+#define READ_BLOCK 4096   // 1回に読む標本数
+
+enum
+{
+    MODE_IR,   // インパルス応答・周波数特性
+    MODE_DELAY // 遅延推定
+};
+
+// ストリームから n 標本読む（終わりに達したら読めた分だけ）
+long read_full(PCMStream *s, short *buf, long n)
+{
+    long got = 0;
+    while (got < n)
+    {
+        size_t r = pcm_stream_read(s, buf + got, n - got);
+        if (r == 0)
+            break;
+        got += (long)r;
+    }
+    return got;
+}
+
+// 周波数特性を "周波数[kHz] 振幅[dB] 位相[rad] コヒーレンス" で書く（バイナリなら3列）
+int write_response(const char *filename, int format, const CrossSpectrum *c, int sample_rate)
+{
+    int bins = c->bins;
+    double *Hr = (double *)malloc(sizeof(double) * bins * 5);
+    if (!Hr)
+        return -1;
+    double *Hi = Hr + bins, *coh = Hi + bins, *mag = coh + bins, *phase = mag + bins;
+    xspec_response(c, Hr, Hi, coh);
+    for (int k = 0; k < bins; ++k)
+    {
+        mag[k] = 10.0 * log10(Hr[k] * Hr[k] + Hi[k] * Hi[k] + 1e-12);
+        phase[k] = atan2(Hi[k], Hr[k]);
+    }
+
+    double freq_step = (double)sample_rate / c->N / 1000.0;
+    int ret;
+    if (format == OUT_BINARY)
+    {
+        ColumnWriter *w = col_open(filename, bins, 3, 0.0, freq_step, "kHz", "dB,rad,-");
+        if (!w)
+        {
+            free(Hr);
+            return -1;
+        }
+        col_write_double(w, mag, bins);
+        col_write_double(w, phase, bins);
+        col_write_double(w, coh, bins);
+        ret = col_close(w);
+    }
+    else
+    {
+        TextWriter *w = tw_open(filename);
+        if (!w)
+        {
+            free(Hr);
+            return -1;
+        }
+        for (int k = 0; k < bins; ++k)
+        {
+            tw_fixed(w, k * freq_step, 6);
+            tw_char(w, ' ');
+            tw_fixed(w, mag[k], 6);
+            tw_char(w, ' ');
+            tw_fixed(w, phase[k], 6);
+            tw_char(w, ' ');
+            tw_fixed(w, coh[k], 6);
+            tw_char(w, '\n');
+        }
+        ret = tw_close(w);
+    }
+    free(Hr);
+    return ret;
+}
+
+int main(int argc, char *argv[])
+{
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    int mode = MODE_IR, N = 0, taps = TAPS, max_lag_ms = MAX_LAG_MS, phat = 1;
+    int window_type = WINDOW_HANN, sample_rate = SAMPLE_RATE, format = OUT_TEXT;
+    const char *response_filename = NULL;
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:n:t:l:w:cH:r:F:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            if (strcmp(optarg, "ir") == 0)
+                mode = MODE_IR;
+            else if (strcmp(optarg, "delay") == 0)
+                mode = MODE_DELAY;
+            else
+                argc = 0;
+            break;
+        case 'n': N = atoi(optarg); break;
+        case 't': taps = atoi(optarg); break;
+        case 'l': max_lag_ms = atoi(optarg); break;
+        case 'w':
+            if ((window_type = window_type_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        case 'c': phat = 0; break;
+        case 'H': response_filename = optarg; break;
+        case 'r': sample_rate = atoi(optarg); break;
+        case 'F':
+            if ((format = out_format_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        default: argc = 0;
+        }
+    }
+
+    int outputs = argc - optind - 2;
+    if (outputs < 0 || outputs > 1 || (mode == MODE_IR && outputs != 1) || sample_rate <= 0 || max_lag_ms <= 0)
+    {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] [-m ir|delay] [-n ブロック長] [-w hann|hamming|rect] [-r 標本化周波数] [-F txt|bin]\n"
+                        "         [-t タップ数] [-H 周波数特性ファイル]（ir） [-l 最大遅延[ms]] [-c]（delay，-c は PHAT 重みなし）\n"
+                        "         <励振ファイル名.raw|-> <応答ファイル名.raw|-> <出力ファイル名>（delay では出力は省略可）\n",
+                argv[0]);
+        return 1;
+    }
+    const char *x_filename = argv[optind];
+    const char *y_filename = argv[optind + 1];
+    const char *output_filename = outputs ? argv[optind + 2] : NULL;
+
+    // 遅延推定のブロック長は最大遅延の4倍以上の2のべき
+    int max_lag = (int)((long)sample_rate * max_lag_ms / 1000);
+    if (N == 0 && mode == MODE_DELAY)
+    {
+        N = 1024;
+        while (N < 4 * max_lag)
+            N *= 2;
+    }
+    else if (N == 0)
+        N = BLOCK;
+    if (mode == MODE_IR && taps > N)
+    {
+        fprintf(stderr, "タップ数はブロック長（%d）以下にしてください\n", N);
+        return 1;
+    }
+
+    CrossSpectrum *c = xspec_create(N, window_type);
+    if (!c)
+    {
+        fprintf(stderr, "パラメータが不正です（ブロック長は4以上の偶数）\n");
+        return 1;
+    }
+
+    PCMStream *xs = pcm_stream_open(x_filename);
+    PCMStream *ys = xs ? pcm_stream_open(y_filename) : NULL;
+    if (!xs || !ys)
+    {
+        perror("入力ファイルが開けませんでした");
+        return 1;
+    }
+
+    short *xb = (short *)malloc(sizeof(short) * READ_BLOCK);
+    short *yb = (short *)malloc(sizeof(short) * READ_BLOCK);
+    if (!xb || !yb)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+
+    // 両方を同じ位置から読み，短い方の終わりまで使う
+    long total = 0, nx, ny;
+    do
+    {
+        nx = read_full(xs, xb, READ_BLOCK);
+        ny = read_full(ys, yb, READ_BLOCK);
+        long n = nx < ny ? nx : ny;
+        xspec_push(c, xb, yb, n);
+        total += n;
+    } while (nx == READ_BLOCK && ny == READ_BLOCK);
+    xspec_finish(c);
+
+    if (c->blocks == 0)
+    {
+        fprintf(stderr, "入力が空です\n");
+        return 1;
+    }
+
+    double *result = NULL, delay = 0.0, peak = 0.0;
+    long rows = 0;
+    if (mode == MODE_IR)
+    {
+        rows = taps;
+        result = (double *)malloc(sizeof(double) * rows);
+        if (!result || xspec_impulse(c, result, taps) != 0)
+        {
+            perror("malloc");
+            return 1;
+        }
+    }
+    else
+    {
+        if (max_lag >= N / 2)
+            max_lag = N / 2 - 1;
+        rows = 2L * max_lag + 1;
+        result = (double *)malloc(sizeof(double) * rows);
+        if (!result)
+        {
+            perror("malloc");
+            return 1;
+        }
+        delay = xspec_delay(c, phat, max_lag, &peak, result);
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    // インパルス応答は "n h[n]"（kadai5 の impulse_N*.txt と同じ形），相関は "遅延[ms] 値"
+    int ret = 0;
+    if (output_filename)
+    {
+        if (mode == MODE_IR)
+            ret = out_write_series(output_filename, format, result, rows, 0.0, 1.0, -1, 6, ' ', "n", "");
+        else
+            ret = out_write_series(output_filename, format, result, rows, -max_lag * 1000.0 / sample_rate,
+                                   1000.0 / sample_rate, 4, 6, ' ', "ms", "");
+    }
+    if (ret == 0 && response_filename)
+        ret = write_response(response_filename, format, c, sample_rate);
+    if (ret != 0)
+    {
+        perror("出力ファイルの書き込みに失敗しました");
+        return 1;
+    }
+
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    if (mode == MODE_IR)
+    {
+        int at = 0;
+        for (int n = 1; n < taps; ++n)
+            if (fabs(result[n]) > fabs(result[at]))
+                at = n;
+        printf("%s → %s のインパルス応答 %d 標本を %s に出力しました（N=%d, %ld ブロック平均，最大 %.6f @ %d 標本）\n",
+               x_filename, y_filename, taps, output_filename, N, c->blocks, result[at], at);
+    }
+    else
+    {
+        printf("%s に対する %s の遅延: %.2f 標本 = %.3f ms（相関の最大値 %.4f，%s，N=%d, %ld ブロック平均）\n",
+               x_filename, y_filename, delay, delay * 1000.0 / sample_rate, peak, phat ? "PHAT" : "重みなし", N, c->blocks);
+    }
+    if (elapsed > 0)
+        printf("%ld 標本, 処理時間 %.3f ms（実時間の %.0f 倍）\n", total, elapsed * 1e3, (double)total / sample_rate / elapsed);
+
+    free(result);
+    free(xb);
+    free(yb);
+    pcm_stream_close(xs);
+    pcm_stream_close(ys);
+    xspec_destroy(c);
+    return 0;
+}
+
+// 例:
+// ./sysid -H room_freq.txt White_noise_16kHz16bit_mono.raw room_rec.raw room_ir.txt   (インパルス応答と周波数特性)
+// ./sysid -m delay -l 200 mic1.raw mic2.raw                                             (2つの録音のずれ)
@@ -0,0 +1,240 @@
+#ifndef SYSID_H
+#define SYSID_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "DFT_IDFT_kadai3.h" // 実数FFT/逆FFT
+#include "stft.h"            // 窓関数
+
+// 励振信号 x と応答 y からの系の同定（インパルス応答・周波数特性）と遅延推定
+// 長さ N のブロックを N/2 ずつずらして窓を掛けて変換し，ブロックごとに
+//   Sxx = Σ|X|^2，Syy = Σ|Y|^2，Sxy = Σ conj(X)·Y
+// を足し込む（Welch 法）．メモリはブロック長で決まり，信号の長さによらない．
+//   周波数特性: H = Sxy / Sxx（H1 推定．y 側の雑音は平均で消える），コヒーレンス |Sxy|^2 / (Sxx·Syy)
+//   インパルス応答: H の逆FFT の先頭（N はインパルス応答の長さ＋遅延より十分長くする）
+//   遅延: Sxy（PHAT なら Sxy/|Sxy|）の逆FFT = 相互相関の最大値の位置．y が x より d 標本遅れていれば +d
+//         窓が重なる範囲でしか相関が出ないので，探す遅延は N/4 程度までにする
+
+typedef struct
+{
+    int N;                    // ブロック長（FFT点数）
+    int hop;                  // ブロックシフト = N/2
+    int bins;                 // N/2+1
+    double *window;           // 窓（長さN）
+    double *x, *y;            // 直近 N 標本（励振・応答）
+    int filled;               // x, y に入っている標本数
+    double *frame;            // FFT入出力（長さN）
+    double *Xr, *Xi, *Yr, *Yi; // スペクトル（長さbins）
+    double *sxx, *syy;        // パワーの和（長さbins）
+    double *sxy_re, *sxy_im;  // クロススペクトルの和（長さbins）
+    long blocks;              // 足し込んだブロック数
+    RFFTPlan *plan;
+} CrossSpectrum;
+
+void xspec_destroy(CrossSpectrum *c)
+{
+    if (!c)
+        return;
+    free(c->window);
+    free(c->x);
+    free(c->y);
+    free(c->frame);
+    free(c->Xr);
+    free(c->Xi);
+    free(c->Yr);
+    free(c->Yi);
+    free(c->sxx);
+    free(c->syy);
+    free(c->sxy_re);
+    free(c->sxy_im);
+    rfft_plan_destroy(c->plan);
+    free(c);
+}
+
+// ブロック長 N（偶数），窓 window_type の推定器を作る（失敗時はNULL）
+CrossSpectrum *xspec_create(int N, int window_type)
+{
+    if (N < 4 || N % 2 != 0 || window_type < 0)
+        return NULL;
+
+    CrossSpectrum *c = (CrossSpectrum *)calloc(1, sizeof(CrossSpectrum));
+    if (!c)
+        return NULL;
+    c->N = N;
+    c->hop = N / 2;
+    c->bins = N / 2 + 1;
+
+    c->window = (double *)malloc(sizeof(double) * N);
+    c->x = (double *)calloc(N, sizeof(double));
+    c->y = (double *)calloc(N, sizeof(double));
+    c->frame = (double *)malloc(sizeof(double) * N);
+    c->Xr = (double *)malloc(sizeof(double) * c->bins);
+    c->Xi = (double *)malloc(sizeof(double) * c->bins);
+    c->Yr = (double *)malloc(sizeof(double) * c->bins);
+    c->Yi = (double *)malloc(sizeof(double) * c->bins);
+    c->sxx = (double *)calloc(c->bins, sizeof(double));
+    c->syy = (double *)calloc(c->bins, sizeof(double));
+    c->sxy_re = (double *)calloc(c->bins, sizeof(double));
+    c->sxy_im = (double *)calloc(c->bins, sizeof(double));
+    c->plan = rfft_plan_create(N);
+    if (!c->window || !c->x || !c->y || !c->frame || !c->Xr || !c->Xi || !c->Yr || !c->Yi ||
+        !c->sxx || !c->syy || !c->sxy_re || !c->sxy_im || !c->plan)
+    {
+        xspec_destroy(c);
+        return NULL;
+    }
+    make_window(window_type, c->window, N);
+    return c;
+}
+
+// x, y の現在のブロックを変換して和に加える
+void xspec_block(CrossSpectrum *c)
+{
+    TRACE_BEGIN(t);
+    for (int n = 0; n < c->N; ++n)
+        c->frame[n] = c->x[n] * c->window[n];
+    TRACE_END(t, STAGE_WINDOW, c->N);
+    rfft_forward(c->plan, c->frame, c->Xr, c->Xi);
+
+    TRACE_BEGIN(t2);
+    for (int n = 0; n < c->N; ++n)
+        c->frame[n] = c->y[n] * c->window[n];
+    TRACE_END(t2, STAGE_WINDOW, c->N);
+    rfft_forward(c->plan, c->frame, c->Yr, c->Yi);
+
+    for (int k = 0; k < c->bins; ++k)
+    {
+        double xr = c->Xr[k], xi = c->Xi[k], yr = c->Yr[k], yi = c->Yi[k];
+        c->sxx[k] += xr * xr + xi * xi;
+        c->syy[k] += yr * yr + yi * yi;
+        c->sxy_re[k] += xr * yr + xi * yi; // conj(X)·Y
+        c->sxy_im[k] += xr * yi - xi * yr;
+    }
+    c->blocks++;
+}
+
+// 励振 x と応答 y（同じ時刻の標本を n 標本ずつ）を入れる．N 標本そろうたびに1ブロック処理し，hop だけ進める
+void xspec_push(CrossSpectrum *c, const short *x, const short *y, long n)
+{
+    for (long i = 0; i < n;)
+    {
+        long m = c->N - c->filled < n - i ? c->N - c->filled : n - i;
+        for (long j = 0; j < m; ++j)
+        {
+            c->x[c->filled + j] = x[i + j];
+            c->y[c->filled + j] = y[i + j];
+        }
+        c->filled += (int)m;
+        i += m;
+        if (c->filled == c->N)
+        {
+            xspec_block(c);
+            memmove(c->x, c->x + c->hop, sizeof(double) * (c->N - c->hop));
+            memmove(c->y, c->y + c->hop, sizeof(double) * (c->N - c->hop));
+            c->filled = c->N - c->hop;
+        }
+    }
+}
+
+// 入力の終わり．信号が N より短くて1ブロックもできなかったときだけ，ゼロ詰めして1ブロック処理する
+// （平均に加えるブロックの長さをそろえるため，2ブロック目以降の半端な標本は使わない）
+void xspec_finish(CrossSpectrum *c)
+{
+    if (c->blocks > 0 || c->filled == 0)
+        return;
+    memset(c->x + c->filled, 0, sizeof(double) * (c->N - c->filled));
+    memset(c->y + c->filled, 0, sizeof(double) * (c->N - c->filled));
+    xspec_block(c);
+    c->filled = 0;
+}
+
+// 周波数特性 H = Sxy/Sxx（Hr/Hi）とコヒーレンス（coherence，NULL可）を bins 本ずつ求める
+// 励振にほとんど含まれないビン（Sxx が平均の 1e-10 倍未満）は H = 0 とする
+void xspec_response(const CrossSpectrum *c, double *Hr, double *Hi, double *coherence)
+{
+    double mean = 0.0;
+    for (int k = 0; k < c->bins; ++k)
+        mean += c->sxx[k];
+    double eps = mean / c->bins * 1e-10 + 1e-300;
+
+    for (int k = 0; k < c->bins; ++k)
+    {
+        double sxx = c->sxx[k];
+        int valid = sxx > eps;
+        Hr[k] = valid ? c->sxy_re[k] / sxx : 0.0;
+        Hi[k] = valid ? c->sxy_im[k] / sxx : 0.0;
+        if (coherence)
+        {
+            double cross = c->sxy_re[k] * c->sxy_re[k] + c->sxy_im[k] * c->sxy_im[k];
+            double denom = sxx * c->syy[k];
+            coherence[k] = denom > 0.0 ? cross / denom : 0.0;
+        }
+    }
+}
+
+// インパルス応答の先頭 taps 標本（taps ≤ N）を h に書く（失敗なら-1）
+int xspec_impulse(CrossSpectrum *c, double *h, int taps)
+{
+    if (taps <= 0 || taps > c->N)
+        return -1;
+    xspec_response(c, c->Xr, c->Xi, NULL); // 作業領域として使う
+    rfft_inverse(c->plan, c->Xr, c->Xi, c->frame);
+    memcpy(h, c->frame, sizeof(double) * taps);
+    return 0;
+}
+
+// 相互相関の最大値から遅延 [標本]（放物線補間で小数まで）を求める．探す範囲は ±max_lag（< N/2）
+// phat が非0なら |Sxy| で割って白色化する（GCC-PHAT．ピークが鋭くなり，残響や色の付いた信号に強い）
+// peak には最大値（どちらも 1 で完全に一致），corr（NULL可，長さ 2*max_lag+1）には遅延 -max_lag〜max_lag の相関を書く
+double xspec_delay(CrossSpectrum *c, int phat, int max_lag, double *peak, double *corr)
+{
+    if (max_lag >= c->N / 2)
+        max_lag = c->N / 2 - 1;
+
+    // 重みなしのときは両方のエネルギー（Parseval: Σ|X|^2/N，負の周波数の分も含める）で割って -1〜1 にする
+    double ex = 0.0, ey = 0.0;
+    for (int k = 0; k < c->bins; ++k)
+    {
+        double twice = (k == 0 || k == c->N / 2) ? 1.0 : 2.0;
+        ex += twice * c->sxx[k];
+        ey += twice * c->syy[k];
+    }
+    double energy = sqrt(ex * ey) / c->N;
+
+    for (int k = 0; k < c->bins; ++k)
+    {
+        double re = c->sxy_re[k], im = c->sxy_im[k];
+        double scale = energy > 0.0 ? 1.0 / energy : 0.0;
+        if (phat)
+        {
+            double mag = sqrt(re * re + im * im);
+            scale = mag > 1e-300 ? 1.0 / mag : 0.0;
+        }
+        c->Xr[k] = re * scale;
+        c->Xi[k] = im * scale;
+    }
+    rfft_inverse(c->plan, c->Xr, c->Xi, c->frame); // frame[d mod N] = 遅延 d の相関
+
+    int best = 0;
+    for (int d = -max_lag; d <= max_lag; ++d)
+    {
+        double v = c->frame[(d + c->N) % c->N];
+        if (corr)
+            corr[d + max_lag] = v;
+        if (v > c->frame[(best + c->N) % c->N])
+            best = d;
+    }
+
+    double y0 = c->frame[(best + c->N) % c->N];
+    double ym = c->frame[(best - 1 + c->N) % c->N], yp = c->frame[(best + 1) % c->N];
+    double denom = ym - 2.0 * y0 + yp;
+    double delta = denom < 0.0 ? 0.5 * (ym - yp) / denom : 0.0;
+    if (peak)
+        *peak = y0;
+    return best + delta;
+}
+
+#endif
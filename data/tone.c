@@ -0,0 +1,171 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "tone.h"   // Goertzel／スライディング DFT
+#include "pcm_io.h" // rawファイルの読み込み（mmap）
+#include "out_io.h" // テキスト／バイナリ出力
+
+#define SAMPLE_RATE 16000 // サンプリング周波数 [Hz]
+#define N 1024            // ブロック長／窓長（kadai3 の DFT 点数）
+#define STEP 160          // スライディング DFT の出力間隔 = 10ms
+#define MAX_TONES 256
+
+// "1000,1500.5,2000" のような周波数の並びを読む（戻り値は個数，不正なら-1）
+int parse_list(const char *s, double *out, int max)
+{
+    int n = 0;
+    while (*s)
+    {
+        char *end;
+        double v = strtod(s, &end);
+        if (end == s || n == max)
+            return -1;
+        out[n++] = v;
+        s = *end == ',' ? end + 1 : end;
+        if (*end != ',' && *end != '\0')
+            return -1;
+    }
+    return n;
+}
+
+int main(int argc, char *argv[])
+{
+    trace_args(&argc, argv); // --stats / --trace=FILE で段階ごとの計時を出す
+    int method = TONE_GOERTZEL, length = N, step = STEP, sample_rate = SAMPLE_RATE, format = OUT_TEXT;
+    double freqs[MAX_TONES];
+    int tones = 0, bins = 0; // -k ならビン番号で指定
+
+    int opt;
+    while ((opt = getopt(argc, argv, "m:f:k:n:s:r:F:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'm':
+            if ((method = tone_method_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        case 'f':
+        case 'k':
+            if ((tones = parse_list(optarg, freqs, MAX_TONES)) <= 0)
+                argc = 0;
+            bins = opt == 'k';
+            break;
+        case 'n': length = atoi(optarg); break;
+        case 's': step = atoi(optarg); break;
+        case 'r': sample_rate = atoi(optarg); break;
+        case 'F':
+            if ((format = out_format_from_name(optarg)) < 0)
+                argc = 0;
+            break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind != 2 || tones <= 0)
+    {
+        fprintf(stderr, "使い方: %s [--stats] [--trace=トレース.json] -f 周波数[Hz],... | -k ビン,... [-m goertzel|sdft] [-n ブロック長] [-s 出力間隔] [-r 標本化周波数] [-F txt|bin] <入力ファイル名.raw|-> <出力ファイル名>\n", argv[0]);
+        return 1;
+    }
+    const char *input_filename = argv[optind];
+    const char *output_filename = argv[optind + 1];
+
+    if (bins) // ビン番号 → 周波数
+        for (int i = 0; i < tones; ++i)
+            freqs[i] = freqs[i] * sample_rate / length;
+
+    ToneTracker *t = tone_create(method, freqs, tones, length, step, sample_rate);
+    if (!t)
+    {
+        fprintf(stderr, "パラメータが不正です\n");
+        return 1;
+    }
+
+    PCMData pcm;
+    if (pcm_open(input_filename, &pcm) != 0)
+    {
+        perror("入力ファイルが開けませんでした");
+        return 1;
+    }
+
+    long max_rows = tone_max_rows(t, pcm.length);
+    float *mags = (float *)malloc(sizeof(float) * max_rows * tones);
+    if (!mags)
+    {
+        perror("malloc");
+        return 1;
+    }
+
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    long rows = tone_process(t, pcm.samples, pcm.length, mags);
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+
+    // 1行 = 出力時刻 [ms]（窓の最後の標本の次）と各周波数の振幅
+    int interval = method == TONE_GOERTZEL ? length : step;
+    double dt = interval * 1000.0 / sample_rate;
+    int ret;
+    if (format == OUT_TEXT)
+    {
+        TextWriter *w = tw_open(output_filename);
+        if (!w)
+        {
+            perror("出力ファイルが開けませんでした");
+            return 1;
+        }
+        for (long r = 0; r < rows; ++r)
+        {
+            tw_fixed(w, (r + 1) * dt, 3);
+            for (int i = 0; i < tones; ++i)
+            {
+                tw_char(w, ' ');
+                tw_fixed(w, mags[r * tones + i], 3);
+            }
+            tw_char(w, '\n');
+        }
+        ret = tw_close(w);
+    }
+    else
+    {
+        ColumnWriter *c = col_open(output_filename, rows, tones, dt, dt, "ms", "amplitude");
+        float *column = (float *)malloc(sizeof(float) * (rows > 0 ? rows : 1));
+        if (!c || !column)
+        {
+            perror("出力ファイルが開けませんでした");
+            return 1;
+        }
+        for (int i = 0; i < tones; ++i) // 列ごとに並べ替えて書く
+        {
+            for (long r = 0; r < rows; ++r)
+                column[r] = mags[r * tones + i];
+            col_write(c, column, rows);
+        }
+        free(column);
+        ret = col_close(c);
+    }
+    if (ret != 0)
+    {
+        perror("出力ファイルの書き込みに失敗しました");
+        return 1;
+    }
+
+    double elapsed = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+    printf("%s の %d 周波数（%s, N=%d）を %ld 行 %s に出力しました:", input_filename, tones,
+           method == TONE_GOERTZEL ? "Goertzel" : "スライディング DFT", length, rows, output_filename);
+    for (int i = 0; i < tones; ++i)
+        printf(" %.2f", t->freq[i]);
+    printf(" Hz\n");
+    if (elapsed > 0)
+        printf("処理時間 %.3f ms（実時間の %.0f 倍）\n", elapsed * 1e3, (double)pcm.length / sample_rate / elapsed);
+
+    free(mags);
+    pcm_close(&pcm);
+    tone_destroy(t);
+    return 0;
+}
+
+// 例:
+// ./tone -k 10 sin.raw sin_tone.txt                        (kadai3 の K=10 の成分を 1024 標本ごとに)
+// ./tone -m sdft -s 1 -f 697,770,852,941,1209,1336,1477 in.raw dtmf.txt
@@ -0,0 +1,239 @@
+#ifndef TONE_H
+#define TONE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+#include "pcm_gain.h" // ベクトル型と int16 → float の一括変換
+#include "trace.h"    // 段階ごとの計時
+
+// 少数の周波数だけを追う音検出
+// 全ビンの FFT の代わりに，見たい周波数ごとに次のどちらかで振幅を求める．周波数を8本ずつベクトルの各要素に割り当て，
+// 標本ごとの更新を8本まとめて行う（見る周波数の数を T とすると 1標本あたり T/8 回のベクトル演算）．
+//   Goertzel（ブロック）: N 標本ごとに |X(ω)| を出す．ω はビンの間でもよい
+//     s[n] = x[n] + 2cos(ω)·s[n-1] - s[n-2]，|X|^2 = s1^2 + s2^2 - 2cos(ω)·s1·s2
+//   スライディング DFT: 1標本ごとに直近 N 標本の X[k] を更新する（k は整数ビン，周波数は最も近いビンに丸める）
+//     S[n] = r·e^{jω}·(S[n-1] + x[n] - r^N·x[n-N])
+//     r（1より少し小さい）を掛けて丸め誤差が溜まり続けないようにする（振幅の偏りは r^N 程度 = 0.1dB 前後）
+// 出力は正弦波の振幅に換算した 2|X|/N．
+
+#define TONE_BLOCK 4096     // 1回に変換・処理する標本数
+#define TONE_SDFT_R 0.99999 // スライディング DFT の減衰係数
+
+enum
+{
+    TONE_GOERTZEL,
+    TONE_SDFT
+};
+
+// 手法名（"goertzel", "sdft"）を種類に変換する（不明なら-1）
+int tone_method_from_name(const char *name)
+{
+    if (strcmp(name, "goertzel") == 0)
+        return TONE_GOERTZEL;
+    if (strcmp(name, "sdft") == 0)
+        return TONE_SDFT;
+    return -1;
+}
+
+typedef struct
+{
+    int method;
+    int N;          // ブロック長（Goertzel）／窓長（スライディング DFT）
+    int tones;      // 周波数の数
+    int groups;     // ベクトル数 = ceil(tones/8)
+    int step;       // スライディング DFT で何標本ごとに出力するか
+    double *freq;   // 実際に使う周波数 [Hz]（スライディング DFT ではビンに丸めた値）
+    float *coef;    // Goertzel: 2cos(ω)（長さ groups*8）
+    float *cr, *ci; // スライディング DFT: r·e^{jω}
+    float *s1, *s2; // 状態（Goertzel: s[n-1], s[n-2]，スライディング DFT: 実部・虚部）
+    float *history; // スライディング DFT: 直近 N 標本（リングバッファ）
+    float *x, *d;   // 作業領域（TONE_BLOCK）: 入力，スライディング DFT の x[n] - r^N·x[n-N]
+    float rN;       // r^N
+    long count;     // これまでに入力した標本数
+} ToneTracker;
+
+void tone_destroy(ToneTracker *t)
+{
+    if (!t)
+        return;
+    free(t->freq);
+    free(t->coef);
+    free(t->cr);
+    free(t->ci);
+    free(t->s1);
+    free(t->s2);
+    free(t->history);
+    free(t->x);
+    free(t->d);
+    free(t);
+}
+
+// freqs [Hz] の tones 本を追う検出器を作る（失敗時はNULL）
+// step はスライディング DFT の出力間隔 [標本]（Goertzel では使わない）
+ToneTracker *tone_create(int method, const double *freqs, int tones, int N, int step, int sample_rate)
+{
+    if (tones <= 0 || N <= 0 || step <= 0 || sample_rate <= 0 || method < 0)
+        return NULL;
+
+    ToneTracker *t = (ToneTracker *)calloc(1, sizeof(ToneTracker));
+    if (!t)
+        return NULL;
+    t->method = method;
+    t->N = N;
+    t->tones = tones;
+    t->groups = (tones + 7) / 8;
+    t->step = step;
+    int lanes = t->groups * 8;
+
+    t->freq = (double *)malloc(sizeof(double) * tones);
+    t->coef = (float *)calloc(lanes, sizeof(float));
+    t->cr = (float *)calloc(lanes, sizeof(float));
+    t->ci = (float *)calloc(lanes, sizeof(float));
+    t->s1 = (float *)calloc(lanes, sizeof(float));
+    t->s2 = (float *)calloc(lanes, sizeof(float));
+    t->history = (float *)calloc(N, sizeof(float));
+    t->x = (float *)malloc(sizeof(float) * TONE_BLOCK);
+    t->d = (float *)malloc(sizeof(float) * TONE_BLOCK);
+    if (!t->freq || !t->coef || !t->cr || !t->ci || !t->s1 || !t->s2 || !t->history || !t->x || !t->d)
+    {
+        tone_destroy(t);
+        return NULL;
+    }
+
+    for (int i = 0; i < tones; ++i)
+    {
+        double f = freqs[i];
+        if (method == TONE_SDFT) // スライディング DFT は整数ビンのみ
+            f = floor(f * N / sample_rate + 0.5) * sample_rate / N;
+        t->freq[i] = f;
+        double w = 2.0 * M_PI * f / sample_rate;
+        t->coef[i] = (float)(2.0 * cos(w));
+        t->cr[i] = (float)(TONE_SDFT_R * cos(w));
+        t->ci[i] = (float)(TONE_SDFT_R * sin(w));
+    }
+    t->rN = (float)pow(TONE_SDFT_R, N);
+    return t;
+}
+
+// n 標本を入力したときに出る行数の上限
+long tone_max_rows(const ToneTracker *t, long n)
+{
+    return n / (t->method == TONE_GOERTZEL ? t->N : t->step) + 1;
+}
+
+// 1ブロック分の Goertzel を全ベクトルについて進める（x は長さ n）
+void tone_goertzel_run(ToneTracker *t, const float *x, int n)
+{
+    for (int g = 0; g < t->groups; ++g)
+    {
+        pcm_v8f c, s1, s2;
+        memcpy(&c, t->coef + 8 * g, sizeof(c));
+        memcpy(&s1, t->s1 + 8 * g, sizeof(s1));
+        memcpy(&s2, t->s2 + 8 * g, sizeof(s2));
+        for (int i = 0; i < n; ++i) // 状態をレジスタに置いたまま標本を流す
+        {
+            pcm_v8f s0 = x[i] + c * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        memcpy(t->s1 + 8 * g, &s1, sizeof(s1));
+        memcpy(t->s2 + 8 * g, &s2, sizeof(s2));
+    }
+}
+
+// Goertzel のブロックを閉じて振幅を out（tones 本）に書き，状態を戻す
+void tone_goertzel_finish(ToneTracker *t, float *out)
+{
+    float scale = 2.0f / t->N;
+    for (int i = 0; i < t->tones; ++i)
+    {
+        float s1 = t->s1[i], s2 = t->s2[i];
+        float p = s1 * s1 + s2 * s2 - t->coef[i] * s1 * s2;
+        out[i] = sqrtf(p > 0.0f ? p : 0.0f) * scale;
+    }
+    memset(t->s1, 0, sizeof(float) * t->groups * 8);
+    memset(t->s2, 0, sizeof(float) * t->groups * 8);
+}
+
+// スライディング DFT を n 標本進める（t->d に差分が入っていること）．step ごとに振幅を out に書き，行数を返す
+long tone_sdft_run(ToneTracker *t, int n, float *out)
+{
+    const float scale = 2.0f / t->N;
+    long first = t->count; // t->d[0] の標本番号
+    long rows = 0;
+    for (int g = 0; g < t->groups; ++g)
+    {
+        pcm_v8f cr, ci, re, im;
+        memcpy(&cr, t->cr + 8 * g, sizeof(cr));
+        memcpy(&ci, t->ci + 8 * g, sizeof(ci));
+        memcpy(&re, t->s1 + 8 * g, sizeof(re));
+        memcpy(&im, t->s2 + 8 * g, sizeof(im));
+        int lanes = t->tones - 8 * g < 8 ? t->tones - 8 * g : 8;
+        int until = t->step - (int)(first % t->step); // 次の出力までの標本数
+        rows = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            pcm_v8f a = re + t->d[i];
+            re = cr * a - ci * im;
+            im = ci * a + cr * im;
+            if (--until == 0) // 標本 first+i で終わる窓で1行
+            {
+                until = t->step;
+                pcm_v8f m = re * re + im * im;
+                float *row = out + rows * t->tones + 8 * g;
+                for (int l = 0; l < lanes; ++l)
+                    row[l] = sqrtf(m[l]) * scale;
+                rows++;
+            }
+        }
+        memcpy(t->s1 + 8 * g, &re, sizeof(re));
+        memcpy(t->s2 + 8 * g, &im, sizeof(im));
+    }
+    return rows;
+}
+
+// n 標本を処理し，出た行（1行 = tones 本の振幅）を out に書いて行数を返す
+// out には tone_max_rows(t, n) 行分の領域が要る
+// Goertzel は N 標本ごと，スライディング DFT は入力した標本数が step の倍数になるたびに1行出す
+long tone_process(ToneTracker *t, const short *in, long n, float *out)
+{
+    TRACE_BEGIN(tr);
+    long rows = 0;
+    for (long pos = 0; pos < n;)
+    {
+        int len = n - pos < TONE_BLOCK ? (int)(n - pos) : TONE_BLOCK;
+        if (t->method == TONE_GOERTZEL) // ブロックの境目で区切る
+        {
+            int left = t->N - (int)(t->count % t->N);
+            if (len > left)
+                len = left;
+            pcm_to_float(in + pos, t->x, len);
+            tone_goertzel_run(t, t->x, len);
+            t->count += len;
+            if (t->count % t->N == 0)
+                tone_goertzel_finish(t, out + rows++ * t->tones);
+        }
+        else
+        {
+            pcm_to_float(in + pos, t->x, len);
+            int h = (int)(t->count % t->N);
+            for (int i = 0; i < len; ++i) // x[n] - r^N·x[n-N]（全ビンで共通）
+            {
+                t->d[i] = t->x[i] - t->rN * t->history[h];
+                t->history[h] = t->x[i];
+                if (++h == t->N)
+                    h = 0;
+            }
+            rows += tone_sdft_run(t, len, out + rows * t->tones);
+            t->count += len;
+        }
+        pos += len;
+    }
+    TRACE_END(tr, STAGE_FFT, n * t->tones);
+    return rows;
+}
+
+#endif
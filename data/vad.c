@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "pcm_io.h" // rawファイルの読み込み（mmap）
+#include "vad.h"    // 音声区間検出
+
+#define SAMPLE_RATE 16000 // サンプリング周波数 [Hz]
+
+// 音声区間を検出し，境界（秒）を表示するか，区間だけをつないだ音声を書き出す
+// 1回の走査で判定と書き出しを行う（区間の終わりが確定した時点でその区間を書く）
+int main(int argc, char *argv[])
+{
+    VADParams params;
+    vad_default_params(&params, SAMPLE_RATE);
+    const char *trimmed_filename = NULL, *segments_filename = NULL;
+    int frame_ms = VAD_FRAME_MS;
+
+    // オプション（mic2file の -lv, -zc, -headmargin, -tailmargin に相当するもの）
+    int opt;
+    while ((opt = getopt(argc, argv, "e:f:m:z:H:T:M:o:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'e': params.on_db = atof(optarg); break;
+        case 'f': params.off_db = atof(optarg); break;
+        case 'm': params.min_db = atof(optarg); break;
+        case 'z': params.zcr = atof(optarg); break;
+        case 'H': params.head_frames = atoi(optarg) / frame_ms; break;
+        case 'T': params.tail_frames = atoi(optarg) / frame_ms; break;
+        case 'M': params.min_frames = atoi(optarg) / frame_ms; break;
+        case 'o': trimmed_filename = optarg; break;
+        case 's': segments_filename = optarg; break;
+        default: argc = 0;
+        }
+    }
+
+    if (argc - optind != 1 || params.min_frames < 1 || params.tail_frames < 1)
+    {
+        fprintf(stderr, "使い方: %s [-e 開始しきい値[dB]] [-f 継続しきい値[dB]] [-m 最小レベル[dB]] [-z ゼロ交差[回/秒]] "
+                        "[-H 前マージン[ms]] [-T 後マージン[ms]] [-M 最短区間[ms]] [-o 区間をつないだ音声.raw] [-s 区間一覧.txt] <入力ファイル名.raw|->\n", argv[0]);
+        return 1;
+    }
+
+    PCMData pcm;
+    if (pcm_open(argv[optind], &pcm) != 0)
+    {
+        perror("入力ファイルが開けませんでした");
+        return 1;
+    }
+
+    FILE *trimmed = NULL, *segments = stdout;
+    if (trimmed_filename && !(trimmed = fopen(trimmed_filename, "wb")))
+    {
+        perror(trimmed_filename);
+        return 1;
+    }
+    if (segments_filename && !(segments = fopen(segments_filename, "w")))
+    {
+        perror(segments_filename);
+        return 1;
+    }
+    if (trimmed && !segments_filename)
+        segments = NULL; // 音声を書き出すときは区間一覧を明示したときだけ出す
+
+    VAD vad;
+    VADSegment seg;
+    vad_init(&vad, &params);
+    long kept = 0;
+    int count = 0;
+
+    for (long pos = 0;; pos += params.frame_length)
+    {
+        int event;
+        if (pos < pcm.length)
+        {
+            int n = pcm.length - pos < params.frame_length ? (int)(pcm.length - pos) : params.frame_length;
+            event = vad_push_frame(&vad, pcm.samples + pos, n, &seg);
+        }
+        else
+        {
+            event = vad_finish(&vad, pcm.length, &seg) ? VAD_END : VAD_NONE;
+        }
+
+        if (event == VAD_END)
+        {
+            if (seg.end > pcm.length)
+                seg.end = pcm.length;
+            // 区間: 開始[秒] 終了[秒]
+            if (segments)
+                fprintf(segments, "%.3f %.3f\n", (double)seg.start / SAMPLE_RATE, (double)seg.end / SAMPLE_RATE);
+            if (trimmed)
+                fwrite(pcm.samples + seg.start, sizeof(short), seg.end - seg.start, trimmed);
+            kept += seg.end - seg.start;
+            count++;
+        }
+        if (pos >= pcm.length)
+            break;
+    }
+
+    if (segments && segments != stdout)
+        fclose(segments);
+    if (trimmed)
+        fclose(trimmed);
+
+    fprintf(stderr, "%d 区間, %.2f / %.2f 秒（%.0f%%）を音声区間として残しました\n", count,
+            (double)kept / SAMPLE_RATE, (double)pcm.length / SAMPLE_RATE, pcm.length ? 100.0 * kept / pcm.length : 0.0);
+    pcm_close(&pcm);
+    return 0;
+}
+
+// 例:
+// ./vad a00.raw
+// ./vad -o sentence1_voiced.raw ../data3/sentence1.raw && ./stft sentence1_voiced.raw sentence1_voiced.bin
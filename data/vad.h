@@ -0,0 +1,213 @@
+#ifndef VAD_H
+#define VAD_H
+
+#include <math.h>
+#include <string.h>
+
+#include "pcm_gain.h" // ベクトル型
+
+// 逐次処理の音声区間検出（VAD）
+// 10ms ごとのフレームのエネルギーとゼロ交差数から音声らしさを判定し，
+// 開始・継続で異なるしきい値（ヒステリシス）と前後のマージンを付けて区間の境界を出す．
+// しきい値は雑音レベル（無音中に追従する推定値）からの相対値 [dB] で与える．
+
+#define VAD_FRAME_MS 10
+#define VAD_FLOOR_RISE_DB 0.01 // 雑音レベル推定が1フレームに上がる最大量 [dB]
+
+typedef struct
+{
+    int frame_length;   // フレーム長 [標本]
+    double on_db;       // 区間を始めるエネルギー（雑音レベル + on_db）
+    double off_db;      // 区間を続けるエネルギー（雑音レベル + off_db）
+    double min_db;      // これより小さいフレームは常に無音 [dB]
+    double zcr;         // 無声子音とみなすゼロ交差数 [回/秒]（0なら使わない）
+    int min_frames;     // 区間を始めるのに必要な連続フレーム数
+    int head_frames;    // 区間の前に付けるマージン [フレーム]
+    int tail_frames;    // 区間の後に付けるマージン（＝終了判定の待ち）[フレーム]
+    int sample_rate;
+} VADParams;
+
+typedef struct
+{
+    long start, end; // 標本番号（end は含まない）
+} VADSegment;
+
+enum
+{
+    VAD_NONE,
+    VAD_START, // 区間が始まった（start が確定）
+    VAD_END    // 区間が終わった（start, end が確定）
+};
+
+typedef struct
+{
+    VADParams p;
+    long frame;        // 処理したフレーム数
+    double floor_db;   // 雑音レベルの推定値
+    int has_floor;     // floor_db が決まったか（最初のフレームで初期化する）
+    int in_speech;
+    int run;           // 連続した有音（無音中）／無音（区間中）フレーム数
+    long run_start;    // 有音が続き始めたフレーム
+    long last_active;  // 区間中で最後に有音だったフレーム
+    long prev_end;     // 直前の区間の終わり [標本]
+    VADSegment current;
+    short prev_sample; // ゼロ交差の判定で前のフレームから引き継ぐ標本
+} VAD;
+
+void vad_default_params(VADParams *p, int sample_rate)
+{
+    p->sample_rate = sample_rate;
+    p->frame_length = sample_rate * VAD_FRAME_MS / 1000;
+    p->on_db = 15.0;
+    p->off_db = 8.0;
+    p->min_db = 25.0;
+    p->zcr = 3000.0;
+    p->min_frames = 3;
+    p->head_frames = 10;
+    p->tail_frames = 15;
+}
+
+void vad_init(VAD *v, const VADParams *p)
+{
+    memset(v, 0, sizeof(*v));
+    v->p = *p;
+}
+
+// 1フレームの平均二乗エネルギー [dB] とゼロ交差数を8標本ずつ求める
+double vad_frame_stats(const short *x, int n, short prev, int *zero_crossings)
+{
+    pcm_v8f acc = {0};
+    pcm_v8i zc = {0};
+    int i = 0, z = (n > 0) && ((x[0] < 0) != (prev < 0));
+    double sumsq = n > 0 ? (double)x[0] * x[0] : 0.0;
+
+    for (i = 1; i + 8 <= n; i += 8)
+    {
+        pcm_v8s a, b;
+        memcpy(&a, x + i, sizeof(a));
+        memcpy(&b, x + i - 1, sizeof(b));
+        pcm_v8i ai = __builtin_convertvector(a, pcm_v8i);
+        pcm_v8i bi = __builtin_convertvector(b, pcm_v8i);
+        pcm_v8f f = __builtin_convertvector(ai, pcm_v8f);
+        acc += f * f;
+        zc -= (ai < 0) ^ (bi < 0); // 比較結果は真なら -1
+    }
+    for (int k = 0; k < 8; ++k)
+    {
+        sumsq += acc[k];
+        z += zc[k];
+    }
+    for (; i < n; ++i)
+    {
+        sumsq += (double)x[i] * x[i];
+        z += (x[i] < 0) != (x[i - 1] < 0);
+    }
+
+    *zero_crossings = z;
+    return 10.0 * log10(sumsq / (n > 0 ? n : 1) + 1e-9);
+}
+
+// 1フレーム（frame_length 標本，末尾だけ短くてよい）を与えて状態を進める
+// 区間の開始・終了が確定したら VAD_START / VAD_END を返し，seg に境界を入れる
+int vad_push_frame(VAD *v, const short *x, int n, VADSegment *seg)
+{
+    const VADParams *p = &v->p;
+    int zc;
+    double e = vad_frame_stats(x, n, v->prev_sample, &zc);
+    if (n > 0)
+        v->prev_sample = x[n - 1];
+    long f = v->frame++;
+
+    // デジタル無音のフレームは -90 dB になるので，floor_db の値を未初期化の印には使えない
+    if (!v->has_floor)
+    {
+        v->floor_db = e;
+        v->has_floor = 1;
+    }
+
+    int event = VAD_NONE;
+    double zcr = (double)zc * p->sample_rate / (n > 0 ? n : 1);
+
+    if (!v->in_speech)
+    {
+        int active = e >= p->min_db &&
+                     (e >= v->floor_db + p->on_db || (p->zcr > 0.0 && zcr >= p->zcr && e >= v->floor_db + p->off_db));
+        if (active)
+        {
+            if (v->run++ == 0)
+                v->run_start = f;
+            if (v->run >= p->min_frames)
+            {
+                long start = (v->run_start - p->head_frames) * p->frame_length;
+                v->current.start = start > v->prev_end ? start : v->prev_end;
+                v->in_speech = 1;
+                v->last_active = f;
+                v->run = 0;
+                *seg = v->current;
+                event = VAD_START;
+            }
+        }
+        else
+        {
+            v->run = 0;
+            // 無音中だけ雑音レベルを追う（下がるときはすぐ，上がるときはゆっくり）
+            if (e < v->floor_db)
+                v->floor_db = e;
+            else
+                v->floor_db += fmin(e - v->floor_db, VAD_FLOOR_RISE_DB);
+        }
+    }
+    else
+    {
+        if (e >= p->min_db && e >= v->floor_db + p->off_db)
+        {
+            v->last_active = f;
+            v->run = 0;
+        }
+        else if (++v->run >= p->tail_frames)
+        {
+            v->current.end = (v->last_active + 1 + p->tail_frames) * p->frame_length;
+            v->prev_end = v->current.end;
+            v->in_speech = 0;
+            v->run = 0;
+            *seg = v->current;
+            event = VAD_END;
+        }
+    }
+    return event;
+}
+
+// 入力の終わり（total 標本）で区間を閉じる．閉じる区間があれば1
+int vad_finish(VAD *v, long total, VADSegment *seg)
+{
+    if (!v->in_speech)
+        return 0;
+    long end = (v->last_active + 1 + v->p.tail_frames) * v->p.frame_length;
+    v->current.end = end < total ? end : total;
+    v->in_speech = 0;
+    *seg = v->current;
+    return 1;
+}
+
+// 録音全体の区間を検出して segs に入れる（最大 max 個，戻り値は区間数）
+int vad_segments(const VADParams *p, const short *samples, long length, VADSegment *segs, int max)
+{
+    VAD v;
+    VADSegment seg;
+    int count = 0;
+    vad_init(&v, p);
+    for (long pos = 0; pos < length; pos += p->frame_length)
+    {
+        int n = length - pos < p->frame_length ? (int)(length - pos) : p->frame_length;
+        if (vad_push_frame(&v, samples + pos, n, &seg) == VAD_END && count < max)
+            segs[count++] = seg;
+    }
+    if (vad_finish(&v, length, &seg) && count < max)
+        segs[count++] = seg;
+    for (int i = 0; i < count; ++i) // マージンが録音の外に出た分を切る
+        if (segs[i].end > length)
+            segs[i].end = length;
+    return count;
+}
+
+#endif
@@ -0,0 +1,311 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "vowel_rec.h" // ケプストラム特徴量とテンプレートモデル
+
+#define BENCH_SECONDS 0.5 // ベンチマーク1項目あたりの計測時間 [秒]
+
+const char *VOWELS = "aiueo";
+
+double now_sec(void)
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// ファイル名（例: data2/f01a1.raw）から話者 "f01" と母音 'a' を取り出す（母音がなければ'?'）
+VowelLabel label_from_filename(const char *path)
+{
+    VowelLabel label;
+    memset(&label, 0, sizeof(label));
+    label.vowel = '?';
+
+    const char *base = strrchr(path, '/');
+    base = base ? base + 1 : path;
+    size_t len = strcspn(base, ".");
+    for (size_t i = len; i-- > 0;) // 最後に現れる母音の文字を探す
+    {
+        if (strchr(VOWELS, base[i]))
+        {
+            label.vowel = base[i];
+            size_t n = i < sizeof(label.speaker) - 1 ? i : sizeof(label.speaker) - 1;
+            memcpy(label.speaker, base, n);
+            break;
+        }
+    }
+    return label;
+}
+
+// ファイル一覧から特徴量を求めてモデルにする（読めないファイルは除く）
+VowelModel *extract_all(VowelFeatureExtractor *e, const RawFileList *files)
+{
+    VowelModel *m = vowel_model_alloc(files->count);
+    if (!m)
+        return NULL;
+
+    int n = 0;
+    for (int i = 0; i < files->count; ++i)
+    {
+        PCMData pcm;
+        if (pcm_open(files->paths[i], &pcm) != 0)
+        {
+            perror(files->paths[i]);
+            continue;
+        }
+        if (vowel_file_features(e, pcm.samples, pcm.length, m->features + (long)n * VOWEL_DIM) == 0)
+        {
+            m->labels[n] = label_from_filename(files->paths[i]);
+            n++;
+        }
+        else
+        {
+            fprintf(stderr, "%s: 短すぎるため除外しました\n", files->paths[i]);
+        }
+        pcm_close(&pcm);
+    }
+    m->count = n;
+    return m;
+}
+
+int cmd_build(VowelFeatureExtractor *e, const char *model_file, RawFileList *files)
+{
+    VowelModel *m = extract_all(e, files);
+    if (!m)
+        return 1;
+    if (vowel_model_save(m, model_file) != 0)
+    {
+        perror(model_file);
+        vowel_model_free(m);
+        return 1;
+    }
+    printf("%d 個のテンプレートを %s に保存しました。\n", m->count, model_file);
+    vowel_model_free(m);
+    return 0;
+}
+
+int cmd_classify(VowelFeatureExtractor *e, const char *model_file, RawFileList *files)
+{
+    VowelModel *m = vowel_model_load(model_file);
+    if (!m || m->count == 0)
+    {
+        fprintf(stderr, "モデルを読み込めません: %s\n", model_file);
+        return 1;
+    }
+
+    float feature[VOWEL_DIM];
+    for (int i = 0; i < files->count; ++i)
+    {
+        PCMData pcm;
+        if (pcm_open(files->paths[i], &pcm) != 0)
+        {
+            perror(files->paths[i]);
+            continue;
+        }
+        if (vowel_file_features(e, pcm.samples, pcm.length, feature) != 0)
+        {
+            fprintf(stderr, "%s: 短すぎるため認識できません\n", files->paths[i]);
+            pcm_close(&pcm);
+            continue;
+        }
+        int best = vowel_nearest(m, feature, NULL);
+        printf("%s %c (%s)\n", files->paths[i], m->labels[best].vowel, m->labels[best].speaker);
+        pcm_close(&pcm);
+    }
+    vowel_model_free(m);
+    return 0;
+}
+
+// 話者を1人ずつ外して残りのテンプレートで認識する（leave-one-speaker-out）
+int cmd_eval(VowelFeatureExtractor *e, RawFileList *files)
+{
+    VowelModel *m = extract_all(e, files);
+    if (!m)
+        return 1;
+
+    int total = 0, correct = 0;
+    int confusion[5][5] = {{0}}; // [正解][認識結果]
+    for (int s = 0; s < m->count; ++s)
+    {
+        const char *speaker = m->labels[s].speaker;
+        int seen = 0;
+        for (int j = 0; j < s; ++j)
+            seen |= strcmp(m->labels[j].speaker, speaker) == 0;
+        if (seen)
+            continue;
+
+        int n = 0, ok = 0;
+        for (int i = 0; i < m->count; ++i)
+        {
+            if (strcmp(m->labels[i].speaker, speaker) != 0 || m->labels[i].vowel == '?')
+                continue;
+            int best = vowel_nearest(m, m->features + (long)i * VOWEL_DIM, speaker);
+            if (best < 0)
+                continue;
+            char truth = m->labels[i].vowel, result = m->labels[best].vowel;
+            if (strchr(VOWELS, result))
+                confusion[strchr(VOWELS, truth) - VOWELS][strchr(VOWELS, result) - VOWELS]++;
+            n++;
+            ok += (truth == result);
+        }
+        if (n > 0)
+            printf("話者 %-4s: %2d / %2d 正解 (%.1f%%)\n", speaker[0] ? speaker : "-", ok, n, 100.0 * ok / n);
+        total += n;
+        correct += ok;
+    }
+
+    printf("\n正解＼認識  a   i   u   e   o\n");
+    for (int t = 0; t < 5; ++t)
+    {
+        printf("     %c    ", VOWELS[t]);
+        for (int r = 0; r < 5; ++r)
+            printf("%4d", confusion[t][r]);
+        printf("\n");
+    }
+    if (total > 0)
+        printf("\n全体: %d / %d 正解 (%.1f%%)\n", correct, total, 100.0 * correct / total);
+
+    vowel_model_free(m);
+    return 0;
+}
+
+// 認識速度の計測（テンプレート探索のみ / フレーム特徴抽出＋探索）
+int cmd_bench(VowelFeatureExtractor *e, const char *model_file, RawFileList *files)
+{
+    VowelModel *m = vowel_model_load(model_file);
+    if (!m || m->count == 0)
+    {
+        fprintf(stderr, "モデルを読み込めません: %s\n", model_file);
+        return 1;
+    }
+
+    // 問い合わせ用のフレーム（入力ファイルがなければモデルの音声特徴量を使う）
+    PCMData pcm = {0};
+    if (files->count > 0 && pcm_open(files->paths[0], &pcm) != 0)
+        perror(files->paths[0]);
+    const short *samples = pcm.samples;
+    long length = pcm.length;
+
+    float feature[VOWEL_DIM];
+    memcpy(feature, m->features, sizeof(feature));
+    volatile int sink = 0;
+
+    // 1. SIMD距離によるテンプレート探索
+    long iters = 0;
+    double t0 = now_sec(), t1;
+    do
+    {
+        for (int r = 0; r < 1000; ++r)
+        {
+            feature[r % VOWEL_NUM_CEPS] += 1e-6f;
+            sink += vowel_nearest(m, feature, NULL);
+        }
+        iters += 1000;
+    } while ((t1 = now_sec()) - t0 < BENCH_SECONDS);
+    double simd_rate = iters / (t1 - t0);
+
+    // 2. 逐次版の距離による探索（比較用）
+    iters = 0;
+    t0 = now_sec();
+    do
+    {
+        for (int r = 0; r < 1000; ++r)
+        {
+            feature[r % VOWEL_NUM_CEPS] += 1e-6f;
+            int best = 0;
+            float best_d = vowel_distance_scalar(m->features, feature);
+            for (int i = 1; i < m->count; ++i)
+            {
+                float d = vowel_distance_scalar(m->features + (long)i * VOWEL_DIM, feature);
+                if (d < best_d)
+                {
+                    best = i;
+                    best_d = d;
+                }
+            }
+            sink += best;
+        }
+        iters += 1000;
+    } while ((t1 = now_sec()) - t0 < BENCH_SECONDS);
+    double scalar_rate = iters / (t1 - t0);
+
+    printf("テンプレート数 %d, 特徴量 %d 次元\n", m->count, VOWEL_NUM_CEPS);
+    printf("探索のみ (SIMD)  : %12.0f 回/秒\n", simd_rate);
+    printf("探索のみ (逐次)  : %12.0f 回/秒\n", scalar_rate);
+
+    // 3. フレーム単位の認識（窓掛け・FFT・ケプストラム・探索）
+    if (samples && length >= VOWEL_FRAME_LENGTH)
+    {
+        double buf[VOWEL_FRAME_LENGTH];
+        long frames = (length - VOWEL_FRAME_LENGTH) / VOWEL_HOP + 1;
+        iters = 0;
+        t0 = now_sec();
+        do
+        {
+            for (long f = 0; f < frames; ++f)
+            {
+                const short *src = samples + f * VOWEL_HOP;
+                for (int n = 0; n < VOWEL_FRAME_LENGTH; ++n)
+                    buf[n] = (double)src[n];
+                vowel_frame_features(e, buf, feature);
+                sink += vowel_nearest(m, feature, NULL);
+            }
+            iters += frames;
+        } while ((t1 = now_sec()) - t0 < BENCH_SECONDS);
+        double rate = iters / (t1 - t0);
+        printf("フレーム認識     : %12.0f フレーム/秒（実時間の %.0f 倍）\n",
+               rate, rate * VOWEL_HOP / 16000.0);
+    }
+
+    pcm_close(&pcm);
+    vowel_model_free(m);
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "使い方:\n"
+                        "  %s build <モデル.bin> <入力ファイル/ディレクトリ ...>\n"
+                        "  %s classify <モデル.bin> <入力ファイル/ディレクトリ ...>\n"
+                        "  %s eval <入力ファイル/ディレクトリ ...>\n"
+                        "  %s bench <モデル.bin> [入力ファイル]\n",
+                argv[0], argv[0], argv[0], argv[0]);
+        return 1;
+    }
+
+    const char *cmd = argv[1];
+    int first_input = strcmp(cmd, "eval") == 0 ? 2 : 3;
+    RawFileList files = {0};
+    for (int i = first_input; i < argc; ++i)
+        raw_list_collect(&files, argv[i]);
+
+    VowelFeatureExtractor *e = vowel_extractor_create();
+    if (!e)
+    {
+        fprintf(stderr, "特徴抽出器の作成に失敗しました\n");
+        return 1;
+    }
+
+    int ret;
+    if (strcmp(cmd, "build") == 0)
+        ret = cmd_build(e, argv[2], &files);
+    else if (strcmp(cmd, "classify") == 0)
+        ret = cmd_classify(e, argv[2], &files);
+    else if (strcmp(cmd, "eval") == 0)
+        ret = cmd_eval(e, &files);
+    else if (strcmp(cmd, "bench") == 0)
+        ret = cmd_bench(e, argv[2], &files);
+    else
+    {
+        fprintf(stderr, "不明なコマンド: %s\n", cmd);
+        ret = 1;
+    }
+
+    vowel_extractor_destroy(e);
+    raw_list_free(&files);
+    return ret;
+}
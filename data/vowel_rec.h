@@ -0,0 +1,302 @@
+#ifndef VOWEL_REC_H
+#define VOWEL_REC_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#include "stft.h" // 窓掛け・実数FFT・対数パワースペクトル
+
+// 母音認識の特徴量（ケプストラム）とテンプレートモデル
+//
+// 特徴量は kadai4 と同じ対数パワースペクトル（20msハミング窓，1024点FFT）を
+// 逆フーリエ変換した低次ケプストラム c[1]〜c[NUM_CEPS] で，声道の形（フォルマント）を表す．
+// c[0]（全体の音量）は使わないので録音レベルに依存しない．
+
+#define VOWEL_FRAME_LENGTH 320 // フレーム長 = 20ms
+#define VOWEL_HOP 160          // フレームシフト = 10ms
+#define VOWEL_FFT_SIZE 1024    // FFT点数
+#define VOWEL_NUM_CEPS 16      // ケプストラム次数
+#define VOWEL_DIM 16           // 特徴量の格納次元（SIMD幅8の倍数）
+#define VOWEL_ENERGY_RANGE 15.0 // 最大フレームからこの範囲[dB]内のフレームを有声区間とみなす
+#define VOWEL_MODEL_MAGIC "VOWL"
+
+#if VOWEL_DIM % 8 != 0 || VOWEL_DIM < VOWEL_NUM_CEPS
+#error "VOWEL_DIM must be a multiple of 8 and at least VOWEL_NUM_CEPS"
+#endif
+
+// 特徴抽出器（FFTプラン・窓係数・ケプストラム変換行列を一度だけ用意する）
+typedef struct
+{
+    STFT *stft;
+    double *cos_table; // VOWEL_NUM_CEPS × bins の変換行列
+    double *energy;    // フレームごとの対数パワー（ファイル単位の処理用）
+    float *frames;     // フレームごとの特徴量（ファイル単位の処理用）
+    int capacity;      // energy/framesに格納できるフレーム数
+} VowelFeatureExtractor;
+
+void vowel_extractor_destroy(VowelFeatureExtractor *e)
+{
+    if (!e)
+        return;
+    stft_destroy(e->stft);
+    free(e->cos_table);
+    free(e->energy);
+    free(e->frames);
+    free(e);
+}
+
+VowelFeatureExtractor *vowel_extractor_create(void)
+{
+    VowelFeatureExtractor *e = (VowelFeatureExtractor *)calloc(1, sizeof(VowelFeatureExtractor));
+    if (!e)
+        return NULL;
+    e->stft = stft_create(VOWEL_FRAME_LENGTH, VOWEL_HOP, VOWEL_FFT_SIZE, WINDOW_HAMMING);
+    if (!e->stft)
+    {
+        vowel_extractor_destroy(e);
+        return NULL;
+    }
+
+    int bins = e->stft->bins;
+    e->cos_table = (double *)malloc(sizeof(double) * VOWEL_NUM_CEPS * bins);
+    if (!e->cos_table)
+    {
+        vowel_extractor_destroy(e);
+        return NULL;
+    }
+
+    // 対数パワースペクトルは偶対称なので，逆DFTは非負周波数のコサイン和で書ける
+    // c[q] = (1/N) Σ a_k L[k] cos(2πkq/N)，a_k = 1（k=0, N/2），2（それ以外）
+    for (int q = 0; q < VOWEL_NUM_CEPS; ++q)
+    {
+        for (int k = 0; k < bins; ++k)
+        {
+            double a = (k == 0 || k == bins - 1) ? 1.0 : 2.0;
+            e->cos_table[q * bins + k] = a * cos(2.0 * M_PI * k * (q + 1) / VOWEL_FFT_SIZE) / VOWEL_FFT_SIZE;
+        }
+    }
+    return e;
+}
+
+// 1フレーム（VOWEL_FRAME_LENGTH標本）の特徴量をfeature（VOWEL_DIM要素）に求め，フレームの対数パワー[dB]を返す
+double vowel_frame_features(VowelFeatureExtractor *e, const double *samples, float *feature)
+{
+    STFT *s = e->stft;
+    stft_analyze(s, samples);
+
+    double energy = 0.0;
+    for (int k = 0; k < s->bins; ++k)
+        energy += s->Xr[k] * s->Xr[k] + s->Xi[k] * s->Xi[k];
+
+    for (int q = 0; q < VOWEL_NUM_CEPS; ++q)
+    {
+        const double *row = e->cos_table + q * s->bins;
+        double c = 0.0;
+        for (int k = 0; k < s->bins; ++k)
+            c += row[k] * s->log_power[k];
+        feature[q] = (float)c;
+    }
+    for (int q = VOWEL_NUM_CEPS; q < VOWEL_DIM; ++q)
+        feature[q] = 0.0f;
+
+    return 10.0 * log10(energy + 1e-12);
+}
+
+// 録音全体（samples, length標本）から有声区間のフレーム平均の特徴量を求める（フレームがなければ-1）
+int vowel_file_features(VowelFeatureExtractor *e, const short *samples, long length, float *feature)
+{
+    if (length < VOWEL_FRAME_LENGTH)
+        return -1;
+    int frames = (int)((length - VOWEL_FRAME_LENGTH) / VOWEL_HOP + 1);
+
+    if (frames > e->capacity)
+    {
+        free(e->energy);
+        free(e->frames);
+        e->energy = (double *)malloc(sizeof(double) * frames);
+        e->frames = (float *)malloc(sizeof(float) * VOWEL_DIM * frames);
+        e->capacity = (e->energy && e->frames) ? frames : 0;
+        if (!e->capacity)
+            return -1;
+    }
+
+    double buf[VOWEL_FRAME_LENGTH];
+    double max_energy = -1e300;
+    for (int f = 0; f < frames; ++f)
+    {
+        const short *src = samples + (long)f * VOWEL_HOP;
+        for (int n = 0; n < VOWEL_FRAME_LENGTH; ++n)
+            buf[n] = (double)src[n];
+        e->energy[f] = vowel_frame_features(e, buf, e->frames + (long)f * VOWEL_DIM);
+        if (e->energy[f] > max_energy)
+            max_energy = e->energy[f];
+    }
+
+    double sum[VOWEL_DIM] = {0};
+    int used = 0;
+    for (int f = 0; f < frames; ++f)
+    {
+        if (e->energy[f] < max_energy - VOWEL_ENERGY_RANGE)
+            continue;
+        for (int q = 0; q < VOWEL_DIM; ++q)
+            sum[q] += e->frames[(long)f * VOWEL_DIM + q];
+        used++;
+    }
+    for (int q = 0; q < VOWEL_DIM; ++q)
+        feature[q] = (float)(sum[q] / used);
+    return 0;
+}
+
+// テンプレートモデル
+// ファイル形式: VowelModelHeader，VowelLabel × count，float32特徴量 × count × dim
+typedef struct
+{
+    char magic[4];        // "VOWL"
+    int32_t dim;          // 特徴量の格納次元
+    int32_t count;        // テンプレート数
+    int32_t frame_length; // 特徴抽出の条件（読み込み時に照合する）
+    int32_t hop;
+    int32_t fft_size;
+    int32_t num_ceps;
+} VowelModelHeader;
+
+typedef struct
+{
+    char vowel;       // 'a', 'i', 'u', 'e', 'o'
+    char speaker[15]; // 話者名（例: "f01"）
+} VowelLabel;
+
+typedef struct
+{
+    int count;
+    VowelLabel *labels;
+    float *features; // 32バイト境界に揃えた count × VOWEL_DIM
+} VowelModel;
+
+VowelModel *vowel_model_alloc(int count)
+{
+    VowelModel *m = (VowelModel *)calloc(1, sizeof(VowelModel));
+    if (!m)
+        return NULL;
+    m->count = count;
+    m->labels = (VowelLabel *)calloc(count > 0 ? count : 1, sizeof(VowelLabel));
+    m->features = (float *)aligned_alloc(32, sizeof(float) * VOWEL_DIM * (count > 0 ? count : 1));
+    if (!m->labels || !m->features)
+    {
+        free(m->labels);
+        free(m->features);
+        free(m);
+        return NULL;
+    }
+    return m;
+}
+
+void vowel_model_free(VowelModel *m)
+{
+    if (!m)
+        return;
+    free(m->labels);
+    free(m->features);
+    free(m);
+}
+
+int vowel_model_save(const VowelModel *m, const char *filename)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (!fp)
+        return -1;
+
+    VowelModelHeader h;
+    memcpy(h.magic, VOWEL_MODEL_MAGIC, 4);
+    h.dim = VOWEL_DIM;
+    h.count = m->count;
+    h.frame_length = VOWEL_FRAME_LENGTH;
+    h.hop = VOWEL_HOP;
+    h.fft_size = VOWEL_FFT_SIZE;
+    h.num_ceps = VOWEL_NUM_CEPS;
+
+    int ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+             fwrite(m->labels, sizeof(VowelLabel), m->count, fp) == (size_t)m->count &&
+             fwrite(m->features, sizeof(float) * VOWEL_DIM, m->count, fp) == (size_t)m->count;
+    return (fclose(fp) == 0 && ok) ? 0 : -1;
+}
+
+// モデルを読み込む（形式や特徴抽出の条件が違えばNULL）
+VowelModel *vowel_model_load(const char *filename)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (!fp)
+        return NULL;
+
+    VowelModelHeader h;
+    if (fread(&h, sizeof(h), 1, fp) != 1 || memcmp(h.magic, VOWEL_MODEL_MAGIC, 4) != 0 ||
+        h.dim != VOWEL_DIM || h.frame_length != VOWEL_FRAME_LENGTH || h.hop != VOWEL_HOP ||
+        h.fft_size != VOWEL_FFT_SIZE || h.num_ceps != VOWEL_NUM_CEPS || h.count < 0)
+    {
+        fclose(fp);
+        return NULL;
+    }
+
+    VowelModel *m = vowel_model_alloc(h.count);
+    if (m && (fread(m->labels, sizeof(VowelLabel), h.count, fp) != (size_t)h.count ||
+              fread(m->features, sizeof(float) * VOWEL_DIM, h.count, fp) != (size_t)h.count))
+    {
+        vowel_model_free(m);
+        m = NULL;
+    }
+    fclose(fp);
+    return m;
+}
+
+// 二乗ユークリッド距離（GCC/Clangのベクトル拡張で8要素ずつ計算する）
+typedef float vowel_v8f __attribute__((vector_size(32)));
+
+float vowel_distance(const float *a, const float *b)
+{
+    vowel_v8f acc = {0};
+    for (int i = 0; i < VOWEL_DIM; i += 8)
+    {
+        vowel_v8f va, vb;
+        memcpy(&va, a + i, sizeof(va)); // 境界の揃っていない読み込み
+        memcpy(&vb, b + i, sizeof(vb));
+        vowel_v8f d = va - vb;
+        acc += d * d;
+    }
+    return acc[0] + acc[1] + acc[2] + acc[3] + acc[4] + acc[5] + acc[6] + acc[7];
+}
+
+// 比較用の逐次版
+float vowel_distance_scalar(const float *a, const float *b)
+{
+    float sum = 0.0f;
+    for (int i = 0; i < VOWEL_DIM; ++i)
+    {
+        float d = a[i] - b[i];
+        sum += d * d;
+    }
+    return sum;
+}
+
+// 最も近いテンプレートの番号を返す（skip_speakerが非NULLならその話者のテンプレートを除く）
+int vowel_nearest(const VowelModel *m, const float *feature, const char *skip_speaker)
+{
+    int best = -1;
+    float best_d = 0.0f;
+    for (int i = 0; i < m->count; ++i)
+    {
+        if (skip_speaker && strcmp(m->labels[i].speaker, skip_speaker) == 0)
+            continue;
+        float d = vowel_distance(m->features + (long)i * VOWEL_DIM, feature);
+        if (best < 0 || d < best_d)
+        {
+            best = i;
+            best_d = d;
+        }
+    }
+    return best;
+}
+
+#endif